@@ -14,11 +14,23 @@
 int VOICES = MAX_VOICES;
 
 #include "RDX_PresetManager.h"
+#include "RDX_AudioConfig.h"
 
 #include "RDX_Synth.h"
 #include "RDX_Midi.h"
 #include "src/i2s/i2s_in_out.h"
 #include "RDX_FX.h"
+#include "RDX_AudioIn.h"
+#include "RDX_Power.h"
+#include "RDX_Profiler.h"
+#include "RDX_BlockTimer.h"
+#include "RDX_Log.h"
+#include "RDX_Trace.h"
+#include "RDX_Meter.h"
+#include "RDX_MemStat.h"
+#ifdef DEBUG_BENCH
+#include "RDX_Bench.h"
+#endif
 
 #include "controls.h"
 
@@ -30,13 +42,8 @@ int VOICES = MAX_VOICES;
 
 constexpr char* TAG = "RDX";
 
-float DRAM_ATTR outL[DMA_BUFFER_LEN];
-float DRAM_ATTR outR[DMA_BUFFER_LEN];
-
-// debug
-volatile int time1, time2 = 0;
-uint32_t audioWM = 0, midiWM = 0, guiWM = 0;
-float rmsL = 0.f, rmsR = 0.f; 
+float DRAM_ATTR outL[MAX_BLOCK_LEN];
+float DRAM_ATTR outR[MAX_BLOCK_LEN];
 
 RDX_Synth synth;
 I2S_Audio audio;
@@ -46,10 +53,20 @@ PresetManager pm;
 TaskHandle_t audioTaskHandle;
 TaskHandle_t midiTaskHandle;
 TaskHandle_t guiTaskHandle = nullptr;
+TaskHandle_t logTaskHandle;
  
 
 static FXHost fx;
 
+#if AUDIO_INPUT != AUDIO_IN_NONE
+  #ifdef AUDIO_INPUT_FILE
+    static FileAudioIn fileIn;
+    static RDX_AudioIn* audioIn = &fileIn;
+  #else
+    static I2SAudioIn i2sIn(audio);
+    static RDX_AudioIn* audioIn = &i2sIn;
+  #endif
+#endif
 
 #ifdef ENABLE_GUI
     #include "RDX_GUI.h"
@@ -63,20 +80,52 @@ static void IRAM_ATTR audioTask(void*) {
     vTaskDelay(30);
     ESP_LOGI(TAG, "Starting Audio task");
     vTaskDelay(50); 
+    const uint32_t len = RDX_AudioConfig::get().blockLen;
+    RDX_Power& power = RDX_Power::get();
+    RDX_BlockTimer& blockTimer = RDX_BlockTimer::get();
     while (true) {
-        uint32_t start = micros();
+#if AUDIO_INPUT != AUDIO_IN_NONE
+        const int16_t* in = audioIn->acquire(len); // RX DMA buffer just filled, clock-locked to the output
+#endif
+        int16_t* dma = audio.acquireOutputBuffer(); // DMA buffer that just played (zero-copy), nullptr otherwise
+
+        if (power.isIdle()) {   // nothing sounding, tails decayed: silence out, no synth, no FX
+            if (dma) {
+                memset(dma, 0, len * 2 * sizeof(int16_t));
+            } else {
+                memset(outL, 0, len * sizeof(float));
+                memset(outR, 0, len * sizeof(float));
+                audio.writeBuffers(outL, outR);
+            }
+            RDX_TRACE_IDLE();
+            continue;
+        }
 
-        synth.renderAudioBlock(outL, outR); 
-        
-        uint32_t end = micros();
+        const uint32_t blockStart = blockTimer.start();   // always on: telemetry's block times and xruns
+        RDX_PROF_BLOCK_START();
+        RDX_TRACE_BLOCK_START();
+
+#if AUDIO_INPUT != AUDIO_IN_FX
+        synth.renderAudioBlock(outL, outR, len); 
+#endif
+        RDX_TRACE_SYNTH_DONE();
+#if AUDIO_INPUT != AUDIO_IN_NONE
+        pcm16ToFloat(in, outL, outR, len, AUDIO_INPUT == AUDIO_IN_MIX); // into the same block the FX chain works on
+#endif
 
-        time1 = end - start; 
+		fx.process(outL, outR, dma);   // the last stage also writes the PCM
 
-		fx.process(outL, outR );
+        RDX_PROF_BLOCK_END();
+        blockTimer.end(blockStart, RDX_PROF_OVERHEAD());
+        RDX_TRACE_BLOCK_END(synth.activeVoices());
+        RDX_Meter::get().blockDone(outL, outR, len);    // out tap and publish, while someone reads levels
 
-        time2 = micros() - end;
+        if (!dma) {
+            RDX_PROF_SCOPE(PROF_I2S);
+            audio.writeBuffers(outL, outR);
+        }
 
-        audio.writeBuffers(outL, outR);
+        power.blockDone(outL, outR, len, synth);  // silence detection, wake-up measurement
         
     }
 }
@@ -84,32 +133,49 @@ static void IRAM_ATTR audioTask(void*) {
 
 // ------------------- MIDI Task ------------------------
 static void IRAM_ATTR midiTask(void*) {
-    const int budgetMicros = 1e+06f * DMA_BUFFER_LEN / SAMPLE_RATE ;
     vTaskDelay(40);
     ESP_LOGI(TAG, "Starting MIDI task");
     vTaskDelay(40);
-    int d = 0;
+    uint32_t reportMs = millis();
+    RDX_Power& power = RDX_Power::get();
     while (true) {
-        processMidi();   // incoming messages
-        vTaskDelay(1);
+        power.pause();   // until MIDI input or an input edge, at most MIDI_SERVICE_MS (longer while idle)
+        processMidi();   // incoming messages, first thing after the wake-up
+        power.service(); // idle/active transitions
 
         processControls();
         taskYIELD();
         
-        synth.updateCache(); // cache some not-so-critical params to local members to speed up hot paths
-
-        if (++d % 1024 == 0) {
-            midiWM = uxTaskGetStackHighWaterMark(midiTaskHandle);
-            audioWM = uxTaskGetStackHighWaterMark(audioTaskHandle);
-            #if 1   // --- diagnostics
-                for (int i = 0; i < DMA_BUFFER_LEN; ++i) {
-                    rmsL += outL[i] * outL[i];
-                    rmsR += outR[i] * outR[i];
+        if (!power.isIdle()) {
+            synth.updateCache(); // cache some not-so-critical params to local members to speed up hot paths
+
+            fx.service(); // effect changes are built here, never on the audio task
+        }
+#ifdef RDX_TRACE
+        RDX_Trace::get().keyframe(synth.currentPatch(), RDX_State::getState().controls, synth.activeVoices());
+#endif
+
+        if (millis() - reportMs >= 1000) {
+            reportMs = millis();
+            logMidiRx();
+            RDX_MemStat::get().log();   // the log task's memory and stack sample, when it has taken a new one
+#ifdef RDX_PROFILE
+            RDX_Profiler::get().log();   // stages since the last log, then a new interval
+#endif
+            fx.logSlots();
+#ifdef DEBUG_METER
+            static RDX_Meter::Snapshot levels;  // off the task stack
+            if (RDX_Meter::get().read(levels)) {
+                for (int t = 0; t < METER_VOICE0; ++t) {
+                    const RDX_Meter::Level& lv = levels.tap[t];
+                    ESP_LOGI("METER", "%-5s hold %6.1f dB  rms %6.1f dB", RDX_Meter::name(t),
+                             RDX_Meter::dB(std::max(lv.hold[0], lv.hold[1])), RDX_Meter::rmsDb(0.5f * (lv.ms[0] + lv.ms[1])));
                 }
-                rmsL = sqrtf(rmsL / DMA_BUFFER_LEN);
-                rmsR = sqrtf(rmsR / DMA_BUFFER_LEN);
-            #endif
-            ESP_LOGI("STATE","synth %d + fx %d = %d of %d micros, RMS %f Free stack: audio %ld B midi %ld B gui %ld B", time1, time2, time1+time2, budgetMicros, rmsL + rmsR, audioWM, midiWM, guiWM);
+            }
+#endif
+            if (audio.getUnderruns()) ESP_LOGW("STATE", "I2S underruns: %u", audio.getUnderruns());
+            if (audio.getOverruns()) ESP_LOGW("STATE", "I2S input overruns: %u", audio.getOverruns());
+            if (power.stats().idles) ESP_LOGI("STATE", "power: %u idle periods, %u wake-ups, %u lost, last wake %u us", power.stats().idles, power.stats().wakes, power.stats().lost, power.stats().lastWakeUs);
 //            for (int i = 0 ; i < VOICES; ++i) {
   //              ESP_LOGI("STATE","voice %d\t active %d\t score %f" , i, synth.getVoice(i).isActive(), synth.getVoice(i).calcScore());
     //        }
@@ -117,6 +183,21 @@ static void IRAM_ATTR midiTask(void*) {
     }
 }
 
+// ------------------- Log Task ------------------------
+// prints what the audio and MIDI paths queued in RDX_Log, so the UART never blocks them;
+// writes the trace file when one is due, so flash writes never block them either;
+// samples memory and stacks (RDX_MemStat), which walks the heap under its lock
+static void logTask(void*) {
+    while (true) {
+        RDX_Log::get().drain();
+        RDX_MemStat::get().service();
+#ifdef RDX_TRACE
+        RDX_Trace::get().service(LittleFS);
+#endif
+        vTaskDelay(pdMS_TO_TICKS(RDX_Log::DRAIN_MS));
+    }
+}
+
 #ifdef ENABLE_GUI
 // ------------------- GUI Task ------------------------
 static void IRAM_ATTR gui_task(void*) {
@@ -125,11 +206,140 @@ static void IRAM_ATTR gui_task(void*) {
     vTaskDelay(30);
     while (true) {
         gui.draw();
-        vTaskDelay(1);
+        vTaskDelay(RDX_Power::get().isIdle() ? pdMS_TO_TICKS(POWER_IDLE_GUI_MS) : 1);
     }
 }
 #endif
 
+// ------------------- Telemetry -----------------------
+// answers a SysEx telemetry request (RDX_SysEx.h) on the MIDI task
+static void fillTelemetry(uint32_t* v) {
+    const uint32_t mhz = RDX_Platform::cpuMHz();
+    const AudioConfig& ac = RDX_AudioConfig::get();
+    v[TELE_UPTIME_MS] = RDX_Platform::millis();
+    v[TELE_BUDGET_US] = (uint32_t)(1000000ull * ac.blockLen / ac.sampleRate);
+    RDX_BlockTimer& blocks = RDX_BlockTimer::get();
+    RDX_BlockTimer::Stats st;
+    blocks.read(st);    // since the last request, then a new interval
+    v[TELE_BLOCK_MIN_US] = st.min / mhz;
+    v[TELE_BLOCK_AVG_US] = st.avg / mhz;
+    v[TELE_BLOCK_MAX_US] = st.max / mhz;
+    v[TELE_BLOCKS] = st.count;
+    v[TELE_XRUNS] = blocks.xruns();
+    v[TELE_UNDERRUNS] = audio.getUnderruns();
+    v[TELE_VOICE_CAP] = VOICES;
+    v[TELE_VOICES_ACTIVE] = synth.activeVoices();
+    v[TELE_IDLE] = RDX_Power::get().isIdle();
+    v[TELE_CPU_MHZ] = mhz;
+    for (int s = 0; s < FX_MAX_SLOTS; ++s) v[TELE_FX0_US + s] = fx.slotCycles(s) / mhz;
+    v[TELE_DRAM_FREE] = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    v[TELE_DRAM_LARGEST] = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
+    v[TELE_PSRAM_FREE] = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    v[TELE_PSRAM_LARGEST] = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    v[TELE_MIDI_AVG_US] = midiRx.messages ? midiRx.sumUs / midiRx.messages : 0;
+    v[TELE_MIDI_MAX_US] = midiRx.maxUs;
+}
+
+// ------------------- Extra FX slots ------------------
+// SysEx parameter changes to the slots past the patch's (RDX_SysEx.h), on the MIDI task
+static void setFxSlot(uint8_t slot, uint8_t param, uint8_t value) {
+    struct SlotCfg { uint8_t v[FXS_PARAMS] = { FX_THRU, 0, 64, 64, 64, 0 }; };   // as last applied
+    static SlotCfg cfg[FX_MAX_SLOTS];
+    if (slot < FX_SLOTS || slot >= FX_MAX_SLOTS || param >= FXS_PARAMS) return;
+    uint8_t* c = cfg[slot].v;
+    if (param == FXS_PARAM1 || param == FXS_PARAM2) {
+        c[param] = value;
+        fx.setSlotParams(slot, c[FXS_PARAM1], c[FXS_PARAM2]);
+        return;
+    }
+    if (param == FXS_TYPE && value >= FX_COUNT) return;
+    const uint8_t was = c[param];
+    c[param] = value;
+    if (param == FXS_IR && c[FXS_TYPE] != FX_CONVOLUTION) return;   // loaded once the slot runs the convolution
+    if (c[FXS_TYPE] == FX_CONVOLUTION) {
+        char path[24] = "/ir/default.wav";   // the IR the new instance loads
+        if (c[FXS_IR]) snprintf(path, sizeof(path), "/ir/%u.wav", c[FXS_IR]);
+        FxConvolution::setImpulse(&LittleFS, path);
+    }
+    // route and send level change the live effect in place; a new type or IR builds a new one
+    const FxRoute route = c[FXS_ROUTE] ? FxRoute::SEND : FxRoute::INSERT;
+    if (fx.configureSlot(slot, (FX_ID)c[FXS_TYPE], route, c[FXS_SEND] * MIDI_NORM, param == FXS_IR)) {
+        fx.setSlotParams(slot, c[FXS_PARAM1], c[FXS_PARAM2]);
+    } else {
+        ESP_LOGW(TAG, "FX slot %d: FX %d refused, keeping the previous one", slot, c[FXS_TYPE]);
+        c[param] = was;
+    }
+}
+
+#ifdef DEBUG_FX_BENCH
+// ------------------- FX benchmark --------------------
+// Both slots run the delay, so two PSRAM lines compete for the cache, as on stage
+static void benchDelayStaging() {
+    RDX_Common& common = RDX_State::getState().workingPatch.common;
+    const uint8_t fx0 = common.effects[0][0];
+    const uint8_t fx1 = common.effects[1][0];
+    common.effects[0][0] = FX_DELAY;
+    common.effects[1][0] = FX_DELAY;
+    constexpr int BLOCKS = 512;
+
+    fx.service(); // builds the effects outside the measurement
+    for (int staged = 0; staged < 2; ++staged) {
+        for (int s = 0; s < FX_SLOTS; ++s) {
+            if (FXBase* d = fx.getSlot(s)) static_cast<FxDelay*>(d)->setStaging(staged);
+        }
+
+        uint32_t cycles = 0;
+        for (int b = 0; b < BLOCKS; ++b) {
+            for (uint32_t i = 0; i < fx.blockLen(); ++i) outL[i] = outR[i] = randomFloat() * 0.5f;
+            uint32_t start = ESP.getCycleCount();
+            fx.process(outL, outR);
+            cycles += ESP.getCycleCount() - start;
+        }
+        ESP_LOGI("BENCH", "2x FxDelay, %s: %u cycles per block", staged ? "DRAM-staged" : "PSRAM direct", cycles / BLOCKS);
+    }
+
+    common.effects[0][0] = fx0;
+    common.effects[1][0] = fx1;
+    fx.service();
+}
+
+// Allpass cascade effects, old per-channel loop against the 2-lane cascade, and the cost table
+static void benchCascade() {
+    RDX_Common& common = RDX_State::getState().workingPatch.common;
+    const uint8_t fx0 = common.effects[0][0];
+    const uint8_t fx1 = common.effects[1][0];
+    const FX_ID ids[] = { FX_TOUCHWAH, FX_PHASER };
+    constexpr int BLOCKS = 512;
+
+    for (FX_ID id : ids) {
+        common.effects[0][0] = id;
+        common.effects[1][0] = FX_THRU;
+        fx.service(); // builds the effect outside the measurement
+
+        uint32_t cycles[2] = {};
+        for (int split = 1; split >= 0; --split) {
+            if (FXBase* e = fx.getSlot(0)) {
+                if (id == FX_TOUCHWAH) static_cast<FxTouchWah*>(e)->setSplit(split);
+                else static_cast<FxPhaser*>(e)->setSplit(split);
+            }
+            for (int b = 0; b < BLOCKS; ++b) {
+                for (uint32_t i = 0; i < fx.blockLen(); ++i) outL[i] = outR[i] = randomFloat() * 0.5f;
+                uint32_t start = ESP.getCycleCount();
+                fx.process(outL, outR);
+                cycles[split] += ESP.getCycleCount() - start;
+            }
+        }
+        const uint32_t mhz = ESP.getCpuFreqMHz();
+        ESP_LOGI("BENCH", "FX %d: per-channel %u cycles per block (%u us), 2-lane %u (%u us), table %d us", id,
+                 cycles[1] / BLOCKS, cycles[1] / BLOCKS / mhz, cycles[0] / BLOCKS, cycles[0] / BLOCKS / mhz, fx.getTiming(id));
+    }
+
+    common.effects[0][0] = fx0;
+    common.effects[1][0] = fx1;
+    fx.service();
+}
+#endif
+
 // ------------------- Setup ---------------------------
 void setup() {
     Serial.begin(115200);
@@ -142,6 +352,8 @@ void setup() {
     if (!LittleFS.begin()) ESP_LOGE(TAG, "LittleFS init failed");
 
   setupMidi() ;
+  sysexTelemetry = fillTelemetry;
+  sysexFxSlot = setFxSlot;
   
   initControls();
   
@@ -151,8 +363,24 @@ void setup() {
 #endif
    
     // ----------------- Audio -------------------------
-    audio.setSampleRate(SAMPLE_RATE);
+    RDX_AudioConfig::load();
+    const AudioConfig& ac = RDX_AudioConfig::get();
+    audio.setSampleRate(ac.sampleRate);
+    audio.setBufferLen(ac.blockLen);
+    audio.setBufferNum(ac.dmaBufNum);
+    audio.setZeroCopyOut(AUDIO_ZERO_COPY_OUT);
+#if AUDIO_INPUT != AUDIO_IN_NONE && !defined(AUDIO_INPUT_FILE)
+    audio.init(I2S_Audio::MODE_IN_OUT);   // RX and TX share the clocks
+#else
     audio.init(I2S_Audio::MODE_OUT);
+#endif
+#if AUDIO_INPUT != AUDIO_IN_NONE && defined(AUDIO_INPUT_FILE)
+    fileIn.open(LittleFS, AUDIO_INPUT_FILE, ac.sampleRate);
+#endif
+
+#ifdef RDX_TRACE
+    RDX_Trace::get().init(ac.sampleRate, ac.blockLen);   // before the first patch, so a trace can start from it
+#endif
 
     // ----------------- Synth init ---------------------
     synth.init(); 
@@ -173,18 +401,47 @@ void setup() {
     // ----------------- EFFECTS -----------------------
 
     logMemoryStats("Before FX init");
-    fx.init(SAMPLE_RATE);
+    fx.init(ac.sampleRate, ac.blockLen);
     logMemoryStats("After FX init");
-    fx.setSlot(0, FX_THRU);
-    fx.setSlot(1, FX_THRU);
+    fx.service();   // builds the patch's effects
+#ifdef DEBUG_FX_BENCH
+    benchDelayStaging();
+    benchCascade();
+#endif
+#ifdef DEBUG_BENCH
+    {
+        static RDX_Bench bench(ac.sampleRate, ac.blockLen);   // ~5 kB, not on the setup stack
+        bench.setI2S(&audio);
+        bench.run(synth.DigiChordPatch());
+        bench.report([](const char* line) { Serial.println(line); }, DEBUG_BENCH);
+    }
+#endif
+
+
+#ifdef RDX_PROFILE
+    RDX_Profiler::get().init(ac.sampleRate, ac.blockLen);   // after the boot benchmarks, which run through FXHost too
+#endif
+    RDX_BlockTimer::get().init(ac.sampleRate, ac.blockLen);
+
+    RDX_Meter::get().init(ac.sampleRate, ac.blockLen);
 
+    // ----------------- Power -------------------------
+    RDX_Power::get().init(ac.sampleRate, ac.blockLen, AUDIO_INPUT == AUDIO_IN_NONE); // a live input never idles
 
     // ----------------- Tasks -------------------------
     xTaskCreatePinnedToCore(audioTask, "audio", 4096, nullptr, 8, &audioTaskHandle, 0);
     xTaskCreatePinnedToCore(midiTask, "midi", 4096, nullptr, 5, &midiTaskHandle, 1);
+    RDX_Power::get().setServiceTask(midiTaskHandle);
+    setMidiRxTask(midiTaskHandle);
+    xTaskCreatePinnedToCore(logTask, "log", 4096, nullptr, 1, &logTaskHandle, 1);
 #ifdef ENABLE_GUI
     xTaskCreatePinnedToCore(gui_task, "gui", 4096, nullptr, 4, &guiTaskHandle, 1);
 #endif
+    RDX_MemStat& mem = RDX_MemStat::get();
+    mem.addTask(audioTaskHandle, "audio");
+    mem.addTask(midiTaskHandle, "midi");
+    mem.addTask(logTaskHandle, "log");
+    mem.addTask(guiTaskHandle, "gui");    // nullptr without the GUI: skipped
 }
 
 // ------------------- Loop ----------------------------
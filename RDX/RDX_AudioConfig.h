@@ -0,0 +1,102 @@
+// RDX_AudioConfig.h
+#pragma once
+#include "RDX_Platform.h"
+#include <stddef.h>
+#include <Preferences.h>
+#include "config.h"
+#include "RDX_State.h"
+#include "RDX_Constants.h"
+
+// =========================================================
+// Audio engine setup chosen at boot: sample rate, samples
+// per block and I2S DMA depth. Short blocks for playing
+// live, long ones (or 32 kHz) for polyphony. Saved in NVS,
+// edited through the system block (RDX_System::audioRate /
+// audioBlock / audioDmaBufs) and applied on the next boot,
+// since the I2S channel, the FX memory and every static
+// buffer are set up once.
+// =========================================================
+
+struct AudioConfig {
+    uint32_t sampleRate = SAMPLE_RATE;
+    uint32_t blockLen  = DMA_BUFFER_LEN;    // samples per audio block
+    uint32_t dmaBufNum = DMA_BUFFER_NUM;    // I2S DMA buffers of blockLen frames each
+};
+
+class RDX_AudioConfig {
+public:
+    static constexpr uint32_t BLOCK_LENS[] = { 32, 64, 128, 256 };
+    static constexpr uint8_t  BLOCK_CODES = sizeof(BLOCK_LENS) / sizeof(BLOCK_LENS[0]);
+    static constexpr uint32_t RATES[] = { 22050, 32000, 44100, 48000 };
+    static constexpr uint8_t  RATE_CODES = sizeof(RATES) / sizeof(RATES[0]);
+
+    static AudioConfig& get() {
+        static AudioConfig instance;
+        return instance;
+    }
+
+    // NVS -> system block -> get(); missing or bad entries fall back to config.h
+    static void load() {
+        RDX_System& sys = RDX_State::getState().system;
+        Preferences prefs;
+        if (prefs.begin(NVS_NAMESPACE, true)) {
+            sys.audioRate    = prefs.getUChar("rate", rateCodeOf(SAMPLE_RATE));
+            sys.audioBlock   = prefs.getUChar("block", codeOf(DMA_BUFFER_LEN));
+            sys.audioDmaBufs = prefs.getUChar("dmabufs", DMA_BUFFER_NUM);
+            prefs.end();
+        } else {
+            sys.audioRate    = rateCodeOf(SAMPLE_RATE);
+            sys.audioBlock   = codeOf(DMA_BUFFER_LEN);
+            sys.audioDmaBufs = DMA_BUFFER_NUM;
+        }
+        apply(sys);
+        ESP_LOGI("AUDIO", "%u Hz, block %u samples, %u DMA buffers", get().sampleRate, get().blockLen, get().dmaBufNum);
+    }
+
+    // system block -> NVS, for the next boot
+    static void save() {
+        const RDX_System& sys = RDX_State::getState().system;
+        Preferences prefs;
+        if (!prefs.begin(NVS_NAMESPACE, false)) {
+            ESP_LOGE("AUDIO", "NVS unavailable, audio settings not saved");
+            return;
+        }
+        prefs.putUChar("rate", sys.audioRate);
+        prefs.putUChar("block", sys.audioBlock);
+        prefs.putUChar("dmabufs", sys.audioDmaBufs);
+        prefs.end();
+        ESP_LOGI("AUDIO", "Saved: %u Hz, block %u samples, %u DMA buffers (next boot)",
+                 RATES[sys.audioRate < RATE_CODES ? sys.audioRate : rateCodeOf(SAMPLE_RATE)],
+                 BLOCK_LENS[sys.audioBlock < BLOCK_CODES ? sys.audioBlock : codeOf(DMA_BUFFER_LEN)], sys.audioDmaBufs);
+    }
+
+    // system block offsets of the audio fields
+    static bool isAudioParam(uint8_t addr) {
+        return addr == offsetof(RDX_System, audioRate) || addr == offsetof(RDX_System, audioBlock)
+            || addr == offsetof(RDX_System, audioDmaBufs);
+    }
+
+    static constexpr uint8_t codeOf(uint32_t blockLen) {
+        for (uint8_t c = 0; c < BLOCK_CODES; ++c) if (BLOCK_LENS[c] == blockLen) return c;
+        return 2;
+    }
+
+    static constexpr uint8_t rateCodeOf(uint32_t rate) {
+        for (uint8_t c = 0; c < RATE_CODES; ++c) if (RATES[c] == rate) return c;
+        return 2;
+    }
+
+private:
+    static constexpr const char* NVS_NAMESPACE = "rdx-audio";
+
+    static void apply(RDX_System& sys) {
+        if (sys.audioRate >= RATE_CODES) sys.audioRate = rateCodeOf(SAMPLE_RATE);
+        if (sys.audioBlock >= BLOCK_CODES) sys.audioBlock = codeOf(DMA_BUFFER_LEN);
+        sys.audioDmaBufs = constrain(sys.audioDmaBufs, 2, MAX_DMA_BUFFER_NUM);
+        AudioConfig& cfg = get();
+        cfg.sampleRate = RATES[sys.audioRate];
+        cfg.blockLen  = BLOCK_LENS[sys.audioBlock];
+        cfg.dmaBufNum = sys.audioDmaBufs;
+        setEngineSampleRate(cfg.sampleRate);
+    }
+};
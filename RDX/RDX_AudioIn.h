@@ -0,0 +1,164 @@
+// RDX_AudioIn.h
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
+#include <FS.h>
+#include "config.h"
+#include "RDX_Platform.h"
+#ifndef RDX_HOST
+  #include "src/i2s/i2s_in_out.h"
+#endif
+
+// =========================================================
+// External audio input (effects-processor mode, AUDIO_INPUT
+// in config.h).
+//
+// A source hands out one block of interleaved L/R int16
+// frames at a time; the audio task converts it straight into
+// the block buffers the synth renders into (pcm16ToFloat in
+// misc.h), so the input rides the same FXHost pass and the
+// same zero-copy output as the synth, no extra copies.
+//
+// I2SAudioIn - the DIN pin, read in place from the RX DMA
+//              buffers; clock-locked to the output
+// FileAudioIn - a .wav (PCM16, mono or stereo) or .raw
+//              (stereo int16) file, looped or played once;
+//              for host renders (rdx_render --input) and
+//              for bench tests without a codec
+// =========================================================
+
+class RDX_AudioIn {
+public:
+    virtual ~RDX_AudioIn() = default;
+
+    // next n frames, interleaved L/R; may block until they are there
+    // the pointer stays valid until the next call
+    virtual const int16_t* acquire(uint32_t n) = 0;
+};
+
+
+#ifndef RDX_HOST
+class I2SAudioIn : public RDX_AudioIn {
+public:
+    explicit I2SAudioIn(I2S_Audio& io) : io_(io) {}
+
+    // the block length is the I2S one, set at init
+    inline const int16_t* acquire(uint32_t) override { return io_.acquireInputBuffer(); }
+
+private:
+    I2S_Audio& io_;
+};
+#endif
+
+
+class FileAudioIn : public RDX_AudioIn {
+public:
+    // not for the audio task: opens and parses the file; !loop: silence after the end
+    inline bool open(fs::FS& fs, const char* path, uint32_t sampleRate, bool loop = true) {
+        close();
+        loop_ = loop;
+        f_ = fs.open(path, "r");
+        if (!f_) {
+            ESP_LOGW("AUDIO_IN", "can't open %s", path);
+            return false;
+        }
+        uint32_t rate = sampleRate;
+        const size_t len = strlen(path);
+        if (len > 4 && !strcasecmp(path + len - 4, ".raw")) {
+            channels_ = 2;
+            dataStart_ = 0;
+            frames_ = f_.size() / (2 * sizeof(int16_t));
+        } else if (!parseWav(rate)) {
+            ESP_LOGW("AUDIO_IN", "%s: only PCM16 mono/stereo WAV or .raw is supported", path);
+            close();
+            return false;
+        }
+        if (!frames_) {
+            close();
+            return false;
+        }
+        if (rate != sampleRate) ESP_LOGW("AUDIO_IN", "%s is %u Hz, plays at %u Hz", path, rate, sampleRate);
+        pos_ = 0;
+        ESP_LOGI("AUDIO_IN", "%s: %u frames, %u ch", path, frames_, channels_);
+        return true;
+    }
+
+    inline void close() {
+        if (f_) f_.close();
+        frames_ = 0;
+    }
+
+    inline bool isOpen() const { return frames_ != 0; }
+    inline uint32_t frames() const { return frames_; }
+
+    // reads straight into the block, mono is spread in place; silence when nothing is open
+    inline const int16_t* acquire(uint32_t n) override {
+        if (n > MAX_BLOCK_LEN) n = MAX_BLOCK_LEN;
+        if (!frames_) {
+            memset(buf_, 0, n * 2 * sizeof(int16_t));
+            return buf_;
+        }
+        const uint32_t frameBytes = channels_ * sizeof(int16_t);
+        uint32_t got = 0;
+        while (got < n) {
+            if (pos_ >= frames_) {      // loop
+                if (!loop_) {
+                    memset(buf_ + got * channels_, 0, (n - got) * frameBytes);
+                    break;
+                }
+                f_.seek(dataStart_);
+                pos_ = 0;
+            }
+            const uint32_t want = std::min(n - got, frames_ - pos_);
+            const uint32_t rd = f_.read((uint8_t*)(buf_ + got * channels_), want * frameBytes) / frameBytes;
+            if (!rd) {
+                memset(buf_ + got * channels_, 0, (n - got) * frameBytes);
+                break;
+            }
+            got += rd;
+            pos_ += rd;
+        }
+        if (channels_ == 1) {
+            for (int32_t i = n - 1; i >= 0; --i) buf_[2 * i] = buf_[2 * i + 1] = buf_[i];
+        }
+        return buf_;
+    }
+
+private:
+    fs::File f_;
+    uint32_t channels_  = 2;
+    uint32_t frames_    = 0;
+    uint32_t pos_       = 0;
+    uint32_t dataStart_ = 0;
+    bool     loop_      = true;
+    int16_t  buf_[MAX_BLOCK_LEN * 2];
+
+    // leaves the file positioned at the first sample
+    inline bool parseWav(uint32_t& rate) {
+        uint8_t h[12];
+        if (f_.read(h, 12) != 12 || memcmp(h, "RIFF", 4) || memcmp(h + 8, "WAVE", 4)) return false;
+        uint16_t format = 0, bits = 0;
+        while (f_.read(h, 8) == 8) {
+            const uint32_t size = h[4] | (h[5] << 8) | (h[6] << 16) | ((uint32_t)h[7] << 24);
+            if (!memcmp(h, "fmt ", 4)) {
+                uint8_t fmt[16];
+                if (size < 16 || f_.read(fmt, 16) != 16) return false;
+                format    = fmt[0] | (fmt[1] << 8);
+                channels_ = fmt[2] | (fmt[3] << 8);
+                rate      = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24);
+                bits      = fmt[14] | (fmt[15] << 8);
+                if (format == 0xFFFE && size >= 26) format = 1;  // WAVE_FORMAT_EXTENSIBLE, assume PCM
+                f_.seek(f_.position() + size - 16 + (size & 1));
+            } else if (!memcmp(h, "data", 4)) {
+                if (format != 1 || bits != 16 || channels_ < 1 || channels_ > 2) return false;
+                dataStart_ = f_.position();
+                frames_ = size / (channels_ * sizeof(int16_t));
+                return true;
+            } else {
+                f_.seek(f_.position() + size + (size & 1));
+            }
+        }
+        return false;
+    }
+};
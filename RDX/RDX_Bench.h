@@ -0,0 +1,335 @@
+// RDX_Bench.h
+#pragma once
+#include "RDX_Platform.h"
+#include <cstdio>
+#include <cstring>
+#include "config.h"
+#include "misc.h"
+#include "RDX_Constants.h"
+#include "RDX_Types.h"
+#include "RDX_State.h"
+#include "RDX_Operator.h"
+#include "RDX_Envelope.h"
+#include "RDX_LFO.h"
+#include "RDX_Voice.h"
+#include "RDX_FX.h"
+#ifndef RDX_HOST
+  #include "src/i2s/i2s_in_out.h"
+#endif
+
+// =========================================================
+// Micro-benchmarks of the hot paths, one block at a time:
+//
+//   op.compute          one operator, feedback on
+//   voice.algoN         RDX_Voice::step(), algorithm N, 4 ops on
+//   env.processAEG      one AEG through attack/decay/release
+//   lfo.updateState     once per block
+//   math.semitonesToRatio, math.sin01
+//   fx.<name>           each FX_ID alone in an FXHost; the
+//                       convolution runs all of /ir/default.wav
+//                       (data/), left out when LittleFS lacks it
+//   fx.<name>.split     touch-wah and phaser on their old
+//                       per-channel allpass loop, the "before"
+//                       of the 2-lane cascade in the same run
+//   pcm.floatToPcm16    the zero-copy / FXHost conversion
+//   i2s.convertBuffers  writeBuffers()' conversion (device only)
+//
+// Each runs WARMUP blocks, then BLOCKS timed blocks with
+// RDX_Platform::cycles(). cycles/block is the mean, min the
+// fastest block; ns/sample = mean / MHz / block length.
+// Same names and columns on the S3 (DEBUG_BENCH, serial) and
+// on the host (rdx_bench), so runs of two firmware versions
+// diff line by line.
+//
+// run() does all the measuring first, report() prints after,
+// so log lines from effect set-up never land inside the JSON.
+// Not for a running synth: it changes the working patch (and
+// puts it back) and VOICES.
+// =========================================================
+
+class RDX_Bench {
+public:
+    enum Format : uint8_t { TEXT, JSON, CSV };
+    using Sink = void (*)(const char* line);    // one line, without the newline
+
+    struct Result {
+        char     name[24];
+        uint32_t cycles;        // mean per block
+        uint32_t minCycles;     // fastest block
+        float    nsPerSample;
+    };
+
+    static constexpr int MAX_RESULTS = 40;
+    static constexpr int WARMUP = 16;
+
+    RDX_Bench(uint32_t sampleRate, uint32_t blockLen, uint32_t blocks = 256)
+        : sampleRate_(sampleRate),
+          len_(std::max<uint32_t>(MIN_BLOCK_LEN, std::min<uint32_t>(MAX_BLOCK_LEN, blockLen))),
+          blocks_(blocks ? blocks : 1) {}
+
+#ifndef RDX_HOST
+    inline void setI2S(I2S_Audio* io) { i2s_ = io; }
+#endif
+
+    // filter: run only names containing it (nullptr: all); patch: the voice the synth benchmarks play
+    inline void run(const RDX_Patch& patch, const char* filter = nullptr) {
+        filter_ = filter;
+        count_ = 0;
+        RDX_Patch& working = RDX_State::getState().workingPatch;
+        const RDX_Patch saved = working;
+        const int savedVoices = VOICES;
+        working = patch;
+        for (auto& op : working.ops) op.enable = 1;   // every operator computes, whatever the patch
+
+        benchOperator();
+        for (int a = 0; a < 12; ++a) benchVoice(a);
+        benchEnvelope();
+        benchLfo();
+        benchMath();
+        benchFx();
+        benchPcm();
+
+        working = saved;
+        VOICES = savedVoices;
+    }
+
+    inline void report(Sink out, Format fmt) const {
+        char line[160];
+        const uint32_t mhz = RDX_Platform::cpuMHz();
+#ifdef RDX_HOST
+        const char* platform = "host";
+#else
+        const char* platform = "esp32s3";
+#endif
+        switch (fmt) {
+            case JSON:
+                out("{");
+                snprintf(line, sizeof(line), "  \"platform\": \"%s\", \"cpu_mhz\": %u, \"sample_rate\": %u, \"block_len\": %u, \"blocks\": %u,",
+                         platform, mhz, sampleRate_, len_, blocks_);
+                out(line);
+                out("  \"results\": [");
+                for (int i = 0; i < count_; ++i) {
+                    const Result& r = results_[i];
+                    snprintf(line, sizeof(line), "    {\"name\": \"%s\", \"cycles_per_block\": %u, \"min_cycles\": %u, \"ns_per_sample\": %.2f}%s",
+                             r.name, r.cycles, r.minCycles, r.nsPerSample, i + 1 < count_ ? "," : "");
+                    out(line);
+                }
+                out("  ]");
+                out("}");
+                break;
+            case CSV:
+                snprintf(line, sizeof(line), "# %s, %u MHz, %u Hz, %u-sample blocks, %u blocks", platform, mhz, sampleRate_, len_, blocks_);
+                out(line);
+                out("name,cycles_per_block,min_cycles,ns_per_sample");
+                for (int i = 0; i < count_; ++i) {
+                    const Result& r = results_[i];
+                    snprintf(line, sizeof(line), "%s,%u,%u,%.2f", r.name, r.cycles, r.minCycles, r.nsPerSample);
+                    out(line);
+                }
+                break;
+            default:
+                snprintf(line, sizeof(line), "%s, %u MHz, %u Hz, %u-sample blocks, %u blocks", platform, mhz, sampleRate_, len_, blocks_);
+                out(line);
+                snprintf(line, sizeof(line), "%-24s %12s %12s %10s", "benchmark", "cycles/blk", "min", "ns/smp");
+                out(line);
+                for (int i = 0; i < count_; ++i) {
+                    const Result& r = results_[i];
+                    snprintf(line, sizeof(line), "%-24s %12u %12u %10.2f", r.name, r.cycles, r.minCycles, r.nsPerSample);
+                    out(line);
+                }
+                break;
+        }
+    }
+
+    inline int count() const { return count_; }
+    inline const Result& result(int i) const { return results_[i]; }
+
+    // puts an allpass cascade effect on its old per-channel loop; false for other effects
+    static inline bool setCascadeSplit(FXBase* fx, int id, bool split) {
+        if (!fx) return false;
+        switch (id) {
+            case FX_TOUCHWAH: static_cast<FxTouchWah*>(fx)->setSplit(split); return true;
+            case FX_PHASER:   static_cast<FxPhaser*>(fx)->setSplit(split);   return true;
+            default:          return false;
+        }
+    }
+
+private:
+    uint32_t sampleRate_;
+    uint32_t len_;
+    uint32_t blocks_;
+    const char* filter_ = nullptr;
+    Result   results_[MAX_RESULTS];
+    int      count_ = 0;
+    float    in_[MAX_BLOCK_LEN];
+    float    L_[MAX_BLOCK_LEN];
+    float    R_[MAX_BLOCK_LEN];
+    int16_t  pcm_[MAX_BLOCK_LEN * 2];
+    volatile float sink_ = 0.f;     // keeps results alive past the optimizer
+#ifndef RDX_HOST
+    I2S_Audio* i2s_ = nullptr;
+#endif
+
+    inline bool wanted(const char* name) const { return !filter_ || strstr(name, filter_); }
+
+    // times fn() (one block) WARMUP + blocks_ times
+    template <class Fn>
+    inline void measure(const char* name, Fn&& fn) {
+        if (count_ >= MAX_RESULTS) return;
+        for (int b = 0; b < WARMUP; ++b) fn();
+        uint64_t total = 0;
+        uint32_t best = UINT32_MAX;
+        for (uint32_t b = 0; b < blocks_; ++b) {
+            const uint32_t start = RDX_Platform::cycles();
+            fn();
+            const uint32_t c = RDX_Platform::cycles() - start;
+            total += c;
+            if (c < best) best = c;
+        }
+        Result& r = results_[count_++];
+        snprintf(r.name, sizeof(r.name), "%s", name);
+        r.cycles = total / blocks_;
+        r.minCycles = best;
+        r.nsPerSample = (float)total / blocks_ * 1000.0f / RDX_Platform::cpuMHz() / len_;
+    }
+
+    inline void noise(float* dst, float gain) {
+        for (uint32_t i = 0; i < len_; ++i) dst[i] = randomFloat() * gain;
+    }
+
+    inline void benchOperator() {
+        if (!wanted("op.compute")) return;
+        RDX_Operator* op = new RDX_Operator(0);
+        op->params().feedback = 64;
+        op->setParams(60, 100, 261.63f);
+        op->gate(true);
+        float x = 0.f;
+        measure("op.compute", [&] {
+            for (uint32_t i = 0; i < len_; ++i) x = op->compute(x * 0.25f, 0.f);
+        });
+        sink_ = x;
+        delete op;
+    }
+
+    inline void benchVoice(int algorithm) {
+        char name[24];
+        snprintf(name, sizeof(name), "voice.algo%d", algorithm);
+        if (!wanted(name)) return;
+        RDX_State::getState().workingPatch.common.algorithm = algorithm;
+        RDX_Voice* v = new RDX_Voice();
+        v->init();
+        v->cacheParams();
+        v->noteOn(60, 100);
+        float acc = 0.f;
+        measure(name, [&] {
+            v->updateLfo(len_);
+            for (uint32_t i = 0; i < len_; ++i) acc += v->step();
+        });
+        sink_ = acc;
+        delete v;
+    }
+
+    // gate toggles every 64 blocks, so the stages keep moving rather than sitting in sustain
+    inline void benchEnvelope() {
+        if (!wanted("env.processAEG")) return;
+        const uint8_t rates[4]  = {90, 70, 60, 80};
+        const uint8_t levels[4] = {127, 100, 80, 0};
+        RDX_Envelope env;
+        env.initAEG(rates, levels, true);
+        uint32_t b = 0;
+        float acc = 0.f;
+        measure("env.processAEG", [&] {
+            if ((b++ & 63) == 0) env.gate(!(b & 64));
+            for (uint32_t i = 0; i < len_; ++i) acc += env.processAEG();
+        });
+        sink_ = acc;
+    }
+
+    inline void benchLfo() {
+        if (!wanted("lfo.updateState")) return;
+        RDX_LFO lfo;
+        lfo.init(90, 0, RDX_LFO::Waveform::TRIANGLE);
+        float acc = 0.f;
+        measure("lfo.updateState", [&] {
+            lfo.updateState(len_);
+            acc += lfo.getValue();
+        });
+        sink_ = acc;
+    }
+
+    inline void benchMath() {
+        float acc = 0.f;
+        if (wanted("math.semitonesToRatio")) {
+            for (uint32_t i = 0; i < len_; ++i) in_[i] = randomFloat() * 24.f;       // +-24 semitones
+            measure("math.semitonesToRatio", [&] {
+                for (uint32_t i = 0; i < len_; ++i) acc += semitonesToRatio(in_[i]);
+            });
+        }
+        if (wanted("math.sin01")) {
+            for (uint32_t i = 0; i < len_; ++i) in_[i] = randomFloat() * 0.5f + 0.5f; // [0..1)
+            measure("math.sin01", [&] {
+                for (uint32_t i = 0; i < len_; ++i) acc += sin01(in_[i]);
+            });
+        }
+        sink_ = acc;
+    }
+
+    // each effect alone on an extra slot of its own FXHost, patch slots dry
+    inline void benchFx() {
+        static const char* const names[FX_COUNT] = {
+            "thru", "distortion", "touchwah", "chorus", "flanger", "phaser", "delay", "reverb", "convolution"
+        };
+        RDX_Common& common = RDX_State::getState().workingPatch.common;
+        for (int s = 0; s < FX_SLOTS; ++s) common.effects[s][0] = FX_THRU;
+        const int voices = VOICES;
+        for (int id = FX_DISTORTION; id < FX_COUNT; ++id) {
+            char name[24];
+            snprintf(name, sizeof(name), "fx.%s", names[id]);
+            if (!wanted(name)) continue;
+            FXHost* host = new (std::nothrow) FXHost();
+            if (!host) continue;
+            host->init(sampleRate_, len_);
+            host->setFixedVoices(voices);
+            host->service();
+            if (id == FX_CONVOLUTION) FxConvolution::setImpulse(&LittleFS, "/ir/default.wav");
+            bool ready = host->configureSlot(FX_SLOTS, (FX_ID)id);
+            if (ready && id == FX_CONVOLUTION) {
+                host->setSlotParams(FX_SLOTS, 64, 127);     // whole tail
+                ready = static_cast<FxConvolution*>(host->getSlot(FX_SLOTS))->activeIrMs() > 0;
+            }
+            if (ready) {
+                auto block = [&] {
+                    noise(L_, 0.5f);
+                    memcpy(R_, L_, len_ * sizeof(float));
+                    host->process(L_, R_);
+                };
+                measure(name, block);
+                snprintf(name, sizeof(name), "fx.%s.split", names[id]);
+                if (wanted(name) && setCascadeSplit(host->getSlot(FX_SLOTS), id, true)) measure(name, block);
+            } else {
+                ESP_LOGW("BENCH", "%s: couldn't be set up, skipped", name);
+            }
+            host->configureSlot(FX_SLOTS, FX_THRU);
+            delete host;
+        }
+        VOICES = voices;
+    }
+
+    inline void benchPcm() {
+        noise(L_, 1.2f);    // some samples clip
+        noise(R_, 1.2f);
+        if (wanted("pcm.floatToPcm16")) {
+            measure("pcm.floatToPcm16", [&] { floatToPcm16(L_, R_, pcm_, len_); });
+        }
+#ifndef RDX_HOST
+        if (i2s_ && wanted("i2s.convertBuffers")) {
+            BUF_TYPE* buf = (BUF_TYPE*)heap_caps_malloc(MAX_BLOCK_LEN * 2 * sizeof(BUF_TYPE), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            if (buf) {
+                measure("i2s.convertBuffers", [&] { i2s_->convertBuffers(L_, R_, buf); });
+                heap_caps_free(buf);
+            }
+        }
+#endif
+        sink_ = pcm_[len_ - 1];
+    }
+};
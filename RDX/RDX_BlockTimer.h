@@ -0,0 +1,100 @@
+// RDX_BlockTimer.h
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "RDX_Platform.h"
+#include "config.h"
+
+// =========================================================
+// Render time of the audio task's blocks, always on.
+//
+// One cycles() pair per rendered block (synth + FX + input,
+// what PROF_BLOCK times): count, min, max and sum since the
+// last read, and the blocks over the budget (block length at
+// the sample rate) since boot. This is what the SysEx
+// telemetry reports; RDX_PROFILE adds the per-stage figures
+// and histograms on top and doesn't change these.
+//
+// The audio task writes with plain (relaxed) stores. read()
+// copies the interval and asks for a new one, which the audio
+// task starts at its next start(), as RDX_Profiler::reset().
+// Nobody may read for hours, so the sum is kept in units of
+// SUM_SHIFT bits and an interval ends by itself after
+// MAX_BLOCKS (~50 min of 128-sample blocks).
+// =========================================================
+
+class RDX_BlockTimer {
+public:
+    struct Stats {
+        uint32_t count = 0;
+        uint32_t min   = 0;
+        uint32_t max   = 0;
+        uint32_t avg   = 0;
+    };
+
+    static constexpr uint32_t SUM_SHIFT  = 8;          // 256 cycles, about 1 us at 240 MHz
+    static constexpr uint32_t MAX_BLOCKS = 1u << 20;
+
+    static RDX_BlockTimer& get() {
+        static RDX_BlockTimer instance;
+        return instance;
+    }
+
+    // before the audio task starts
+    inline void init(uint32_t sampleRate, uint32_t blockLen) {
+        budgetCycles_ = (uint32_t)((uint64_t)blockLen * RDX_Platform::cpuMHz() * 1000000ull / sampleRate);
+    }
+
+    // ---- audio task ----
+
+    inline IRAM_ATTR uint32_t start() {
+        const uint32_t req = resetReq_.load(std::memory_order_acquire);
+        if (req != resetAck_ || count_.load(std::memory_order_relaxed) >= MAX_BLOCKS) {
+            store(count_, 0);
+            store(min_, 0);
+            store(max_, 0);
+            store(sum_, 0);
+            resetAck_ = req;
+        }
+        return RDX_Platform::cycles();
+    }
+
+    // discount: cycles inside the block that weren't rendering (the profiler's own timers)
+    inline IRAM_ATTR void end(uint32_t start, uint32_t discount = 0) {
+        const uint32_t c = RDX_Platform::cycles() - start - discount;
+        const uint32_t n = count_.load(std::memory_order_relaxed);
+        if (!n || c < min_.load(std::memory_order_relaxed)) store(min_, c);
+        if (c > max_.load(std::memory_order_relaxed)) store(max_, c);
+        store(sum_, sum_.load(std::memory_order_relaxed) + (c >> SUM_SHIFT));
+        store(count_, n + 1);
+        if (c > budgetCycles_) store(xruns_, xruns_.load(std::memory_order_relaxed) + 1);
+    }
+
+    // ---- any other task ----
+
+    // the blocks since the last read, then a new interval
+    inline void read(Stats& out) {
+        out.count = count_.load(std::memory_order_relaxed);
+        out.min   = min_.load(std::memory_order_relaxed);
+        out.max   = max_.load(std::memory_order_relaxed);
+        out.avg   = out.count ? (uint32_t)(((uint64_t)sum_.load(std::memory_order_relaxed) << SUM_SHIFT) / out.count) : 0;
+        resetReq_.fetch_add(1, std::memory_order_release);
+    }
+
+    inline uint32_t xruns() const { return xruns_.load(std::memory_order_relaxed); }
+    inline uint32_t budgetCycles() const { return budgetCycles_; }
+
+private:
+    std::atomic<uint32_t> count_ {0};
+    std::atomic<uint32_t> min_ {0};
+    std::atomic<uint32_t> max_ {0};
+    std::atomic<uint32_t> sum_ {0};         // in 1 << SUM_SHIFT cycles
+    std::atomic<uint32_t> xruns_ {0};       // since boot
+    std::atomic<uint32_t> resetReq_ {0};    // bumped by read()
+    uint32_t resetAck_ = 0;                 // audio task: last request applied
+    uint32_t budgetCycles_ = UINT32_MAX;
+
+    static inline IRAM_ATTR __attribute__((always_inline)) void store(std::atomic<uint32_t>& a, uint32_t v) {
+        a.store(v, std::memory_order_relaxed);
+    }
+};
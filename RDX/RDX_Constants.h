@@ -1,13 +1,25 @@
 // RDX_Constants.h
 #pragma once
 #include <stdint.h>
+#include "config.h"
 #include "misc.h"
 
 #include <array>
 #include <cmath>
 
-constexpr float DIV_SAMPLE_RATE = 1.0f / (float)SAMPLE_RATE;
-constexpr float DIV_DMA_BUFFER_LEN = 1.0f / (float)DMA_BUFFER_LEN;
+// Engine sample rate, picked at boot by RDX_AudioConfig::load() before the synth and FX are set up.
+// Rate-dependent coefficients come from these; config.h's SAMPLE_RATE is only the default.
+inline float ENGINE_SAMPLE_RATE = (float)SAMPLE_RATE;
+inline float DIV_SAMPLE_RATE = 1.0f / (float)SAMPLE_RATE;
+
+inline void setEngineSampleRate(uint32_t sr) {
+    ENGINE_SAMPLE_RATE = (float)sr;
+    DIV_SAMPLE_RATE = 1.0f / (float)sr;
+}
+
+// voices the synth runs, lowered by FXHost when effects take CPU; defined by the application (RDX.ino)
+extern int VOICES;
+
 constexpr float MIDI_NORM = 1.0f / 127.0f;
 
 #define ONE_DIV_SQRT2 0.707106781f
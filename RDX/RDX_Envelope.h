@@ -1,5 +1,5 @@
 #pragma once
-#include <Arduino.h>
+#include "RDX_Platform.h"
 #include "RDX_Constants.h"
 #include "RDX_State.h"
 
@@ -1,7 +1,9 @@
 #pragma once
 #include <stdint.h>
-#include <esp_log.h>
+#include "RDX_Platform.h"
 #include <cstring> 
+#include <atomic>
+#include <new>
 
 #include "fx_base.h"
 #include "fx_reverb.h"
@@ -11,10 +13,15 @@
 #include "fx_chorus.h"
 #include "fx_touch_wah.h"
 #include "fx_distortion.h"
+#include "fx_convolution.h"
+#include "fx_multirate.h"
+#include "RDX_Profiler.h"
+#include "RDX_Log.h"
+#include "RDX_Trace.h"
+#include "RDX_Meter.h"
 
-#define FX_BLOCK_SIZE   DMA_BUFFER_LEN
 #define FX_SAMPLE_RATE  SAMPLE_RATE
-#define FX_SLOTS        2
+#define FX_SLOTS        2       // patch slots, the rest up to FX_MAX_SLOTS (config.h) are extra
 
 // =========================================================
 // Effect type enum  matches Reface DX table
@@ -28,21 +35,63 @@ enum FX_ID : uint8_t {
     FX_PHASER,
     FX_DELAY,
     FX_REVERB,
+    FX_CONVOLUTION,     // not on the Reface: extra slots only
     FX_COUNT
 };
  
 
 
+// Where a slot sits in the chain
+enum class FxRoute : uint8_t {
+    INSERT = 0,     // processes the bus in place
+    SEND            // processes a copy; its wet part (out - in) returns at sendLevel
+};
+
+
+// =========================================================
+// One live effect with its own scratch. Built and freed on
+// the control side (service / setSlot / configureSlot), only
+// read by the audio task.
+// =========================================================
+struct FxInstance {
+    FXBase*      fx        = nullptr;
+    FxMultirate* multirate = nullptr;   // only for rateDivider() > 1
+    float*       fast      = nullptr;
+    float*       slow      = nullptr;
+    FX_ID        id        = FX_THRU;
+    volatile FxRoute route     = FxRoute::INSERT;  // extra slots: changed in place by configureSlot()
+    volatile float   sendLevel = 1.0f;
+    volatile uint32_t cycles   = 0;     // smoothed cycles per block, written by the audio task
+    volatile uint32_t peak     = 0;     // worst block so far
+    volatile bool     bypassed = false; // dropped by the runtime budget check
+};
+
+
 // =========================================================
-// FX Host  manages two slots and static pool
+// FX Host  manages the slot chain
+// Slots 0..FX_SLOTS-1 follow the patch (common.effects) like
+// the Reface; the rest are extra inserts/sends set up with
+// configureSlot(). Only effects in use exist, each with the
+// memory it asked for.
 // =========================================================
 class FXHost {
 public:
-    void init(float sampleRate = FX_SAMPLE_RATE) {
-        //here we assume that we have 210 kB of DRAM and 4+ MB of PSRAM
+    FXHost() = default;
+    FXHost(const FXHost&) = delete;
+    FXHost& operator=(const FXHost&) = delete;
+
+    // the device's FXHost lives forever; host tools make and drop them
+    ~FXHost() {
+        for (int s = 0; s < FX_MAX_SLOTS; ++s) {
+            if (FxInstance* inst = live_[s].exchange(nullptr)) destroy(inst);
+        }
+    }
+
+    void init(float sampleRate = FX_SAMPLE_RATE, uint32_t blockLen = DMA_BUFFER_LEN) {
         sampleRate_ = sampleRate;
+        blockLen_ = std::max<uint32_t>(MIN_BLOCK_LEN, std::min<uint32_t>(MAX_BLOCK_LEN, blockLen));
 
-        timing[FX_THRU]  = 0; // us per block of 128 samples
+        timing[FX_THRU]  = 0; // us per block of 128 samples, scaled to blockLen_ below
         timing[FX_DISTORTION] = 34;
         timing[FX_TOUCHWAH] = 85;
         timing[FX_CHORUS] = 62;
@@ -50,115 +99,366 @@ public:
         timing[FX_PHASER] = 95;
         timing[FX_DELAY] = 56;
         timing[FX_REVERB] = 152;
+        timing[FX_CONVOLUTION] = 400; // depends on the IR, replaced by the measured cost once it runs
+        for (int id = 0; id < FX_COUNT; ++id) timing[id] = timing[id] * blockLen_ / 128;
 
-        uint32_t dram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
-        uint32_t psram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
-        szDRAM = (dram_largest - 8000) / FX_SLOTS / sizeof(float); // small buffers for scratch * 2 slots ~101kB per slot
-        szPSRAM = std::min((uint32_t)sampleRate * 7, psram_largest / FX_SLOTS / sizeof(float)) ; // seconds * 2 slots 
+        cpuMHz_ = RDX_Platform::cpuMHz();
+        budgetUs_ = fxBudgetUs(blockLen_);
+        budgetCycles_ = budgetUs_ * cpuMHz_;
+        blockUs_ = 1000000ull * blockLen_ / (uint32_t)sampleRate_;
 
-        if (!scratchDRAM[0]) {
-            scratchDRAM[0] = (float*) heap_caps_malloc(szDRAM * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
-            scratchDRAM[1] = (float*) heap_caps_malloc(szDRAM * sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        for (int s = 0; s < FX_MAX_SLOTS; ++s) {
+            live_[s].store(nullptr);
+            wanted_[s] = FX_THRU;
+            refused_[s] = false;
+            extraParams_[s][0] = FX_THRU;
+            extraParams_[s][1] = 64;
+            extraParams_[s][2] = 64;
         }
+        ESP_LOGI("FXHost", "Initialized FXHost @ %.1f Hz, %u-sample blocks, %d slots, %u us budget", sampleRate_, blockLen_, FX_MAX_SLOTS, budgetUs_);
+    }
 
-        if (!scratchPSRAM[0]) {
-            scratchPSRAM[0] = (float*) heap_caps_malloc(szPSRAM * sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-            scratchPSRAM[1] = (float*) heap_caps_malloc(szPSRAM * sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    // Audio task. Never builds or frees anything, slot changes arrive through service()
+    // pcm != nullptr: the block also goes out as interleaved 16-bit PCM (e.g. straight into
+    // an I2S DMA buffer), converted inside the last stage's final loop where it can be
+    inline IRAM_ATTR __attribute__((always_inline, hot)) void process(float* left, float* right, int16_t* pcm = nullptr) {
+        inProcess_.store(true);
+        FxInstance* chain[FX_MAX_SLOTS];
+        int last = -1;
+        for (int s = 0; s < FX_MAX_SLOTS; ++s) {
+            FxInstance* inst = live_[s].load();
+            chain[s] = (inst && !inst->bypassed) ? inst : nullptr;
+            if (chain[s]) last = s;
         }
 
-        if (!scratchDRAM[1] || !scratchPSRAM[1]) {
-            ESP_LOGE("FX","Unable to allocate scratch arrays DRAM: %#010x, PSRAM: %#010x",scratchDRAM[1], scratchPSRAM[1] );
-            delay(100);
-            while (1) {;}
-        }
-        // Initialize all instances
-        for (int i = 0; i < FX_COUNT; ++i) {
-            for (int s = 0; s < FX_SLOTS; ++s) {
-                auto* fx = getInstance((FX_ID)i, s);
-                fx->init(sampleRate, s);
-                fx->prepare(scratchDRAM[s], szDRAM, scratchPSRAM[s], szPSRAM, sampleRate); // pass both fast and slow slot buffers, so fx could decide for themselves
-                vTaskDelay(10);
+        uint32_t total = 0;
+        for (int s = 0; s <= last; ++s) {
+            FxInstance* inst = chain[s];
+            if (!inst) continue;
+            int16_t* out = (s == last) ? pcm : nullptr;
+
+            const uint32_t start = RDX_Platform::cycles();
+            if (inst->route == FxRoute::SEND) {
+                memcpy(sendL_, left,  blockLen_ * sizeof(float));
+                memcpy(sendR_, right, blockLen_ * sizeof(float));
+                run(inst, sendL_, sendR_, nullptr);
+                const float g = inst->sendLevel;
+                if (out) {
+                    uint32_t* o = (uint32_t*)out;
+                    for (uint32_t i = 0; i < blockLen_; ++i) {
+                        left[i]  += (sendL_[i] - left[i])  * g;
+                        right[i] += (sendR_[i] - right[i]) * g;
+                        o[i] = pcm16Frame(left[i], right[i]);
+                    }
+                } else {
+                    for (uint32_t i = 0; i < blockLen_; ++i) {
+                        left[i]  += (sendL_[i] - left[i])  * g;
+                        right[i] += (sendR_[i] - right[i]) * g;
+                    }
+                }
+            } else {
+                run(inst, left, right, out);
             }
+            const uint32_t c = RDX_Platform::cycles() - start;
+            RDX_PROF_RECORD(PROF_FX0 + s, c);
+            RDX_Meter::get().tap(METER_FX0 + s, left, right, blockLen_);
+            inst->cycles = inst->cycles - (inst->cycles >> 4) + (c >> 4);
+            if (c > inst->peak) inst->peak = c;
+            total += inst->cycles;
+        }
+        if (pcm && last < 0) floatToPcm16(left, right, pcm, blockLen_);
+        checkBudget(total);
+
+        const int fx_time = total / cpuMHz_;
+        if (common_.monoPoly != RDX_MODE_POLY) {
+            VOICES = 1;
+        } else if (fixedVoices_) {
+            VOICES = fixedVoices_;
+        } else {
+            // 340us per voice per 128 samples, polyphony estimation
+            VOICES = std::max(1, std::min(MAX_VOICES, ((int)(blockUs_ * 98 / 100) - fx_time) * 128 / (340 * (int)blockLen_)));
         }
-        // Default to thru
-        setSlot(0, FX_THRU);
-        setSlot(1, FX_THRU);
-        ESP_LOGI("FXHost", "Initialized FXHost @ %.1f Hz", sampleRate_);
+        blocks_.fetch_add(1);
+        inProcess_.store(false);
     }
 
-    inline IRAM_ATTR __attribute__((always_inline, hot)) void process(float* left, float* right ) {
-        int fx_time = 0;
+    // Control side (MIDI task): follows the patch's effect types, brings back what the
+    // budget held back once there is room again, and reports budget drops
+    inline void service() {
         for (int s = 0; s < FX_SLOTS; ++s) {
-            if (fx_[s] != common_.effects[s][0]) setSlot(s, (FX_ID)common_.effects[s][0]);
-            if (slots_[s]) slots_[s]->processBlock(left, right, FX_BLOCK_SIZE  );
-            fx_time += timing[(FX_ID)common_.effects[s][0]];
+            const FX_ID id = (FX_ID)common_.effects[s][0];
+            if (id != wanted_[s] || (refused_[s] && fits(s, estimateUs(id), 0))) setSlot(s, id);
         }
-        if (common_.monoPoly == RDX_MODE_POLY) {
-            VOICES = (2850 - fx_time) / 340; // 340ms per voice , polyphony estimation
-        } else {
-            VOICES = 1;
+        for (int s = 0; s < FX_MAX_SLOTS; ++s) {
+            FxInstance* inst = live_[s].load(std::memory_order_acquire);
+            if (inst && !inst->bypassed) measuredUs_[inst->id] = inst->cycles / cpuMHz_;
+        }
+        for (int s = FX_SLOTS; s < FX_MAX_SLOTS; ++s) {
+            FxInstance* inst = live_[s].load(std::memory_order_acquire);
+            // with an eighth of the budget to spare, so a slot on the edge doesn't flap
+            if (inst && inst->bypassed && fits(s, std::max<int>(inst->cycles / cpuMHz_, estimateUs(inst->id)), budgetUs_ / 8)) {
+                inst->bypassed = false;
+                RDX_LOGI("FXHost", "Slot %d back: FX %d fits the %u us budget again", s, inst->id, budgetUs_);
+            }
+        }
+        if (degraded_ >= 0) {
+            RDX_LOGW("FXHost", "Slot %d bypassed: FX chain over its %u us budget", degraded_, budgetUs_);
+            degraded_ = -1;
         }
     }
 
-    virtual void prepare(float* buf, uint32_t len, float sampleRate) { (void)buf; (void)len; (void)sampleRate; }
+    // Patch slot: an effect that doesn't fit the budget or memory leaves the slot dry;
+    // service() installs it once the budget has room (memory: at the next change)
+    inline bool setSlot(uint8_t slot, FX_ID id) {
+        if (slot >= FX_SLOTS || id >= FX_COUNT) return false;
+        wanted_[slot] = id;
+        return install(slot, id, FxRoute::INSERT, 1.0f, true);
+    }
 
-    inline void resetSlot(uint8_t slot) {
-        if (slot < FX_SLOTS) {
-            memset(scratchPSRAM[slot], 0, szPSRAM * sizeof(float));
-            memset(scratchDRAM[slot], 0, szDRAM * sizeof(float));
+    // Extra slot: refused (previous effect kept) if it doesn't fit. The same effect type
+    // only takes the new route and send level, state and tail intact; rebuild: a new
+    // instance anyway (e.g. for another convolution IR)
+    inline bool configureSlot(uint8_t slot, FX_ID id, FxRoute route = FxRoute::INSERT, float sendLevel = 0.5f,
+                              bool rebuild = false) {
+        if (slot < FX_SLOTS || slot >= FX_MAX_SLOTS || id >= FX_COUNT) return false;
+        RDX_TRACE_FX_SLOT(slot, id, route, sendLevel);
+        FxInstance* inst = live_[slot].load(std::memory_order_acquire);
+        if (inst && inst->id == id && !rebuild) {
+            inst->sendLevel = sendLevel;
+            inst->route = route;
+            return true;
         }
+        if (!install(slot, id, route, sendLevel, false)) return false;
+        wanted_[slot] = id;
+        extraParams_[slot][0] = id;
+        return true;
     }
 
-    inline void setSlot(uint8_t slot, FX_ID id) {
-        if (slot >= FX_SLOTS || id >= FX_COUNT) return;
-        resetSlot(slot);
-        slots_[slot] = getInstance(id, slot);
-        slots_[slot]->enable(false);
-        slots_[slot]->reset();
-        slots_[slot]->enable(true);
-        fx_[slot] = id;
-        ESP_LOGI("FXHost", "Slot %d -> FX %d", slot, id);
+    inline void setSlotParams(uint8_t slot, uint8_t p1, uint8_t p2) {
+        if (slot < FX_SLOTS || slot >= FX_MAX_SLOTS) return;
+        RDX_TRACE_FX_PARAMS(slot, p1, p2);
+        extraParams_[slot][1] = p1;
+        extraParams_[slot][2] = p2;
     }
 
-    inline FXBase* getSlot(uint8_t slot) { return slots_[slot]; }
+    inline FXBase* getSlot(uint8_t slot) {
+        FxInstance* inst = (slot < FX_MAX_SLOTS) ? live_[slot].load(std::memory_order_acquire) : nullptr;
+        return inst ? inst->fx : nullptr;
+    }
 
-private:
+    // measured cost of a slot, cycles per block (0 when empty)
+    inline uint32_t slotCycles(uint8_t slot) const {
+        FxInstance* inst = live_[slot].load(std::memory_order_acquire);
+        return (inst && !inst->bypassed) ? inst->cycles : 0;
+    }
 
-    int szDRAM = 0;
-    int szPSRAM = 0; 
-    float* scratchDRAM[2] = {nullptr, nullptr};
-    float* scratchPSRAM[2] = {nullptr, nullptr};
+    inline uint32_t slotPeakCycles(uint8_t slot) const {
+        FxInstance* inst = live_[slot].load(std::memory_order_acquire);
+        return inst ? inst->peak : 0;
+    }
+
+    inline void logSlots() const {
+        for (int s = 0; s < FX_MAX_SLOTS; ++s) {
+            FxInstance* inst = live_[s].load(std::memory_order_acquire);
+            if (!inst) continue;
+            ESP_LOGI("FXHost", "slot %d FX %d %s%s: %u cycles/block (%u us), peak %u", s, inst->id,
+                     inst->route == FxRoute::SEND ? "send" : "insert", inst->bypassed ? " BYPASSED" : "",
+                     inst->cycles, inst->cycles / cpuMHz_, inst->peak);
+        }
+    }
+
+    // table cost of an effect, us per block
+    inline int getTiming(FX_ID id) const { return timing[id]; }
+
+    // Poly voices independent of the FX CPU time (offline renders, benchmarks); 0: estimate per block
+    inline void setFixedVoices(int n) { fixedVoices_ = std::max(0, std::min(MAX_VOICES, n)); }
+
+    inline uint32_t blockLen() const { return blockLen_; }
+
+private:
 
     RDX_Common& common_ = RDX_State::getState().workingPatch.common ;
     float sampleRate_ = FX_SAMPLE_RATE;
-    uint8_t fx_[2]={0,0};
-    FXBase* slots_[FX_SLOTS] = {nullptr, nullptr};
-
-    // Two copies per effect type  -> static pool
-    FxThru      thru_[FX_SLOTS];
-    FxDistortion distortion_[FX_SLOTS];
-    FxTouchWah  touchwah_[FX_SLOTS];
-    FxChorus    chorus_[FX_SLOTS];
-    FxFlanger   flanger_[FX_SLOTS];
-    FxPhaser    phaser_[FX_SLOTS];
-    FxDelay     delay_[FX_SLOTS];
-    FxReverb    reverb_[FX_SLOTS];
+    uint32_t cpuMHz_ = 240;
+    uint32_t blockLen_ = DMA_BUFFER_LEN;
+    uint32_t blockUs_ = 2902;                       // audio time of one block
+    uint32_t budgetUs_ = FX_CPU_BUDGET_US;          // FX share of it
+    uint32_t budgetCycles_ = FX_CPU_BUDGET_US * 240;
+
+    std::atomic<FxInstance*> live_[FX_MAX_SLOTS] = {};
+    FX_ID    wanted_[FX_MAX_SLOTS] = {};            // last type asked for, applied or not
+    bool     refused_[FX_MAX_SLOTS] = {};           // patch slot left dry on budget: retried when it fits
+    uint8_t  extraParams_[FX_MAX_SLOTS][3] = {};    // {type, p1, p2} for slots the patch doesn't cover
+    std::atomic<uint32_t> blocks_ {0};              // audio blocks done
+    std::atomic<bool> inProcess_ {false};           // audio task is inside process(), may hold an old instance
+    volatile int8_t degraded_ = -1;
+    int fixedVoices_ = 0;
+    uint32_t overruns_ = 0;
+
+    static constexpr uint32_t OVERRUN_BLOCKS = 64;  // ~190 ms over budget before a slot is dropped
+
+    float sendL_[MAX_BLOCK_LEN];
+    float sendR_[MAX_BLOCK_LEN];
 
     int timing[FX_COUNT] = {0} ;
+    int measuredUs_[FX_COUNT] = {0};
+
+    inline IRAM_ATTR __attribute__((always_inline)) void run(FxInstance* inst, float* left, float* right, int16_t* pcm) {
+        if (inst->multirate) {
+            inst->multirate->process(inst->fx, left, right, blockLen_, pcm);
+        } else {
+            inst->fx->processBlock(left, right, blockLen_);
+            if (pcm) floatToPcm16(left, right, pcm, blockLen_);
+        }
+    }
+
+    // Sustained overrun: drop the last extra slot before the voices starve or the DMA underruns.
+    // Patch slots are left alone, polyphony shrinks around them instead. service() lifts
+    // the bypass once the rest of the chain leaves room for it.
+    inline IRAM_ATTR void checkBudget(uint32_t total) {
+        if (total <= budgetCycles_) { overruns_ = 0; return; }
+        if (++overruns_ < OVERRUN_BLOCKS) return;
+        overruns_ = 0;
+        for (int s = FX_MAX_SLOTS - 1; s >= FX_SLOTS; --s) {
+            FxInstance* inst = live_[s].load(std::memory_order_relaxed);
+            if (inst && !inst->bypassed) {
+                inst->bypassed = true;
+                degraded_ = s;
+                return;
+            }
+        }
+    }
 
+    inline int estimateUs(FX_ID id) const { return measuredUs_[id] ? measuredUs_[id] : timing[id]; }
 
+    // cost us more in slot, with spare us left over
+    inline bool fits(int slot, int cost, int spare) const { return usedUsExcept(slot) + cost + spare <= (int)budgetUs_; }
+
+    inline int usedUsExcept(int slot) const {
+        int us = 0;
+        for (int s = 0; s < FX_MAX_SLOTS; ++s) {
+            if (s == slot) continue;
+            FxInstance* inst = live_[s].load(std::memory_order_acquire);
+            if (inst && !inst->bypassed) us += std::max<int>(inst->cycles / cpuMHz_, estimateUs(inst->id));
+        }
+        return us;
+    }
+
+    inline bool install(uint8_t slot, FX_ID id, FxRoute route, float sendLevel, bool degrade) {
+        refused_[slot] = false;
+        if (id == FX_THRU) {
+            publish(slot, nullptr);
+            RDX_LOGI("FXHost", "Slot %d -> FX %d", slot, id);
+            return true;
+        }
+
+        const int used = usedUsExcept(slot);
+        const int cost = estimateUs(id);
+        if (used + cost > (int)budgetUs_) {
+            RDX_LOGW("FXHost", "Slot %d: FX %d (%d us) + %d us in use exceeds the %u us budget, %s",
+                     slot, id, cost, used, budgetUs_, degrade ? "slot bypassed" : "refused");
+            if (degrade) publish(slot, nullptr);
+            refused_[slot] = degrade;
+            return false;
+        }
+
+        FxInstance* inst = create(slot, id, route, sendLevel);
+        if (!inst) {
+            if (degrade) publish(slot, nullptr);
+            return false;
+        }
+        publish(slot, inst);
+        return true;
+    }
+
+    inline FxInstance* create(uint8_t slot, FX_ID id, FxRoute route, float sendLevel) {
+        FxInstance* inst = new (std::nothrow) FxInstance();
+        if (!inst) return nullptr;
+        inst->fx = newEffect(id);
+        if (!inst->fx) {
+            destroy(inst);
+            return nullptr;
+        }
+        inst->id = id;
+        inst->route = route;
+        inst->sendLevel = sendLevel;
+
+        FXBase* fx = inst->fx;
+        const int fxRate = sampleRate_ / fx->rateDivider(); // decimated effects run at a reduced rate
+        fx->setBlockLen(blockLen_ / fx->rateDivider());     // and on shorter blocks
+        const FxMemory mem = fx->memoryNeeds(fxRate);
+        if (mem.fast) {
+            inst->fast = (float*) heap_caps_calloc(mem.fast, sizeof(float), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+            // slower, but better than no effect
+            if (!inst->fast) inst->fast = (float*) heap_caps_calloc(mem.fast, sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (mem.slow) {
+            inst->slow = (float*) heap_caps_calloc(mem.slow, sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        }
+        if (fx->rateDivider() > 1) {
+            inst->multirate = new (std::nothrow) FxMultirate();
+            if (inst->multirate) inst->multirate->reset();
+        }
+        if ((mem.fast && !inst->fast) || (mem.slow && !inst->slow) || (fx->rateDivider() > 1 && !inst->multirate)) {
+            RDX_LOGE("FXHost", "Slot %d: no memory for FX %d (%u fast + %u slow floats)", slot, id, mem.fast, mem.slow);
+            destroy(inst);
+            return nullptr;
+        }
+
+        fx->bindParams(slot < FX_SLOTS ? common_.effects[slot] : extraParams_[slot]);
+        fx->init(fxRate, slot);
+        if (!fx->prepare(inst->fast, mem.fast, inst->slow, mem.slow, fxRate)) {
+            RDX_LOGE("FXHost", "Slot %d: FX %d failed to prepare", slot, id);
+            destroy(inst);
+            return nullptr;
+        }
+        fx->enable(false);
+        fx->reset();
+        fx->enable(true);
+        inst->cycles = estimateUs(id) * cpuMHz_;   // until measured
+
+        RDX_LOGI("FXHost", "Slot %d -> FX %d, %.1f kB fast + %.1f kB slow", slot, id,
+                 mem.fast * 4 / 1024.0f, mem.slow * 4 / 1024.0f);
+        return inst;
+    }
+
+    // Swap the live instance; the old one is freed once the audio task is past it.
+    // Sequentially consistent on both sides: either process() sees the new pointer,
+    // or we see it inside process() and wait for that block to end.
+    inline void publish(uint8_t slot, FxInstance* inst) {
+        FxInstance* old = live_[slot].exchange(inst);
+        if (!old) return;
+        if (inProcess_.load()) {
+            const uint32_t b = blocks_.load();
+            int wait = 0;
+            while (blocks_.load() == b && wait++ < 100) RDX_Platform::sleepTicks(1);
+            if (wait > 100) {
+                RDX_LOGE("FXHost", "Slot %d: audio task stalled, FX %d leaked", slot, old->id);
+                return;
+            }
+        }
+        destroy(old);
+    }
+
+    inline void destroy(FxInstance* inst) {
+        delete inst->fx;
+        delete inst->multirate;
+        heap_caps_free(inst->fast);
+        heap_caps_free(inst->slow);
+        delete inst;
+    }
 
-    inline FXBase* getInstance(FX_ID id, uint8_t slot) {
+    inline FXBase* newEffect(FX_ID id) {
         switch (id) {
-            case FX_THRU:       return &thru_[slot];
-            case FX_DISTORTION: return &distortion_[slot];
-            case FX_TOUCHWAH:   return &touchwah_[slot];
-            case FX_CHORUS:     return &chorus_[slot];
-            case FX_FLANGER:    return &flanger_[slot];
-            case FX_PHASER:     return &phaser_[slot];
-            case FX_DELAY:      return &delay_[slot];
-            case FX_REVERB:     return &reverb_[slot];
-            default:            return &thru_[slot];
+            case FX_DISTORTION: return new (std::nothrow) FxDistortion();
+            case FX_TOUCHWAH:   return new (std::nothrow) FxTouchWah();
+            case FX_CHORUS:     return new (std::nothrow) FxChorus();
+            case FX_FLANGER:    return new (std::nothrow) FxFlanger();
+            case FX_PHASER:     return new (std::nothrow) FxPhaser();
+            case FX_DELAY:      return new (std::nothrow) FxDelay();
+            case FX_REVERB:     return new (std::nothrow) FxReverb();
+            case FX_CONVOLUTION: return new (std::nothrow) FxConvolution();
+            default:            return nullptr;
         }
     }
 };
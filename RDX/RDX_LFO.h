@@ -1,6 +1,6 @@
 // RDX_LFO.h
 #pragma once
-#include <Arduino.h>
+#include "RDX_Platform.h"
 #include <cmath>
 #include "RDX_Constants.h"
 #include "misc.h"
@@ -33,27 +33,30 @@ public:
 
     inline void setDelay(uint8_t delayParam) {
         delay_ = DELAY_TIME_MS[delayParam] * 0.001f; // seconds
-        delaySamples_ = delay_ * SAMPLE_RATE;
+        delaySamples_ = delay_ * ENGINE_SAMPLE_RATE;
         fadeInSamples_ = delaySamples_ / 3;
         fadeInIncrement_ = (fadeInSamples_ > 0)
-                               ? (float)DMA_BUFFER_LEN / (float)fadeInSamples_
+                               ? 1.0f / (float)fadeInSamples_
                                : 1.0f;
     }
 
     inline void setRate(uint8_t rate) {
         if (rate > 127) rate = 127;
         frequency_ = LFO_SPEED[rate];
-        phaseInc_ = frequency_ * DMA_BUFFER_LEN * DIV_SAMPLE_RATE;
+        phaseInc_ = frequency_ * DIV_SAMPLE_RATE;
     }
 
     inline void setWaveform(Waveform wf) { waveform_ = wf; }
 
-    // --- call once per audio block ---
-    inline void updateState() {
+    // restarts the sample & hold sequence, shared by all LFOs (reproducible renders)
+    static inline void seed(uint32_t s) { shState_ = s ? s : 0xA5A5A5A5; }
+
+    // --- call once per audio block of len samples ---
+    inline void updateState(uint32_t len) {
         // --- delay / fade-in ---
         if (delaySamples_ > 0) {
-            delaySamples_ -= DMA_BUFFER_LEN;
-            fadeInEnv_ += fadeInIncrement_;
+            delaySamples_ -= len;
+            fadeInEnv_ += fadeInIncrement_ * len;
             if (fadeInEnv_ >= 1.f) {
                 fadeInEnv_ = 1.f;
                 delaySamples_ = 0;
@@ -61,7 +64,7 @@ public:
         }
 
         float startPhase = phase_;
-        float endPhase = startPhase + phaseInc_;
+        float endPhase = startPhase + phaseInc_ * len;
         if (endPhase >= 1.f) endPhase -= fast_floorf(endPhase);
 
         // --- Sample & Hold 8-step ---
@@ -99,7 +102,7 @@ public:
             increment_ = 0.f;
         } else {
             value_ = v0 * fadeInEnv_;
-            increment_ = (v1 - v0) / float(DMA_BUFFER_LEN);
+            increment_ = (v1 - v0) / float(len);
         }
 
         prevValue_ = v1;
@@ -112,13 +115,14 @@ public:
     inline IRAM_ATTR __attribute__((always_inline)) float getIncrement() const { return increment_; }
 
 private:
+    static inline uint32_t shState_ = 0xA5A5A5A5;
+
     inline float randomFloat() {
         // fast xorshift32 PRNG
-        static uint32_t lfsr = 0xA5A5A5A5;
-        lfsr ^= lfsr << 13;
-        lfsr ^= lfsr >> 17;
-        lfsr ^= lfsr << 5;
-        return ((lfsr & 0xFFFFFF) / float(0x800000) - 1.f);
+        shState_ ^= shState_ << 13;
+        shState_ ^= shState_ >> 17;
+        shState_ ^= shState_ << 5;
+        return ((shState_ & 0xFFFFFF) / float(0x800000) - 1.f);
     }
 
     inline float evalWave(float ph) const {
@@ -153,7 +157,7 @@ private:
     float prevValue_ = 0.f;
     float increment_ = 0.f;
 
-    float phaseInc_ = 0.f; // cycles per block
+    float phaseInc_ = 0.f; // cycles per sample
 
     // S&H
     float shValue_ = 0.f;
@@ -0,0 +1,213 @@
+// RDX_Log.h
+#pragma once
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <type_traits>
+#include "RDX_Platform.h"
+#include "config.h"
+
+// =========================================================
+// Deferred logging for the audio and MIDI paths.
+//
+//   RDX_LOGE / RDX_LOGW / RDX_LOGI / RDX_LOGD (tag, fmt, ...)
+//
+// A call copies the format pointer, the tag, a timestamp and
+// up to MAX_ARGS arguments into a fixed-size record of a ring
+// (no formatting, no allocation, no lock: a CAS on the head,
+// then a per-record sequence number publishes it). drain()
+// formats and prints them from a low-priority task, through
+// ESP_LOGx as before. A full ring drops the record and counts
+// it; the next drain reports how many.
+//
+// tag, fmt and any %s argument are stored as pointers: they
+// must outlive the record (string literals, static names).
+// Integers print through %lld whatever the length modifier,
+// floats as double; a mismatched argument is converted.
+//
+// RDX_LOG_LEVEL (config.h) strips the calls above it at
+// compile time: 0 none, 1 errors, 2 + warnings, 3 + info,
+// 4 + debug. Setup and periodic reports keep ESP_LOGx.
+// =========================================================
+
+class RDX_Log {
+public:
+    enum Level : uint8_t { LVL_NONE, LVL_ERROR, LVL_WARN, LVL_INFO, LVL_DEBUG };
+
+    static constexpr uint32_t RECORDS  = 64;     // power of two
+    static constexpr int      MAX_ARGS = 6;
+    static constexpr uint32_t DRAIN_MS = 20;     // log task period
+
+    static RDX_Log& get() {
+        static RDX_Log instance;
+        return instance;
+    }
+
+    // any task; false: the ring was full, the record is counted as dropped
+    template <class... Args>
+    inline IRAM_ATTR bool push(Level level, const char* tag, const char* fmt, Args... args) {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "RDX_Log: too many arguments");
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        do {
+            if (head - tail_.load(std::memory_order_acquire) >= RECORDS) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!head_.compare_exchange_weak(head, head + 1, std::memory_order_relaxed));
+
+        Record& r = ring_[head & (RECORDS - 1)];
+        r.ms    = RDX_Platform::millis();
+        r.tag   = tag;
+        r.fmt   = fmt;
+        r.level = level;
+        r.nargs = sizeof...(Args);
+        int i = 0;
+        (void)i;
+        ((set(r, i++, args)), ...);
+        r.seq.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // log task (one reader): prints up to max records, returns how many
+    inline uint32_t drain(uint32_t max = RECORDS) {
+        const uint32_t lost = dropped_.exchange(0, std::memory_order_relaxed);
+        if (lost) ESP_LOGW("LOG", "%u records dropped, ring full", lost);
+        char line[192];
+        uint32_t n = 0;
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        for (; n < max; ++n, ++tail) {
+            Record& r = ring_[tail & (RECORDS - 1)];
+            if (r.seq.load(std::memory_order_acquire) != tail + 1) break;   // not written yet
+            format(r, line, sizeof(line));
+            const Level level = (Level)r.level;
+            const char* tag = r.tag;
+            const uint32_t ms = r.ms;
+            tail_.store(tail + 1, std::memory_order_release);                 // the slot is free again
+            switch (level) {
+                case LVL_ERROR: ESP_LOGE(tag, "[%u] %s", ms, line); break;
+                case LVL_WARN:  ESP_LOGW(tag, "[%u] %s", ms, line); break;
+                case LVL_INFO:  ESP_LOGI(tag, "[%u] %s", ms, line); break;
+                default:    ESP_LOGD(tag, "[%u] %s", ms, line); break;
+            }
+        }
+        return n;
+    }
+
+private:
+    enum Kind : uint8_t { INT32, UINT32, INT64, DOUBLE, STRING, POINTER };
+
+    struct Record {
+        std::atomic<uint32_t> seq {0};      // head index + 1 once written
+        uint32_t    ms = 0;
+        const char* tag = nullptr;
+        const char* fmt = nullptr;
+        uint8_t     level = 0;
+        uint8_t     nargs = 0;
+        uint8_t     kind[MAX_ARGS] = {};
+        union Arg { int64_t i; double d; const char* s; const void* p; } arg[MAX_ARGS] = {};
+    };
+
+    Record ring_[RECORDS];
+    std::atomic<uint32_t> head_ {0};        // next record to claim
+    std::atomic<uint32_t> tail_ {0};        // next record to print
+    std::atomic<uint32_t> dropped_ {0};
+
+    template <class T>
+    static inline IRAM_ATTR void set(Record& r, int i, T v) {
+        if constexpr (std::is_floating_point<T>::value) {
+            r.kind[i] = DOUBLE;
+            r.arg[i].d = v;
+        } else if constexpr (std::is_same<T, const char*>::value || std::is_same<T, char*>::value) {
+            r.kind[i] = STRING;
+            r.arg[i].s = v;
+        } else if constexpr (std::is_pointer<T>::value) {
+            r.kind[i] = POINTER;
+            r.arg[i].p = (const void*)v;
+        } else {
+            using I = typename std::conditional<std::is_enum<T>::value, int, T>::type;
+            r.kind[i] = sizeof(I) > 4 ? INT64 : std::is_signed<I>::value ? INT32 : UINT32;
+            r.arg[i].i = std::is_signed<I>::value ? (int64_t)(I)v : (int64_t)(uint64_t)(I)v;
+        }
+    }
+
+    // printf of the record, one conversion at a time with the argument's stored type
+    static inline void format(const Record& r, char* out, size_t size) {
+        size_t len = 0;
+        int next = 0;
+        auto room = [&] { return len < size ? size - len : 0; };
+        for (const char* f = r.fmt; *f && len + 1 < size; ++f) {
+            if (*f != '%') { out[len++] = *f; continue; }
+            if (f[1] == '%') { out[len++] = '%'; ++f; continue; }
+
+            char spec[24] = "%";
+            int sl = 1;
+            ++f;
+            while (*f && strchr("-+ #0123456789.", *f) && sl < 16) spec[sl++] = *f++;
+            while (*f && strchr("hlLqjzt", *f)) ++f;                 // length: from the stored type
+            const char conv = *f;
+            if (!conv) break;
+            if (next >= r.nargs) {                                   // more conversions than arguments
+                len += snprintf(out + len, room(), "?");
+                continue;
+            }
+            const int k = next++;
+            const Record::Arg& a = r.arg[k];
+            const uint8_t kind = r.kind[k];
+            int w = 0;
+            if (strchr("diouxXc", conv)) {
+                long long v = kind == DOUBLE ? (long long)a.d : (kind == STRING || kind == POINTER) ? 0 : a.i;
+                if (kind == INT32 && conv != 'd' && conv != 'i' && conv != 'c') v = (uint32_t)v;   // %x of a negative int
+                if (conv == 'c') {
+                    spec[sl++] = 'c';
+                    spec[sl] = 0;
+                    w = snprintf(out + len, room(), spec, (int)v);
+                } else {
+                    spec[sl++] = 'l';
+                    spec[sl++] = 'l';
+                    spec[sl++] = conv;
+                    spec[sl] = 0;
+                    w = snprintf(out + len, room(), spec, v);
+                }
+            } else if (strchr("fFeEgGaA", conv)) {
+                const double v = kind == DOUBLE ? a.d : (kind == STRING || kind == POINTER) ? 0.0 : (double)a.i;
+                spec[sl++] = conv;
+                spec[sl] = 0;
+                w = snprintf(out + len, room(), spec, v);
+            } else if (conv == 's') {
+                spec[sl++] = 's';
+                spec[sl] = 0;
+                w = snprintf(out + len, room(), spec, kind == STRING && a.s ? a.s : "?");
+            } else if (conv == 'p') {
+                w = snprintf(out + len, room(), "%p", kind == POINTER ? a.p : nullptr);
+            } else {
+                w = snprintf(out + len, room(), "?");
+            }
+            if (w > 0) len += w;
+        }
+        len = std::min(len, size - 1);
+        out[len] = 0;
+    }
+};
+
+#if RDX_LOG_LEVEL >= 1
+  #define RDX_LOGE(tag, fmt, ...)   RDX_Log::get().push(RDX_Log::LVL_ERROR, tag, fmt, ##__VA_ARGS__)
+#else
+  #define RDX_LOGE(tag, fmt, ...)   do {} while (0)
+#endif
+#if RDX_LOG_LEVEL >= 2
+  #define RDX_LOGW(tag, fmt, ...)   RDX_Log::get().push(RDX_Log::LVL_WARN, tag, fmt, ##__VA_ARGS__)
+#else
+  #define RDX_LOGW(tag, fmt, ...)   do {} while (0)
+#endif
+#if RDX_LOG_LEVEL >= 3
+  #define RDX_LOGI(tag, fmt, ...)   RDX_Log::get().push(RDX_Log::LVL_INFO, tag, fmt, ##__VA_ARGS__)
+#else
+  #define RDX_LOGI(tag, fmt, ...)   do {} while (0)
+#endif
+#if RDX_LOG_LEVEL >= 4
+  #define RDX_LOGD(tag, fmt, ...)   RDX_Log::get().push(RDX_Log::LVL_DEBUG, tag, fmt, ##__VA_ARGS__)
+#else
+  #define RDX_LOGD(tag, fmt, ...)   do {} while (0)
+#endif
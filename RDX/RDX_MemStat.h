@@ -0,0 +1,207 @@
+// RDX_MemStat.h
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include "RDX_Platform.h"
+#include "config.h"
+
+// =========================================================
+// Memory and stack telemetry for long sessions.
+//
+// Every SAMPLE_MS the log task takes a sample:
+//   dram, psram   free bytes, largest free block, lowest free
+//                 since boot, live allocated blocks
+//   stacks        high-water mark (bytes never touched) of
+//                 each task given to addTask()
+// into a ring of HISTORY samples (~64 min). It warns when
+//   - a region's largest free block reaches a new low, its
+//     ALERT_STEP below the last warning; the line carries the
+//     trend over the ring (least squares, bytes per hour) and
+//     the live blocks gained meanwhile
+//   - a task's stack headroom drops under STACK_WARN (once)
+//
+// heap_caps_get_info() walks the heap under its lock, so only
+// the log task samples. The Arduino core has no allocation
+// hooks built in: allocations show as live block counts per
+// region, and a count that climbs while free bytes stay flat
+// is churn leaving holes (preset loads, String and vector).
+//
+// latest() and at() copy a sample from any task under a
+// sequence lock, as RDX_Meter does.
+// =========================================================
+
+class RDX_MemStat {
+public:
+    static constexpr uint32_t SAMPLE_MS  = 30000;
+    static constexpr uint32_t HISTORY    = 128;         // power of two
+    static constexpr int      MAX_TASKS  = 6;
+    static constexpr uint32_t STACK_WARN = 512;
+    static constexpr uint32_t ALERT_STEP[2] = { 4096, 65536 };  // dram, psram
+
+    enum RegionId : uint8_t { DRAM, PSRAM, REGIONS };
+
+    struct Region {
+        uint32_t free;
+        uint32_t largest;
+        uint32_t minFree;
+        uint32_t blocks;        // live allocations
+    };
+
+    struct Sample {
+        uint32_t ms;
+        Region   region[REGIONS];
+        uint16_t stack[MAX_TASKS];
+    };
+
+    static RDX_MemStat& get() {
+        static RDX_MemStat instance;
+        return instance;
+    }
+
+    // once per task, before sampling starts
+    inline void addTask(TaskHandle_t task, const char* name) {
+        if (tasks_ >= MAX_TASKS || !task) return;
+        task_[tasks_] = task;
+        name_[tasks_] = name;
+        ++tasks_;
+    }
+
+    // log task: samples when one is due
+    inline void service() {
+        const uint32_t now = RDX_Platform::millis();
+        const uint32_t n = count_.load(std::memory_order_relaxed);
+        if (n && now - last_.ms < SAMPLE_MS) return;
+        Sample s {};
+        s.ms = now;
+        take(MALLOC_CAP_INTERNAL, s.region[DRAM]);
+        take(MALLOC_CAP_SPIRAM, s.region[PSRAM]);
+        for (int t = 0; t < tasks_; ++t) s.stack[t] = (uint16_t)std::min<uint32_t>(uxTaskGetStackHighWaterMark(task_[t]), 0xFFFF);
+
+        const uint32_t s0 = seq_.load(std::memory_order_relaxed);
+        seq_.store(s0 + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        ring_[n & (HISTORY - 1)] = s;
+        last_ = s;
+        count_.store(n + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        seq_.store(s0 + 2, std::memory_order_release);
+
+        check(s);
+    }
+
+    // ---- any task ----
+
+    inline uint32_t count() const { return std::min(count_.load(std::memory_order_relaxed), HISTORY); }
+    inline uint32_t alerts() const { return alerts_; }
+
+    inline bool latest(Sample& out) const { return copy(out, -1); }
+
+    // i = 0: the oldest sample in the ring
+    inline bool at(uint32_t i, Sample& out) const { return copy(out, (int)i); }
+
+    inline int tasks() const { return tasks_; }
+    inline const char* taskName(int t) const { return name_[t]; }
+
+    // least-squares slope of a region's largest free block over the ring, bytes per hour
+    inline float largestTrend(RegionId r) const {
+        const uint32_t n = count();
+        if (n < 3) return 0.f;
+        double sx = 0, sy = 0, sxx = 0, sxy = 0;
+        Sample s;
+        uint32_t t0 = 0;
+        for (uint32_t i = 0; i < n; ++i) {
+            if (!at(i, s)) return 0.f;
+            if (!i) t0 = s.ms;
+            const double x = (s.ms - t0) / 3600000.0, y = s.region[r].largest;
+            sx += x; sy += y; sxx += x * x; sxy += x * y;
+        }
+        const double d = n * sxx - sx * sx;
+        return d > 0 ? (float)((n * sxy - sx * sy) / d) : 0.f;
+    }
+
+    // the latest sample: both regions, then the stacks; nothing
+    // until the log task has taken a new one (one caller)
+    inline void log() {
+        const uint32_t n = count_.load(std::memory_order_relaxed);
+        if (n == logged_) return;
+        Sample s;
+        if (!latest(s)) return;
+        logged_ = n;
+        static const char* const REGION[REGIONS] = { "DRAM", "PSRAM" };
+        for (int r = 0; r < REGIONS; ++r) {
+            const Region& g = s.region[r];
+            ESP_LOGI("MEM", "%-5s free %u B, largest %u B, min %u B, %u blocks, largest trend %+.0f B/h", REGION[r],
+                     g.free, g.largest, g.minFree, g.blocks, largestTrend((RegionId)r));
+        }
+        char line[128];
+        int len = 0;
+        for (int t = 0; t < tasks_ && len < (int)sizeof(line) - 24; ++t) {
+            len += snprintf(line + len, sizeof(line) - len, " %s %u B", name_[t], s.stack[t]);
+        }
+        if (len) ESP_LOGI("MEM", "stack free:%s", line);
+    }
+
+private:
+    Sample   ring_[HISTORY] = {};
+    Sample   last_ = {};
+    std::atomic<uint32_t> count_ {0};       // samples taken
+    std::atomic<uint32_t> seq_ {0};
+    TaskHandle_t task_[MAX_TASKS] = {};
+    const char*  name_[MAX_TASKS] = {};
+    int      tasks_ = 0;
+    uint32_t alertLevel_[REGIONS] = {};     // largest free block at the last warning
+    uint32_t stackWarned_ = 0;              // task bits
+    uint32_t alerts_ = 0;
+    uint32_t logged_ = 0;                   // count_ at the last log()
+
+    static inline void take(uint32_t caps, Region& r) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, caps);
+        r.free = info.total_free_bytes;
+        r.largest = info.largest_free_block;
+        r.minFree = info.minimum_free_bytes;
+        r.blocks = info.allocated_blocks;
+    }
+
+    // i < 0: the latest sample
+    inline bool copy(Sample& out, int i) const {
+        for (int tries = 0; tries < 4; ++tries) {
+            const uint32_t s1 = seq_.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            const uint32_t n = count_.load(std::memory_order_relaxed);
+            const uint32_t held = std::min(n, HISTORY);
+            if (!n || (i >= 0 && (uint32_t)i >= held)) return false;
+            memcpy(&out, i < 0 ? &last_ : &ring_[(n - held + i) & (HISTORY - 1)], sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s1) return true;
+        }
+        return false;
+    }
+
+    inline void check(const Sample& s) {
+        static const char* const REGION[REGIONS] = { "DRAM", "PSRAM" };
+        Sample oldest;
+        at(0, oldest);
+        for (int r = 0; r < REGIONS; ++r) {
+            const uint32_t largest = s.region[r].largest;
+            if (count() == 1 || largest > alertLevel_[r]) {
+                alertLevel_[r] = std::max(alertLevel_[r], largest);
+                continue;
+            }
+            if (alertLevel_[r] - largest < ALERT_STEP[r]) continue;
+            ESP_LOGW("MEM", "%s largest free block down to %u B (from %u B), trend %+.0f B/h over %u min, %+d live blocks",
+                     REGION[r], largest, alertLevel_[r], largestTrend((RegionId)r), (s.ms - oldest.ms) / 60000,
+                     (int)(s.region[r].blocks - oldest.region[r].blocks));
+            alertLevel_[r] = largest;
+            ++alerts_;
+        }
+        for (int t = 0; t < tasks_; ++t) {
+            if (s.stack[t] >= STACK_WARN || (stackWarned_ & (1u << t))) continue;
+            ESP_LOGW("MEM", "task %s: %u B of stack left", name_[t], s.stack[t]);
+            stackWarned_ |= 1u << t;
+            ++alerts_;
+        }
+    }
+};
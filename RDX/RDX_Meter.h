@@ -0,0 +1,166 @@
+// RDX_Meter.h
+#pragma once
+#include <stdint.h>
+#include <cmath>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include "RDX_Platform.h"
+#include "config.h"
+
+// =========================================================
+// Level meters of the audio path, per block.
+//
+//   synth   RDX_Synth::renderAudioBlock() output
+//   fxN     FX slot N's output (0 while the slot is empty)
+//   out     the block as it leaves for the DAC
+//   voiceN  voice N's share of the synth bus (output gain in)
+//
+// Each tap holds the block's peak and mean square per channel
+// and a peak hold falling HOLD_DB_S dB per second. The audio
+// task measures into a staging copy and publishes it at the
+// end of the block under a sequence lock: a reader copies the
+// snapshot and retries if the audio task wrote meanwhile, so
+// the taps it gets belong to one block, at any read rate.
+//
+// Measuring costs a pass over the block per tap, and only
+// runs while someone reads: read() renews a lease of
+// LEASE_BLOCKS blocks, without reads the audio task skips the
+// taps (a branch each). Voice taps have their own lease
+// (read(s, true)); while it runs the synth renders through its
+// metered loop instead of the profiled one, so PROF_VOICE
+// pauses. Power-idle blocks publish nothing: the last levels
+// stay, and they were silent.
+// =========================================================
+
+enum RDX_MeterTap : uint8_t {
+    METER_SYNTH = 0,
+    METER_FX0,                                  // slot s: METER_FX0 + s
+    METER_OUT = METER_FX0 + FX_MAX_SLOTS,
+    METER_VOICE0,                               // voice v: METER_VOICE0 + v
+    METER_TAPS = METER_VOICE0 + MAX_VOICES
+};
+
+class RDX_Meter {
+public:
+    static constexpr uint32_t LEASE_BLOCKS = 128;   // ~0.4 s at 128 samples, 44.1 kHz
+    static constexpr float    HOLD_DB_S    = 20.0f;
+
+    struct Level {
+        float peak[2];      // L, R: largest |sample| of the block
+        float ms[2];        // mean square of the block
+        float hold[2];      // peak hold
+    };
+
+    struct Snapshot {
+        uint32_t block = 0;     // blocks published so far
+        Level    tap[METER_TAPS] = {};
+    };
+
+    static RDX_Meter& get() {
+        static RDX_Meter instance;
+        return instance;
+    }
+
+    inline void init(uint32_t sampleRate, uint32_t blockLen) {
+        holdDecay_ = powf(10.f, -HOLD_DB_S / 20.f * blockLen / sampleRate);
+    }
+
+    // ---- audio task ----
+
+    inline IRAM_ATTR bool listening() const { return listening_; }
+    inline IRAM_ATTR bool voicesListening() const { return voices_; }
+
+    inline IRAM_ATTR void tap(int id, const float* L, const float* R, uint32_t len) {
+        if (!listening_) return;
+        Level& lv = stage_.tap[id];
+        measure(L, len, lv.peak[0], lv.ms[0]);
+        measure(R, len, lv.peak[1], lv.ms[1]);
+    }
+
+    // voice taps are mono: the synth's metered loop has them per sample already
+    inline IRAM_ATTR void setVoice(int v, float peak, float ms) {
+        Level& lv = stage_.tap[METER_VOICE0 + v];
+        lv.peak[0] = lv.peak[1] = peak;
+        lv.ms[0] = lv.ms[1] = ms;
+    }
+
+    // end of a rendered block: the out tap, publish, then who listens to the next block
+    inline IRAM_ATTR void blockDone(const float* L, const float* R, uint32_t len) {
+        const uint32_t b = blocks_.load(std::memory_order_relaxed) + 1;
+        blocks_.store(b, std::memory_order_relaxed);
+        if (listening_) {
+            tap(METER_OUT, L, R, len);
+            publish(b);
+        }
+        listening_ = b - lastRead_.load(std::memory_order_relaxed) < LEASE_BLOCKS;
+        voices_ = listening_ && b - lastVoiceRead_.load(std::memory_order_relaxed) < LEASE_BLOCKS;
+        if (listening_) memset(stage_.tap, 0, sizeof(stage_.tap));
+    }
+
+    // ---- any other task ----
+
+    // the last published block; false if the audio task kept writing over it (retry later)
+    inline bool read(Snapshot& out, bool voices = false) {
+        const uint32_t b = blocks_.load(std::memory_order_relaxed);
+        lastRead_.store(b, std::memory_order_relaxed);
+        if (voices) lastVoiceRead_.store(b, std::memory_order_relaxed);
+        for (int tries = 0; tries < 4; ++tries) {
+            const uint32_t s1 = seq_.load(std::memory_order_acquire);
+            if (s1 & 1) continue;
+            memcpy(&out, &pub_, sizeof(out));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == s1) return true;
+        }
+        return false;
+    }
+
+    static inline float dB(float lin) { return 20.f * log10f(std::max(lin, 1e-6f)); }
+    static inline float rmsDb(float ms) { return 10.f * log10f(std::max(ms, 1e-12f)); }
+
+    static inline const char* name(int id) {
+        static const char* const names[METER_VOICE0] = { "synth", "fx0", "fx1", "fx2", "fx3", "out" };
+        return id < METER_VOICE0 ? names[id] : "voice";
+    }
+
+private:
+    Snapshot stage_;                        // audio task: the block being measured
+    Snapshot pub_;                          // under seq_
+    std::atomic<uint32_t> seq_ {0};         // odd while pub_ is written
+    std::atomic<uint32_t> lastRead_ {0u - LEASE_BLOCKS};
+    std::atomic<uint32_t> lastVoiceRead_ {0u - LEASE_BLOCKS};
+    std::atomic<uint32_t> blocks_ {0};      // written by the audio task only
+    bool  listening_ = false;
+    bool  voices_ = false;
+    float holdDecay_ = 0.99f;
+
+    static_assert(METER_VOICE0 == 6, "name() lists FX_MAX_SLOTS == 4 slots");
+
+    static inline IRAM_ATTR void measure(const float* x, uint32_t len, float& peak, float& ms) {
+        float p = 0.f, sq = 0.f;
+        for (uint32_t i = 0; i < len; ++i) {
+            p = std::max(p, fabsf(x[i]));
+            sq += x[i] * x[i];
+        }
+        peak = p;
+        ms = sq / len;
+    }
+
+    inline IRAM_ATTR void publish(uint32_t block) {
+        const uint32_t s = seq_.load(std::memory_order_relaxed);
+        seq_.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (int t = 0; t < METER_TAPS; ++t) {
+            Level& dst = pub_.tap[t];
+            const Level& src = stage_.tap[t];
+            for (int c = 0; c < 2; ++c) {
+                dst.peak[c] = src.peak[c];
+                dst.ms[c] = src.ms[c];
+                dst.hold[c] = std::max(src.peak[c], dst.hold[c] * holdDecay_);
+            }
+        }
+        pub_.block = block;
+        std::atomic_thread_fence(std::memory_order_release);
+        seq_.store(s + 2, std::memory_order_release);
+    }
+};
@@ -4,7 +4,11 @@
 #include <MIDI.h> 
 #include "RDX_State.h" // for RDX_State::getState()
 #include "RDX_Synth.h"
+#include "RDX_AudioConfig.h"
+#include "RDX_SysEx.h"
+#include "RDX_Power.h"
 #include "RDX_GUI.h"
+#include "RDX_Trace.h"
 
 
 extern RDX_Synth synth;   // defined in RDX.ino
@@ -23,159 +27,61 @@ extern RDX_GUI gui;
     USBMIDI_CREATE_INSTANCE(0, MIDI); // reface DX
 #endif
 
-constexpr uint32_t SYSEX_BUF_SIZE = 512;
-uint8_t syxBuf[SYSEX_BUF_SIZE];
-uint32_t syxLen = 0;
-
-// -----------------------------
-// Bulk dump helpers
-// -----------------------------
-inline void dumpSysex(const uint8_t* buf, uint32_t len, const char* tag = "SYSEX") {
-    ESP_LOGD(tag, "SysEx (%u bytes):", len);
-    char line[128];
-    uint32_t pos = 0;
-    for (uint32_t i = 0; i < len; i++) {
-        int n = snprintf(line + pos, sizeof(line) - pos, "%02X ", buf[i]);
-        pos += n;
-        if ((i + 1) % 16 == 0 || i + 1 == len) {
-            ESP_LOGD(tag, "%s", line);
-            pos = 0;
-        }
-    }
-}
-
-
-
-
-
-// ==========================
-// Helper: Send a single block (Model ID + Address + Data)
-// ==========================
-inline void sendBlock(uint8_t device, uint8_t addrH, uint8_t addrM, uint8_t addrL,
-                      const uint8_t* data, uint32_t dataLen)
-{
-    uint8_t byteCount = 1 + 3 + dataLen; // ModelID + AddrH/M/L + data
-    uint8_t syx[512];
-    uint8_t* w = syx;
-
-    *w++ = 0xF0;
-    *w++ = 0x43;
-    *w++ = device;
-    *w++ = 0x7F;
-    *w++ = 0x1C;
-    *w++ = (byteCount >> 7) & 0x7F;   // MSB
-    *w++ = byteCount & 0x7F;          // LSB
-    *w++ = 0x05;                       // Model ID
-    *w++ = addrH;
-    *w++ = addrM;
-    *w++ = addrL;
-    if (dataLen>0) memcpy(w, data, dataLen);
-    w += dataLen;
-    uint8_t chk = rdxSyxChecksum(syx + 7, 1 + 3 + dataLen); // ModelID+Addr+Data
-    *w++ = chk;
-    *w++ = 0xF7;
-
-    uint32_t len = w - syx;
-    dumpSysex(syx, len, "OUT");
-    MIDI.sendSysEx(len, syx, true);
-}
-
-// ==========================
-// Send Common Block
-// ==========================
-inline void sendCommonBlock(const RDX_Patch& patch, uint8_t device=0x00) {
-    sendBlock(device, 0x30, 0x00, 0x00, reinterpret_cast<const uint8_t*>(&patch.common), sizeof(RDX_Common));
-}
-
-// ==========================
-// Send Operator Block
-// ==========================
-inline void sendOperatorBlock(const RDX_Patch& patch, int opNum, uint8_t device=0x00) {
-    if (opNum < 0 || opNum > 3) return;
-    sendBlock(device, 0x31, opNum, 0x00, reinterpret_cast<const uint8_t*>(&patch.ops[opNum]), sizeof(RDX_OpParams));
-}
-
-// ==========================
-// Send Full Patch (Common + 4 Ops)
-// ==========================
-inline void sendFullPatch(const RDX_Patch& patch, uint8_t device=0x00) {
-    // Bulk Header 
-    sendBlock(device, 0x0e, 0x0f, 0x00, nullptr, 0);
+// ------------------- MIDI receive ---------------------
+// The MIDI task sleeps until input arrives: USB packets are moved into
+// MidiUSB's ring by TinyUSB's rx callback, stamped and followed by a
+// task notification; UART bytes stay in the driver's buffer and its
+// receive callback stamps and notifies. processMidi() then parses all
+// that is there and times each message from arrival to handled.
 
-    // Common + Ops
-    sendCommonBlock(patch, device);
-    for (int i = 0; i < 4; ++i) sendOperatorBlock(patch, i, device);
+struct MidiRxStats {
+    uint32_t messages = 0;
+    uint32_t sumUs    = 0;  // arrival -> handled
+    uint32_t maxUs    = 0;
+};
 
-    // Bulk Footer
-    sendBlock(device, 0x0f, 0x0f, 0x00, nullptr, 0);
-}
-
-inline void sendSystemBulk(uint8_t device = 0x00) {
-    SynthState& state = RDX_State::getState();
-    sendBlock(device, 0x00, 0x00, 0x00, reinterpret_cast<const uint8_t*>(&state.system), sizeof(state.system));
-}
-
-inline void sendBulkDump(uint8_t device, const RDX_Patch& patch) {
-    // 1) send SYSTEM bulk message
-    sendSystemBulk(0x00);
+static MidiRxStats midiRx;      // MIDI task only
 
-    // 2) send VOICE blocks (header, common, ops, footer)
-    sendFullPatch(patch, 0x00);
-}
+#if MIDI_IN_DEV == USE_MIDI_STANDARD
+static volatile uint32_t uartRxUs = 0;
+static TaskHandle_t uartRxTask = nullptr;
 
-inline void sendIdentityReply(uint8_t deviceId = 0x7F) {
-    // SysEx Identity Reply for Yamaha Reface DX 
-    // F0 7E 7F 06 02 43 00 41 53 06 00 00 00 7F F7
-    const uint8_t reply[] = {
-        0xF0,       // SysEx start
-        0x7E,       // Non-realtime
-        deviceId,   // Device ID (0x7F = all-call)
-        0x06, 0x02, // Sub-ID #1/#2: Identity Reply
-        0x43,       // Yamaha (0x43)
-        0x00, 0x41, // Family code
-        0x53, 0x06, // Model ID = Reface DX
-        0x03, 0x00, 0x00, 0x7F, // version = 1.0 + data[10] / 10.0
-        0xF7        // SysEx end
-    };
-    uint32_t delayMs = esp_random() % 64 ;
-    delay(delayMs);
-    dumpSysex(reply, sizeof(reply), "OUT ID");
-    MIDI.sendSysEx(sizeof(reply), reply, true);
+static void onUartRx() {
+    uartRxUs = micros();
+    if (uartRxTask) xTaskNotifyGive(uartRxTask);
 }
+#endif
 
-
-inline bool unpackCommonBlock(const uint8_t* data, uint32_t len, RDX_Patch& patch) {
-    if (len < 43) return false;
-    if (rdxSyxChecksum(data + 4, 38) != data[42]) return false;
-    memcpy(&patch.common, data + 4, 38);
-    return true;
+// arrival of the bytes the last parsed message came in with
+inline uint32_t midiArrivalUs() {
+#if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
+    return MidiUSB.lastArrivalUs();
+#else
+    return uartRxUs;
+#endif
 }
 
-inline bool unpackOperatorBlock(const uint8_t* data, uint32_t len, RDX_Patch& patch) {
-    if (len < 33) return false;
-    int opNum = data[2];
-    if (opNum < 0 || opNum > 3) return false;
-    if (rdxSyxChecksum(data + 4, 28) != data[32]) return false;
-    memcpy(&patch.ops[opNum], data + 4, 28);
-    return true;
+// once the MIDI task exists; until then it finds input on its timeout
+inline void setMidiRxTask(TaskHandle_t task) {
+#if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
+    MidiUSB.setRxTask(task);
+#else
+    uartRxTask = task;
+#endif
 }
 
-
-
-// -----------------------------
-//  apply single param
-// -----------------------------
-inline void applyCommonParam(RDX_Patch& patch, uint8_t addr, uint8_t val) {
-    if (addr >= sizeof(RDX_Common)) return;
-    reinterpret_cast<uint8_t*>(&patch.common)[addr] = val;
+// latency since the last call, then a new interval
+inline void logMidiRx() {
+    if (midiRx.messages) {
+        ESP_LOGI("MIDI", "%u messages, arrival to handled avg %u us, max %u us", midiRx.messages,
+                 midiRx.sumUs / midiRx.messages, midiRx.maxUs);
+    }
+#if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
+    if (MidiUSB.rxStalls()) ESP_LOGW("MIDI", "USB rx ring full %u times", MidiUSB.rxStalls());
+#endif
+    midiRx = MidiRxStats();
 }
 
-inline void applyOperatorParam(RDX_Patch& patch, int opNum, uint8_t addr, uint8_t val) {
-    if (opNum < 0 || opNum > 3) return;
-    if (addr >= sizeof(RDX_OpParams)) return;
-    reinterpret_cast<uint8_t*>(&patch.ops[opNum])[addr] = val;
-}
- 
 // ------------------- MIDI callbacks -------------------
 
 void handleAll(const midi::MidiInterface<usbMidi::usbMidiTransport>::MidiMessage& msg) {
@@ -184,90 +90,11 @@ void handleAll(const midi::MidiInterface<usbMidi::usbMidiTransport>::MidiMessage
 }
 
 inline void handleSysEx(byte* data, unsigned length) {
-    dumpSysex( data, length, "SYSEX IN");
-    if (length < 6 || data[0] != 0xF0 || data[length - 1] != 0xF7) return;
-
-    // ---------------- Identity Request ----------------
-    // F0 7E <device> 06 01 F7
-    if (data[1] == 0x7E && data[3] == 0x06 && data[4] == 0x01) {
-        ESP_LOGD("MIDI", "SysEx: Identity Request");
-        sendIdentityReply(0x7F);
-        return;
-    }
-
-    // ---------------- Yamaha header check ----------------
-    if (data[1] != 0x43) return;
-    uint8_t device = data[2];
-    if (data[3] != 0x7F || data[4] != 0x1C) return; // group mismatch
-
-    uint8_t typeNibble = (device >> 4) & 0x0F;
-    uint8_t addrH = (length > 6) ? data[6] : 0;
-    uint8_t addrM = (length > 7) ? data[7] : 0;
-    uint8_t addrL = (length > 8) ? data[8] : 0;
-    uint32_t addr = (addrH << 16) | (addrM << 8) | addrL;
-    
-    switch (typeNibble) {
-
-    // ===================================================
-    case 0x1: { // PARAMETER CHANGE (editor → us)
-    // ===================================================
-        if (length < 10) return;
-        uint8_t val = data[9];
-        if (addrH == 0x30) {
-            ESP_LOGD("IN", "Common param change: offset=0x%02X val=%d", addrL, val);
-            applyCommonParam(synth.currentPatch(), addrL, val);
-        } else if (addrH == 0x31) {
-            ESP_LOGD("IN", "Operator %d param change: offset=0x%02X val=%d", addrM, addrL, val);
-            applyOperatorParam(synth.currentPatch(), addrM, addrL, val);
-        } else {
-            ESP_LOGI("IN", "Unknown param change at addr=%02X%02X%02X", addrH, addrM, addrL);
-        }
-        // echo
-       // MIDI.sendSysEx(sizeof(data), data, true);
-        break;
-    }
-
-    // ===================================================
-    case 0x0: { // BULK DUMP (editor → us)
-    // ===================================================
-        ESP_LOGI("IN", "BulkDump received (%u bytes)", length);
-        // ModelID is data[7], Address is data[8..10], Data starts at [11]
-        // Here you’d call unpackCommonBlock/unpackOperatorBlock depending on addrH
-        break;
-    }
-
-    // ===================================================
-    case 0x2: { // DUMP REQUEST (editor → request us → reply with bulk)
-    // ===================================================
-        if (length < 10) return;
-        ESP_LOGI("IN", "DumpRequest 0x02 addr=%02X%02X%02X", addrH, addrM, addrL);
-        if (addr == 0x00000000) sendBulkDump(0x00, synth.currentPatch());  // 0x00000000 is a SYSTEM block request addr
-        if (addr == 0x000e0f00) sendFullPatch( synth.currentPatch()); // 0x0e0f00 is a VOICE block request addr
-        break;
-    }
-
-    // ===================================================
-    case 0x3: { // PARAMETER REQUEST (editor → request us → reply single block)
-    // ===================================================
-        if (length < 10) return;
-        ESP_LOGD("IN", "ParamRequest addr=%02X%02X%02X", addrH, addrM, addrL);
-        if (addrH == 0x30) {
-            sendCommonBlock(synth.currentPatch());
-        } else if (addrH == 0x31) {
-            sendOperatorBlock(synth.currentPatch(), addrM);
-        } else if (addrH == 0x0E) {
-            sendFullPatch(synth.currentPatch());
-        } else {
-            ESP_LOGI("IN", "Unhandled param request at addr=%02X%02X%02X", addrH, addrM, addrL);
-        }
-        break;
-    }
-
-    default:
-        ESP_LOGI("IN", "Unhandled SysEx device=0x%02X", device);
-        break;
-    }
+    RDX_TRACE_SYSEX(data, length);
+    if (!handleSysExMessage(data, length, synth.currentPatch())) return;
+#ifdef ENABLE_GUI
     gui.push();
+#endif
 }
 
 
@@ -276,8 +103,11 @@ void handleNoteOn(uint8_t channel, uint8_t note, uint8_t velocity) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
-    ESP_LOGD("MIDI", "Note on %d %d", note, velocity);
+    RDX_LOGD("MIDI", "Note on %d %d", note, velocity);
+    RDX_TRACE_MIDI(0x90 | ((channel - 1) & 0x0F), note, velocity);
+    RDX_Power::get().wake(RDX_Power::WAKE_MIDI);    // full clock before the voice starts
     synth.noteOn(note, velocity);
+    RDX_Power::get().noteOn();
 
     // Forward to Soundmondo / external MIDI
 //    MIDI.sendNoteOn(note, velocity, channel);
@@ -287,6 +117,7 @@ void handleNoteOff(uint8_t channel, uint8_t note, uint8_t velocity) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
+    RDX_TRACE_MIDI(0x80 | ((channel - 1) & 0x0F), note, velocity);
     synth.noteOff(note);
  
 }
@@ -295,6 +126,7 @@ void handleCC(uint8_t channel, uint8_t cc, uint8_t val) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
+    RDX_TRACE_MIDI(0xB0 | ((channel - 1) & 0x0F), cc, val);
     synth.processCC(channel, cc, val);
 }
 
@@ -302,6 +134,7 @@ void handlePB(uint8_t channel, int pb) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
+    RDX_TRACE_MIDI(0xE0 | ((channel - 1) & 0x0F), (pb + 8192) & 0x7F, ((pb + 8192) >> 7) & 0x7F);
     synth.updatePB(channel, pb);
 }
 
@@ -309,9 +142,20 @@ void handleProgChange(uint8_t channel, uint8_t pr) {
 #ifdef ENABLE_GUI
     gui.pause(20);
 #endif
+    RDX_TRACE_MIDI(0xC0 | ((channel - 1) & 0x0F), pr, 0);
     synth.programChange(channel, pr);
 }
 
+// SysEx replies out through the active transport, as raw bytes: a call carries
+// a chunk of SysExOut's stream (RDX_SysEx.h), not necessarily a whole message
+inline void sendSysExMidi(const uint8_t* data, uint32_t len) {
+#if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
+    MidiUSB.write(data, len);
+#else
+    Serial1.write(data, len);
+#endif
+}
+
 void setupMidi() {
 #if MIDI_IN_DEV == USE_USB_MIDI_DEVICE
   // Change USB Device Descriptor Parameter
@@ -332,8 +176,13 @@ void setupMidi() {
     MIDI.setHandlePitchBend(handlePB);
     MIDI.setHandleProgramChange(handleProgChange);    
     MIDI.setHandleSystemExclusive(handleSysEx);
+    sysexSender = sendSysExMidi;
   //  MIDI.setHandleMessage(handleAll);
     MIDI.begin(MIDI_CHANNEL_OMNI);
+#if MIDI_IN_DEV == USE_MIDI_STANDARD
+    Serial1.setRxTimeout(1);            // callback after one idle symbol, not a full FIFO
+    Serial1.onReceive(onUartRx, false);
+#endif
     delay(800);
 }
 
@@ -348,8 +197,20 @@ void keepAlive() {
 }
 
 
+// everything received since the last call, bounded so a SysEx flood can't starve the loop
 inline void processMidi() {
-    MIDI.read();
+    int n = 0;
+    while (MIDI.read()) {
+        RDX_Power::get().wake(RDX_Power::WAKE_MIDI);  // any message ends idle (note-ons already did)
+        const uint32_t us = micros() - midiArrivalUs();
+        midiRx.messages++;
+        midiRx.sumUs += us;
+        midiRx.maxUs = std::max(midiRx.maxUs, us);
+        if (++n == 64) {
+            xTaskNotifyGive(xTaskGetCurrentTaskHandle());   // the rest right after this loop
+            break;
+        }
+    }
     //keepAlive();
 }
 
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "misc.h"
+#include "RDX_Log.h"
 #include "RDX_Types.h"
 #include "RDX_State.h"
 #include "RDX_Envelope.h"
@@ -11,11 +12,11 @@
 // ===============================
 // RDX Operator (float-domain, uses RDX_GAIN)
 // ===============================
-class  IRAM_ATTR __attribute__((always_inline)) RDX_Operator {
+class  IRAM_ATTR RDX_Operator {
 public:
     RDX_Operator(int idx)
-        : idx_(idx),
-          params_(RDX_State::getState().workingPatch.ops[idx]) {}
+        : params_(RDX_State::getState().workingPatch.ops[idx]),
+          idx_(idx) {}
 
     inline void setParams( int note, int vel, float baseHz) {
         setFrequency(baseHz);
@@ -25,7 +26,7 @@ public:
         
         // Cache OUT LEVEL gain and feedback scale/sign to avoid per-sample table lookups
         outGain_  = rdxGain(params_.outLevel * velogain_ ) * scaling_;
-        ESP_LOGD("OP", "%d: scaling %f out %f (op level %d velo %d)", idx_, scaling, outGain_, params_.outLevel, vel ) ;
+        RDX_LOGD("OP", "%d: scaling %f out %f (op level %d velo %d)", idx_, scaling, outGain_, params_.outLevel, vel ) ;
         env_.initAEG(params_.egRate, params_.egLevel, true);
 
         fbRectify_ = (params_.fbType != RDX_FB_SAW) ; 
@@ -144,7 +145,7 @@ private:
 	}
 
 	inline IRAM_ATTR __attribute__((always_inline))	float expScale(float x) { 
-		return   (1.0f - std::expf(-4.0f * x)); 
+		return   (1.0f - expf(-4.0f * x)); 
 	}
 
     inline IRAM_ATTR __attribute__((always_inline)) float calcScalingFactor(uint8_t note, int8_t lDepth, RDX_ScaleCurve lCurve, int8_t rDepth, RDX_ScaleCurve rCurve) {
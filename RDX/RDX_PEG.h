@@ -1,6 +1,5 @@
 #pragma once
-#include <Arduino.h>
-#include "esp_log.h"
+#include "RDX_Platform.h"
 #include "RDX_Constants.h"
 
 class  RDX_PEG {
@@ -0,0 +1,53 @@
+// RDX_Platform.h
+#pragma once
+
+// =========================================================
+// Platform layer: what the engine takes from the board.
+//
+//   attributes  IRAM_ATTR, DRAM_ATTR
+//   logging     ESP_LOGE/W/I/D
+//   heap caps   heap_caps_malloc/calloc/free, MALLOC_CAP_*
+//   timing      RDX_Platform::cycles/cpuMHz/micros/millis
+//   tasks       RDX_Platform::sleepTicks/yieldTask, random32
+//   log level   RDX_Platform::debugLogs: ESP_LOGD compiled in
+//
+// On the S3 these are the Arduino core and ESP-IDF. With
+// RDX_HOST defined (the Linux build in /host) the same names
+// come from host/platform/rdx_host.h: stderr logging, malloc
+// for every capability, steady_clock timing, thread sleeps.
+// Engine headers include this instead of Arduino.h / esp_*.h.
+// =========================================================
+
+#ifdef RDX_HOST
+  #include "rdx_host.h"
+#else
+  #include <Arduino.h>      // attributes, FreeRTOS, esp_random()
+  #include <esp_log.h>
+  #include <esp_heap_caps.h>
+#endif
+
+struct RDX_Platform {
+#ifdef RDX_HOST
+    static inline uint32_t cycles()                 { return rdx_host::cycles(); }
+    static inline uint32_t cpuMHz()                 { return rdx_host::CPU_MHZ; }
+    static inline uint32_t micros()                 { return rdx_host::micros(); }
+    static inline uint32_t millis()                 { return rdx_host::micros() / 1000; }
+    static inline void     sleepTicks(uint32_t n)   { rdx_host::sleepMs(n); }  // 1 tick = 1 ms, as on the S3 build
+    static inline void     yieldTask()              { rdx_host::yield(); }
+    static inline uint32_t random32()               { return rdx_host::random32(); }
+    static constexpr bool  debugLogs()              { return false; }   // ESP_LOGD compiles out
+#else
+    static inline uint32_t cycles()                 { return ESP.getCycleCount(); }
+    static inline uint32_t cpuMHz()                 { return ESP.getCpuFreqMHz(); }
+    static inline uint32_t micros()                 { return ::micros(); }
+    static inline uint32_t millis()                 { return ::millis(); }
+    static inline void     sleepTicks(uint32_t n)   { vTaskDelay(n); }
+    static inline void     yieldTask()              { taskYIELD(); }
+    static inline uint32_t random32()               { return esp_random(); }
+  #ifdef ARDUHAL_LOG_LEVEL
+    static constexpr bool  debugLogs()              { return ARDUHAL_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_DEBUG; }
+  #else
+    static constexpr bool  debugLogs()              { return LOG_LOCAL_LEVEL >= ESP_LOG_DEBUG; }
+  #endif
+#endif
+};
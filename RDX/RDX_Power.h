@@ -0,0 +1,198 @@
+// RDX_Power.h
+#pragma once
+#include <Arduino.h>
+#include <algorithm>
+#include "esp_pm.h"
+#include "config.h"
+
+// =========================================================
+// Idle power saving, driven by engine activity.
+//
+// ACTIVE: full clock, the audio task renders every block.
+// IDLE:   entered after POWER_IDLE_MS of blocks with no voice
+//         sounding and nothing above one LSB out of the FX
+//         chain (tails decayed). The audio task skips synth
+//         and FX and sends silence, the CPU clock drops to
+//         POWER_IDLE_CPU_MHZ, MIDI/control/GUI loops slow down.
+//
+// Wake-up comes from the MIDI task (a message, before the
+// note is started; MIDI input notifies the task, which
+// sleeps between) or from a button/encoder edge interrupt,
+// and raises the clock before the state flips, so the next
+// block is rendered at full speed: a note is heard at most
+// one block late. Each wake is measured (first rendered block
+// latency, voices sounding in it) and logged from the MIDI
+// task; a note that started no voice is counted as lost.
+// Every wake-up bumps a generation: the audio task restarts
+// its silence count on it, and an idle request counted under
+// an older one is dropped, so a block that ran across the
+// wake-up can't put the engine to sleep under a new note.
+//
+// Clock control: an esp_pm CPU_FREQ_MAX lock when power
+// management is enabled in the core, setCpuFrequencyMhz()
+// from the MIDI task otherwise.
+// =========================================================
+
+class RDX_Power {
+public:
+    enum State : uint8_t { ACTIVE, IDLE };
+    enum Wake  : uint8_t { WAKE_NONE, WAKE_MIDI, WAKE_CONTROL };
+
+    struct Stats {
+        uint32_t idles       = 0;   // ACTIVE -> IDLE transitions
+        uint32_t wakes       = 0;   // IDLE -> ACTIVE transitions
+        uint32_t lost        = 0;   // wakes with notes received but no voice in the first block
+        uint32_t lastIdleMs  = 0;   // how long the last idle period lasted
+        uint32_t lastWakeUs  = 0;   // wake request -> first rendered block
+        uint32_t lastNotes   = 0;   // note-ons between the wake request and the first block
+        int      lastVoices  = 0;   // voices sounding in the first block
+        Wake     lastCause   = WAKE_NONE;
+    };
+
+    static RDX_Power& get() {
+        static RDX_Power instance;
+        return instance;
+    }
+
+    // setup(), before the tasks start; serviceTask is woken by the input interrupts
+    inline void init(uint32_t sampleRate, uint32_t blockLen, bool enabled) {
+        enabled_ = enabled && POWER_IDLE_MS > 0;
+        idleBlocks_ = (uint64_t)POWER_IDLE_MS * sampleRate / 1000 / blockLen;
+        maxMhz_ = getCpuFrequencyMhz();
+        if (!enabled_) {
+            ESP_LOGI("POWER", "Idle power saving off");
+            return;
+        }
+        esp_pm_config_t cfg = {};
+        cfg.max_freq_mhz = maxMhz_;
+        cfg.min_freq_mhz = POWER_IDLE_CPU_MHZ;
+        cfg.light_sleep_enable = false;   // the I2S clock must keep running
+        usePm_ = esp_pm_configure(&cfg) == ESP_OK
+              && esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "rdx-active", &lock_) == ESP_OK;
+        if (usePm_) esp_pm_lock_acquire(lock_);
+        ESP_LOGI("POWER", "Idle after %u ms of silence (%u blocks), %u -> %u MHz via %s",
+                 POWER_IDLE_MS, idleBlocks_, maxMhz_, POWER_IDLE_CPU_MHZ, usePm_ ? "esp_pm lock" : "setCpuFrequencyMhz");
+    }
+
+    inline void setServiceTask(TaskHandle_t task) { serviceTask_ = task; }
+
+    inline bool isIdle() const { return state_ == IDLE; }
+    inline const Stats& stats() const { return stats_; }
+
+    // audio task, after every rendered block
+    template <class Synth>
+    inline IRAM_ATTR void blockDone(const float* L, const float* R, uint32_t n, const Synth& synth) {
+        const uint32_t notes = notes_;          // before the voices: a note counted here has started its voice
+        const uint32_t gen = wakeGen_;          // before the silence count: a wake() from here on voids its request
+        if (gen != countGen_) {                 // woken since the last block: count the silence afresh
+            countGen_ = gen;
+            silentBlocks_ = 0;
+        }
+        const int voices = synth.activeVoices();
+        if (wakePending_) {
+            wakePending_ = false;
+            stats_.lastWakeUs = micros() - wakeUs_;
+            stats_.lastVoices = voices;
+            stats_.lastNotes  = notes;
+            if (notes && !voices) stats_.lost++;
+            report_ = true;
+        }
+        if (!enabled_) return;
+        if (voices || peak(L, R, n) >= SILENCE) {
+            silentBlocks_ = 0;
+        } else if (++silentBlocks_ == idleBlocks_) {
+            idleGen_ = gen;
+            idleRequest_ = true;
+        }
+    }
+
+    // MIDI task, before the event is handed to the synth
+    inline void wake(Wake cause) {
+        wakeGen_ = wakeGen_ + 1;   // the audio task restarts its silence count
+        idleRequest_ = false;
+        if (state_ == ACTIVE) return;
+        if (usePm_) esp_pm_lock_acquire(lock_);
+        else setCpuFrequencyMhz(maxMhz_);
+        wakeUs_ = micros();
+        notes_ = 0;
+        stats_.lastCause = cause;
+        stats_.lastIdleMs = millis() - idleSinceMs_;
+        stats_.wakes++;
+        wakePending_ = true;
+        state_ = ACTIVE;    // last: the clock is already up when the audio task sees it
+    }
+
+    // after synth.noteOn(): counts the notes of a wake-up, to tell whether they made it into the first block
+    inline void noteOn() { if (wakePending_) notes_++; }
+
+    // button/encoder edge; the MIDI task does the wake-up
+    inline IRAM_ATTR void wakeFromISR() {
+        if (state_ != IDLE || !serviceTask_) return;
+        wakeIsr_ = true;
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(serviceTask_, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+
+    // MIDI task, every loop: applies requested transitions, logs finished wake-ups
+    inline void service() {
+        if (wakeIsr_) {
+            wakeIsr_ = false;
+            wake(WAKE_CONTROL);
+        }
+        if (idleRequest_ && state_ == ACTIVE) {
+            idleRequest_ = false;
+            // a request counted before the last wake() is stale: the block that made it hadn't seen the wake-up
+            if (idleGen_ == wakeGen_) {
+                state_ = IDLE;  // first: no block is rendered at the lower clock
+                if (usePm_) esp_pm_lock_release(lock_);
+                else setCpuFrequencyMhz(POWER_IDLE_CPU_MHZ);
+                idleSinceMs_ = millis();
+                stats_.idles++;
+                ESP_LOGI("POWER", "-> IDLE (#%u), %u MHz", stats_.idles, POWER_IDLE_CPU_MHZ);
+            }
+        }
+        if (report_) {
+            report_ = false;
+            ESP_LOGI("POWER", "-> ACTIVE (#%u, %s) after %u ms idle: first block +%u us, %u note(s), %d voice(s)",
+                     stats_.wakes, stats_.lastCause == WAKE_MIDI ? "MIDI" : "control", stats_.lastIdleMs,
+                     stats_.lastWakeUs, stats_.lastNotes, stats_.lastVoices);
+            if (stats_.lastNotes && !stats_.lastVoices) ESP_LOGW("POWER", "note(s) lost on wake-up, %u so far", stats_.lost);
+        }
+    }
+
+    // MIDI task loop pause: until MIDI input or an input edge notifies the task, or
+    // MIDI_SERVICE_MS (POWER_IDLE_POLL_MS while idle) for the control scan and FX service
+    inline void pause() {
+        ulTaskNotifyTake(pdTRUE, std::max<TickType_t>(1, pdMS_TO_TICKS(state_ == IDLE ? POWER_IDLE_POLL_MS : MIDI_SERVICE_MS)));
+    }
+
+private:
+    static constexpr float SILENCE = 1.0f / 32768.0f;   // one 16-bit LSB
+
+    static inline IRAM_ATTR float peak(const float* L, const float* R, uint32_t n) {
+        float p = 0.f;
+        for (uint32_t i = 0; i < n; ++i) p = fmaxf(p, fmaxf(fabsf(L[i]), fabsf(R[i])));
+        return p;
+    }
+
+    volatile State      state_          = ACTIVE;
+    volatile bool       idleRequest_    = false;   // audio task -> MIDI task
+    volatile bool       wakeIsr_        = false;   // input ISR -> MIDI task
+    volatile bool       wakePending_    = false;   // MIDI task -> audio task: measure the next block
+    volatile bool       report_         = false;   // audio task -> MIDI task: log the wake-up
+    uint32_t            silentBlocks_   = 0;       // audio task
+    uint32_t            countGen_       = 0;       // audio task: wakeGen_ silentBlocks_ counts under
+    volatile uint32_t   notes_          = 0;
+    volatile uint32_t   wakeGen_        = 0;       // MIDI task: bumped by every wake()
+    volatile uint32_t   idleGen_        = 0;       // audio task: wakeGen_ the idle request was counted under
+    uint32_t            idleBlocks_     = 0;
+    uint32_t            wakeUs_         = 0;
+    uint32_t            idleSinceMs_    = 0;
+    uint32_t            maxMhz_         = 240;
+    bool                enabled_        = false;
+    bool                usePm_          = false;
+    esp_pm_lock_handle_t lock_          = nullptr;
+    TaskHandle_t        serviceTask_    = nullptr;
+    Stats               stats_;
+};
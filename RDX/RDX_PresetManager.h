@@ -1,5 +1,5 @@
 #pragma once
-#include <Arduino.h>
+#include "RDX_Platform.h"
 #include <FS.h>
 #include <LittleFS.h>
 #include <SD_MMC.h>
@@ -44,7 +44,7 @@ public:
                 }
                 entry.close();
             }
-            ESP_LOGI("PM","Opened DIR: %s, %d files", path, entries_.size());
+            ESP_LOGI("PM","Opened DIR: %s, %u files", path, (unsigned)entries_.size());
             return !entries_.empty();
         } 
         else {
@@ -75,7 +75,7 @@ public:
             }
 
             delete[] buf;
-            ESP_LOGI("PM","Opened DUMP: %s, %d patches", path, entries_.size());
+            ESP_LOGI("PM","Opened DUMP: %s, %u patches", path, (unsigned)entries_.size());
             return !entries_.empty();
         }
     }
@@ -157,7 +157,7 @@ private:
         f.read(buf, len);
         bool ok = syxToPatch(buf, len, patch);
         delete[] buf;
-        ESP_LOGI("PM","[DIR] idx %d/%d: %s", currentIndex_, entries_.size(), fname.c_str());
+        ESP_LOGI("PM","[DIR] idx %d/%u: %s", currentIndex_, (unsigned)entries_.size(), fname.c_str());
         return ok;
     }
 
@@ -170,7 +170,7 @@ private:
         f.read(buf, len);
         bool ok = syxToPatch(buf + offset, len - offset, patch);
         delete[] buf;
-        ESP_LOGI("PM","[DUMP] idx %d/%d, offset=%u", currentIndex_, entries_.size(), (unsigned)offset);
+        ESP_LOGI("PM","[DUMP] idx %d/%u, offset=%u", currentIndex_, (unsigned)entries_.size(), (unsigned)offset);
         return ok;
     }
 };
@@ -0,0 +1,269 @@
+// RDX_Profiler.h
+#pragma once
+#include <stdint.h>
+#include <cstdio>
+#include <atomic>
+#include <algorithm>
+#include "RDX_Platform.h"
+#include "config.h"
+
+// =========================================================
+// Per-stage cycle profile of the audio task.
+//
+//   block   one rendered block, synth + FX (+ input): the
+//           work the deadline is about. A block over the
+//           budget (block length at the sample rate, in
+//           cycles) counts as an xrun.
+//   synth   RDX_Synth::renderAudioBlock()
+//   lfo     the voices' LFO updates, once per block
+//   voice   one sounding voice stepped through a block
+//   fxN     FX slot N (FXHost::process, sends included)
+//   i2s     writeBuffers(): conversion and channel write,
+//           waiting for DMA space included (buffered mode;
+//           zero-copy converts inside the last FX stage)
+//
+// Each stage keeps count, min, max, sum and a histogram of
+// half-octave bins from 64 cycles up, all written by the
+// audio task alone with plain (relaxed) stores: no lock, no
+// read-modify-write. Another task reads with read() or log()
+// and asks for a new interval with reset(), which the audio
+// task applies at its next blockStart(). Fields of one stage
+// are not read as a set, count and sum can be one record
+// apart; sums are 32-bit, so read at least every few seconds.
+//
+// RDX_PROFILE (config.h) off: the class is gone and the
+// RDX_PROF_* macros expand to nothing. Per-voice timing reads
+// the cycle counter twice per voice and sample: a few cycles
+// on the S3, tens of ns on the host (steady_clock). init()
+// measures what one such timing costs; the code that times
+// reports how many it did with discount(), and the block and
+// every scope around it (synth) leave that much out, so the
+// block figures and the xrun count are the render's own.
+// =========================================================
+
+enum RDX_ProfStage : uint8_t {
+    PROF_BLOCK = 0,
+    PROF_SYNTH,
+    PROF_LFO,
+    PROF_VOICE,
+    PROF_FX0,                               // slot s: PROF_FX0 + s
+    PROF_I2S = PROF_FX0 + FX_MAX_SLOTS,
+    PROF_STAGES
+};
+
+#ifdef RDX_PROFILE
+
+class RDX_Profiler {
+public:
+    static constexpr int MIN_LOG2 = 6;      // bin 0: under 96 cycles
+    static constexpr int BINS     = 36;     // last bin: 2^23 * 1.5 cycles and over (~50 ms at 240 MHz)
+
+    struct Stats {
+        uint32_t count = 0;
+        uint32_t min   = 0;
+        uint32_t max   = 0;
+        uint32_t avg   = 0;
+        uint32_t hist[BINS] = {};
+    };
+
+    static RDX_Profiler& get() {
+        static RDX_Profiler instance;
+        return instance;
+    }
+
+    // before the audio task starts
+    inline void init(uint32_t sampleRate, uint32_t blockLen) {
+        budgetCycles_ = (uint32_t)((uint64_t)blockLen * RDX_Platform::cpuMHz() * 1000000ull / sampleRate);
+        timingCycles_ = measureTiming();
+        clear();
+        ESP_LOGI("PROF", "Profiling on: %u-sample blocks, %u cycles budget, %u cycles per timed section",
+                 blockLen, budgetCycles_, timingCycles_);
+    }
+
+    // ---- audio task ----
+
+    inline IRAM_ATTR uint32_t blockStart() {
+        const uint32_t req = resetReq_.load(std::memory_order_acquire);
+        if (req != resetAck_) {
+            clear();
+            resetAck_ = req;
+        }
+        overhead_ = 0;
+        return RDX_Platform::cycles();
+    }
+
+    inline IRAM_ATTR void blockEnd(uint32_t start) {
+        const uint32_t c = RDX_Platform::cycles() - start - overhead_;
+        record(PROF_BLOCK, c);
+        if (c > budgetCycles_) store(xruns_, xruns_.load(std::memory_order_relaxed) + 1);
+    }
+
+    inline IRAM_ATTR __attribute__((always_inline)) void record(int stage, uint32_t cycles) {
+        Stage& s = stages_[stage];
+        const uint32_t n = s.count.load(std::memory_order_relaxed);
+        if (!n || cycles < s.min.load(std::memory_order_relaxed)) store(s.min, cycles);
+        if (cycles > s.max.load(std::memory_order_relaxed)) store(s.max, cycles);
+        store(s.sum, s.sum.load(std::memory_order_relaxed) + cycles);
+        std::atomic<uint32_t>& h = s.hist[bin(cycles)];
+        store(h, h.load(std::memory_order_relaxed) + 1);
+        store(s.count, n + 1);
+    }
+
+    // n sections were timed with a cycles() pair each: their cost is left out of the block and the open scopes
+    inline IRAM_ATTR void discount(uint32_t n) { overhead_ += n * timingCycles_; }
+
+    // profiler cost inside the current block so far, cycles
+    inline IRAM_ATTR uint32_t overhead() const { return overhead_; }
+
+    // times the enclosing block into a stage
+    class Scope {
+    public:
+        inline IRAM_ATTR explicit Scope(int stage)
+            : stage_(stage), overhead_(RDX_Profiler::get().overhead()), start_(RDX_Platform::cycles()) {}
+        inline IRAM_ATTR ~Scope() {
+            RDX_Profiler& p = RDX_Profiler::get();
+            p.record(stage_, RDX_Platform::cycles() - start_ - (p.overhead() - overhead_));
+        }
+    private:
+        int      stage_;
+        uint32_t overhead_;
+        uint32_t start_;
+    };
+
+    // ---- any other task ----
+
+    inline void read(int stage, Stats& out) const {
+        const Stage& s = stages_[stage];
+        out.count = s.count.load(std::memory_order_relaxed);
+        out.min   = s.min.load(std::memory_order_relaxed);
+        out.max   = s.max.load(std::memory_order_relaxed);
+        out.avg   = out.count ? s.sum.load(std::memory_order_relaxed) / out.count : 0;
+        for (int b = 0; b < BINS; ++b) out.hist[b] = s.hist[b].load(std::memory_order_relaxed);
+    }
+
+    inline uint32_t xruns() const { return xruns_.load(std::memory_order_relaxed); }
+    inline uint32_t budgetCycles() const { return budgetCycles_; }
+
+    // starts a new interval at the audio task's next block
+    inline void reset() { resetReq_.fetch_add(1, std::memory_order_release); }
+
+    static inline const char* name(int stage) {
+        static const char* const names[PROF_STAGES] = { "block", "synth", "lfo", "voice", "fx0", "fx1", "fx2", "fx3", "i2s" };
+        return names[stage];
+    }
+
+    // lowest cycle count of a bin (bin + 1: the bin's upper edge)
+    static inline uint32_t binFloor(int b) {
+        if (b <= 0) return 0;
+        const int msb = MIN_LOG2 + b / 2;
+        return (b & 1) ? (1u << msb) + (1u << (msb - 1)) : (1u << msb);
+    }
+
+    // upper edge of the bin holding the fraction q of the records
+    static inline uint32_t percentile(const Stats& st, float q) {
+        const uint32_t target = (uint32_t)(st.count * q);
+        uint32_t seen = 0;
+        for (int b = 0; b < BINS; ++b) {
+            seen += st.hist[b];
+            if (seen > target) return b + 1 < BINS ? binFloor(b + 1) : st.max;
+        }
+        return st.max;
+    }
+
+    // one line per stage that ran, the block histogram, then a new interval
+    inline void log(bool restart = true) {
+        const float mhz = (float)RDX_Platform::cpuMHz();
+        Stats st;
+        for (int s = 0; s < PROF_STAGES; ++s) {
+            read(s, st);
+            if (!st.count) continue;
+            ESP_LOGI("PROF", "%-5s %7u x  min %7.1f  avg %7.1f  max %7.1f  p50 <%7.1f  p99 <%7.1f us", name(s), st.count,
+                     st.min / mhz, st.avg / mhz, st.max / mhz, percentile(st, 0.5f) / mhz, percentile(st, 0.99f) / mhz);
+        }
+        read(PROF_BLOCK, st);
+        if (st.count) {
+            ESP_LOGI("PROF", "load avg %u%% max %u%% of %.0f us, %u xruns", (uint32_t)(100ull * st.avg / budgetCycles_),
+                     (uint32_t)(100ull * st.max / budgetCycles_), budgetCycles_ / mhz, xruns());
+            char line[160];
+            int len = 0;
+            for (int b = 0; b < BINS && len < (int)sizeof(line) - 24; ++b) {
+                if (st.hist[b]) len += snprintf(line + len, sizeof(line) - len, " %.0f:%u", binFloor(b) / mhz, st.hist[b]);
+            }
+            if (len) ESP_LOGI("PROF", "block us:%s", line);
+        }
+        if (restart) reset();
+    }
+
+private:
+    struct Stage {
+        std::atomic<uint32_t> count {0};
+        std::atomic<uint32_t> min {0};
+        std::atomic<uint32_t> max {0};
+        std::atomic<uint32_t> sum {0};
+        std::atomic<uint32_t> hist[BINS] = {};
+    };
+
+    Stage    stages_[PROF_STAGES];
+    std::atomic<uint32_t> xruns_ {0};       // total, survives reset()
+    std::atomic<uint32_t> resetReq_ {0};    // bumped by the reader
+    uint32_t resetAck_ = 0;                 // audio task: last request applied
+    uint32_t budgetCycles_ = 0;
+    uint32_t timingCycles_ = 0;             // one timed section's cycles() pair
+    uint32_t overhead_ = 0;                 // audio task: discounted cycles in this block
+
+    static_assert(PROF_STAGES == 9, "name() lists FX_MAX_SLOTS == 4 slots");
+
+    static inline IRAM_ATTR __attribute__((always_inline)) void store(std::atomic<uint32_t>& a, uint32_t v) {
+        a.store(v, std::memory_order_relaxed);
+    }
+
+    static inline IRAM_ATTR __attribute__((always_inline)) int bin(uint32_t c) {
+        if (c < (3u << (MIN_LOG2 - 1))) return 0;
+        const int msb = 31 - __builtin_clz(c);
+        return std::min(BINS - 1, (msb - MIN_LOG2) * 2 + (int)((c >> (msb - 1)) & 1));
+    }
+
+    // best of a few runs of an empty timed section, as renderProfiled() times a voice
+    static inline uint32_t measureTiming() {
+        constexpr int N = 64;
+        uint32_t best = UINT32_MAX;
+        for (int run = 0; run < 8; ++run) {
+            volatile uint32_t sink = 0;
+            const uint32_t t0 = RDX_Platform::cycles();
+            for (int i = 0; i < N; ++i) {
+                const uint32_t t = RDX_Platform::cycles();
+                sink = sink + (RDX_Platform::cycles() - t);
+            }
+            best = std::min(best, (RDX_Platform::cycles() - t0) / N);
+        }
+        return best;
+    }
+
+    inline void clear() {
+        for (Stage& s : stages_) {
+            store(s.count, 0);
+            store(s.min, 0);
+            store(s.max, 0);
+            store(s.sum, 0);
+            for (auto& h : s.hist) store(h, 0);
+        }
+    }
+};
+
+#define RDX_PROF_CONCAT2(a, b)          a##b
+#define RDX_PROF_CONCAT(a, b)           RDX_PROF_CONCAT2(a, b)
+#define RDX_PROF_SCOPE(stage)           RDX_Profiler::Scope RDX_PROF_CONCAT(profScope_, __LINE__)(stage)
+#define RDX_PROF_RECORD(stage, cycles)  RDX_Profiler::get().record((stage), (cycles))
+#define RDX_PROF_BLOCK_START()          const uint32_t profBlockStart_ = RDX_Profiler::get().blockStart()
+#define RDX_PROF_BLOCK_END()            RDX_Profiler::get().blockEnd(profBlockStart_)
+#define RDX_PROF_OVERHEAD()             RDX_Profiler::get().overhead()
+
+#else
+
+#define RDX_PROF_SCOPE(stage)           do {} while (0)
+#define RDX_PROF_RECORD(stage, cycles)  do {} while (0)
+#define RDX_PROF_BLOCK_START()          do {} while (0)
+#define RDX_PROF_BLOCK_END()            do {} while (0)
+#define RDX_PROF_OVERHEAD()             0u
+
+#endif // RDX_PROFILE
@@ -1,12 +1,18 @@
 // RDX_Synth.h
 #pragma once
-#include <Arduino.h>
+#include "RDX_Platform.h"
 #include "config.h"
 #include "RDX_Voice.h"
 #include "RDX_Types.h"
 #include "RDX_State.h"
 #include "RDX_VoiceAlloc.h"
+#include "RDX_PresetManager.h"
+#include "RDX_Profiler.h"
+#include "RDX_Trace.h"
+#include "RDX_Meter.h"
+#ifdef ENABLE_GUI
 #include "RDX_GUI.h"
+#endif
 
 
 #ifdef ENABLE_GUI
@@ -31,6 +37,7 @@ public:
             voices_[i].init();
         }
         state_.workingPatch = patch; 
+        RDX_TRACE_PATCH(patch);
         calcOutputGain();
         state_.storedPatch = patch;
 #ifdef ENABLE_GUI
@@ -65,18 +72,71 @@ public:
     }
 
 	inline IRAM_ATTR __attribute__((always_inline, hot))  void renderAudioBlock(float* outL, float* outR, uint32_t len = DMA_BUFFER_LEN) {
-		float sample = 0.f;
-        for (int i = 0; i < VOICES; i++) {
-            voices_[i].updateLfo();
+		RDX_PROF_SCOPE(PROF_SYNTH);
+        {
+            RDX_PROF_SCOPE(PROF_LFO);
+            for (int i = 0; i < VOICES; i++) {
+                voices_[i].updateLfo(len);
+            }
         }
-		for (int i = 0; i < len; ++i) {
-            sample = process();  // sum of active voices
-
-            outL[i] = sample;
-            outR[i] = sample;
-		}
+        if (RDX_Meter::get().voicesListening()) {
+            renderMetered(outL, outR, len);
+        } else {
+#ifdef RDX_PROFILE
+            renderProfiled(outL, outR, len);
+#else
+            for (uint32_t i = 0; i < len; ++i) {
+                const float sample = process();  // sum of active voices
+
+                outL[i] = sample;
+                outR[i] = sample;
+            }
+#endif
+        }
+        RDX_Meter::get().tap(METER_SYNTH, outL, outR, len);
 	}
 
+    // the sample loop above with each voice's contribution measured, while someone reads voice levels
+    inline IRAM_ATTR void renderMetered(float* outL, float* outR, uint32_t len) {
+        float peak[MAX_VOICES] = {};
+        float sq[MAX_VOICES] = {};
+        const float outGain = outputGain_;
+        for (uint32_t i = 0; i < len; ++i) {
+            float mix = 0.f;
+            for (int v = 0; v < VOICES; v++) {
+                const float s = voices_[v].step() * outGain;
+                mix += s;
+                peak[v] = std::max(peak[v], fabsf(s));
+                sq[v] += s * s;
+            }
+            outL[i] = mix;
+            outR[i] = mix;
+        }
+        for (int v = 0; v < VOICES; v++) RDX_Meter::get().setVoice(v, peak[v], sq[v] / len);
+    }
+
+#ifdef RDX_PROFILE
+    // the sample loop above with each voice's steps timed; sounding voices go to PROF_VOICE
+    inline IRAM_ATTR void renderProfiled(float* outL, float* outR, uint32_t len) {
+        uint32_t cycles[MAX_VOICES] = {};
+        const float outGain = outputGain_;
+        for (uint32_t i = 0; i < len; ++i) {
+            float mix = 0.f;
+            for (int v = 0; v < VOICES; v++) {
+                const uint32_t t = RDX_Platform::cycles();
+                mix += voices_[v].step() * outGain;
+                cycles[v] += RDX_Platform::cycles() - t;
+            }
+            outL[i] = mix;
+            outR[i] = mix;
+        }
+        for (int v = 0; v < VOICES; v++) {
+            if (voices_[v].isActive()) RDX_PROF_RECORD(PROF_VOICE, cycles[v]);
+        }
+        RDX_Profiler::get().discount(len * VOICES);    // the timing above isn't the synth's
+    }
+#endif
+
 
     inline void updateCache() {
         voices_[voiceUpdateIdx_].cacheParams();
@@ -179,9 +239,9 @@ public:
             p.ops[i].freqDetune = freqDetune[i];
 
             // Replace memcpy for reserved
-            p.ops[i].reserved[0] = 0;
-            p.ops[i].reserved[1] = 0;
-            p.ops[i].reserved[2] = 0;
+            p.ops[i].reserved[0] = reserved[i][0];
+            p.ops[i].reserved[1] = reserved[i][1];
+            p.ops[i].reserved[2] = reserved[i][2];
         }
 		return p;
 	}
@@ -349,6 +409,12 @@ public:
     }
     RDX_Voice& getVoice(int idx)  {return voices_[idx];}
 
+    inline int activeVoices() const {
+        int n = 0;
+        for (int i = 0; i < VOICES; i++) n += voices_[i].isActive();
+        return n;
+    }
+
 private:
     RDX_Voice           voices_[MAX_VOICES];
     RDX_VoiceAllocator  voiceAlloc_;
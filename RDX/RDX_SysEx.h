@@ -0,0 +1,386 @@
+// RDX_SysEx.h
+#pragma once
+#include "RDX_Platform.h"
+#include "RDX_Types.h"
+#include "RDX_State.h"
+#include "RDX_AudioConfig.h"
+#include "config.h"
+
+// =========================================================
+// reface DX SysEx: bulk/parameter blocks out, parameter
+// changes and requests in. No MIDI transport here: replies
+// go to sysexSender, incoming messages come through
+// handleSysExMessage(), so the same code runs on the host.
+//
+// Replies are streamed: SysExOut collects CHUNK bytes and
+// hands them on, so a dump is never built whole and several
+// messages (a full patch, a bulk dump) share the transfers.
+//
+// Past the reface map, a parameter request to address
+// 7E 00 00 (RDX_SYX_TELEMETRY) answers with a block of live
+// performance figures from sysexTelemetry; see
+// host/tools/rdx_telemetry.py. Parameter changes to 7D <slot>
+// <param> (RDX_SYX_FX_SLOT) set up the FX slots the patch
+// doesn't cover, through sysexFxSlot.
+// =========================================================
+
+// where outgoing bytes go: the MIDI transport on the device (RDX_Midi.h),
+// whatever the caller wants on the host. A call carries a part of the
+// stream, messages can start and end anywhere in it.
+using SysExSender = void (*)(const uint8_t* data, uint32_t len);
+inline SysExSender sysexSender = nullptr;
+
+// -----------------------------
+// Telemetry (vendor range)
+// -----------------------------
+// The reply block holds TELE_FIELDS values of 32 bits, each as five
+// 7-bit bytes, low bits first. Fields only get appended: a reader
+// takes TELE_VERSION and the block length, and ignores what it
+// doesn't know.
+constexpr uint8_t  RDX_SYX_TELEMETRY = 0x7E;    // addrH
+constexpr uint32_t RDX_TELEMETRY_VERSION = 1;
+
+enum RDX_TelemetryField : uint8_t {
+    TELE_VERSION = 0,
+    TELE_UPTIME_MS,
+    TELE_BUDGET_US,         // one block's audio time
+    TELE_BLOCK_MIN_US,      // render time of a block (synth + FX) since the last
+    TELE_BLOCK_AVG_US,      //   telemetry request (RDX_BlockTimer, always on;
+    TELE_BLOCK_MAX_US,      //   each request starts a new interval)
+    TELE_BLOCKS,            // blocks in the interval
+    TELE_XRUNS,             // blocks over the budget since boot
+    TELE_UNDERRUNS,         // I2S blocks replayed since boot
+    TELE_VOICE_CAP,         // polyphony the FX budget leaves (VOICES)
+    TELE_VOICES_ACTIVE,
+    TELE_IDLE,              // 1 while the power manager has rendering stopped
+    TELE_CPU_MHZ,
+    TELE_FX0_US,            // slot s: TELE_FX0_US + s, measured cost per block, 0 when empty
+    TELE_DRAM_FREE = TELE_FX0_US + FX_MAX_SLOTS,
+    TELE_DRAM_LARGEST,
+    TELE_PSRAM_FREE,
+    TELE_PSRAM_LARGEST,
+    TELE_MIDI_AVG_US,       // MIDI input, arrival to handled, since the last state report
+    TELE_MIDI_MAX_US,
+    TELE_FIELDS
+};
+
+// fills all TELE_FIELDS values; set by the firmware, nullptr: requests are ignored
+using SysExTelemetry = void (*)(uint32_t* fields);
+inline SysExTelemetry sysexTelemetry = nullptr;
+
+// -----------------------------
+// Extra FX slots (vendor range)
+// -----------------------------
+// 7D <slot> <param> <value>: slot FX_SLOTS..FX_MAX_SLOTS-1, the ones
+// past the patch's FX1/FX2. Type, route and send level (re)build the
+// slot on the MIDI task; an effect that doesn't fit is refused and the
+// slot keeps what it had.
+constexpr uint8_t RDX_SYX_FX_SLOT = 0x7D;       // addrH, addrM = slot, addrL = RDX_FxSlotParam
+
+enum RDX_FxSlotParam : uint8_t {
+    FXS_TYPE = 0,           // FX_ID, 0 (FX_THRU) empties the slot
+    FXS_ROUTE,              // 0 insert, 1 send
+    FXS_SEND,               // send level, 0..127
+    FXS_PARAM1,             // the effect's two parameters, as FX1/FX2 in a patch
+    FXS_PARAM2,
+    FXS_IR,                 // convolution impulse: 0 /ir/default.wav, n /ir/<n>.wav
+    FXS_PARAMS
+};
+
+// applies one value; set by the firmware, nullptr: changes are ignored
+using SysExFxSlot = void (*)(uint8_t slot, uint8_t param, uint8_t value);
+inline SysExFxSlot sysexFxSlot = nullptr;
+
+// -----------------------------
+// Bulk dump helpers
+// -----------------------------
+inline void dumpSysex(const uint8_t* buf, uint32_t len, const char* tag = "SYSEX") {
+    if (!RDX_Platform::debugLogs()) return;     // no formatting for lines that compile out
+    ESP_LOGD(tag, "SysEx (%u bytes):", len);
+    char line[128];
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < len; i++) {
+        int n = snprintf(line + pos, sizeof(line) - pos, "%02X ", buf[i]);
+        pos += n;
+        if ((i + 1) % 16 == 0 || i + 1 == len) {
+            ESP_LOGD(tag, "%s", line);
+            pos = 0;
+        }
+    }
+}
+
+
+
+
+
+// ==========================
+// Outgoing stream: CHUNK bytes at a time to sysexSender
+// ==========================
+class SysExOut {
+public:
+    static constexpr uint32_t CHUNK = 48;   // 16 USB-MIDI packets: one full 64-byte transfer
+
+    SysExOut() = default;
+    SysExOut(const SysExOut&) = delete;
+    SysExOut& operator=(const SysExOut&) = delete;
+    ~SysExOut() { flush(); }
+
+    inline void put(uint8_t b) {
+        buf_[len_++] = b;
+        if (len_ == CHUNK) flush();
+    }
+
+    inline void put(const uint8_t* data, uint32_t len) {
+        for (uint32_t i = 0; i < len; ++i) put(data[i]);
+    }
+
+    inline void flush() {
+        if (!len_) return;
+        dumpSysex(buf_, len_, "OUT");
+        if (sysexSender) sysexSender(buf_, len_);
+        len_ = 0;
+    }
+
+private:
+    uint8_t  buf_[CHUNK];
+    uint32_t len_ = 0;
+};
+
+// ==========================
+// Helper: Send a single block (Model ID + Address + Data)
+// ==========================
+// out: the stream to append to, nullptr: one of its own, flushed on return
+inline void sendBlock(uint8_t device, uint8_t addrH, uint8_t addrM, uint8_t addrL,
+                      const uint8_t* data, uint32_t dataLen, SysExOut* out = nullptr)
+{
+    SysExOut own;
+    SysExOut& o = out ? *out : own;
+    uint32_t byteCount = 1 + 3 + dataLen; // ModelID + AddrH/M/L + data
+    const uint8_t head[] = {
+        0xF0, 0x43, device, 0x7F, 0x1C,
+        (uint8_t)((byteCount >> 7) & 0x7F),   // MSB
+        (uint8_t)(byteCount & 0x7F),          // LSB
+        0x05,                                  // Model ID
+        addrH, addrM, addrL
+    };
+    o.put(head, sizeof(head));
+    if (dataLen > 0) o.put(data, dataLen);
+    uint32_t sum = 0;   // rdxSyxChecksum() over ModelID+Addr+Data, which are never in one buffer
+    for (int i = 7; i < (int)sizeof(head); ++i) sum += head[i];
+    for (uint32_t i = 0; i < dataLen; ++i) sum += data[i];
+    o.put((128 - (sum & 0x7F)) & 0x7F);
+    o.put(0xF7);
+}
+
+// ==========================
+// Send Common Block
+// ==========================
+inline void sendCommonBlock(const RDX_Patch& patch, uint8_t device=0x00, SysExOut* out = nullptr) {
+    sendBlock(device, 0x30, 0x00, 0x00, reinterpret_cast<const uint8_t*>(&patch.common), sizeof(RDX_Common), out);
+}
+
+// ==========================
+// Send Operator Block
+// ==========================
+inline void sendOperatorBlock(const RDX_Patch& patch, int opNum, uint8_t device=0x00, SysExOut* out = nullptr) {
+    if (opNum < 0 || opNum > 3) return;
+    sendBlock(device, 0x31, opNum, 0x00, reinterpret_cast<const uint8_t*>(&patch.ops[opNum]), sizeof(RDX_OpParams), out);
+}
+
+// ==========================
+// Send Full Patch (Common + 4 Ops)
+// ==========================
+inline void sendFullPatch(const RDX_Patch& patch, uint8_t device=0x00, SysExOut* out = nullptr) {
+    SysExOut own;
+    if (!out) out = &own;
+
+    // Bulk Header 
+    sendBlock(device, 0x0e, 0x0f, 0x00, nullptr, 0, out);
+
+    // Common + Ops
+    sendCommonBlock(patch, device, out);
+    for (int i = 0; i < 4; ++i) sendOperatorBlock(patch, i, device, out);
+
+    // Bulk Footer
+    sendBlock(device, 0x0f, 0x0f, 0x00, nullptr, 0, out);
+}
+
+inline void sendSystemBulk(uint8_t device = 0x00, SysExOut* out = nullptr) {
+    SynthState& state = RDX_State::getState();
+    sendBlock(device, 0x00, 0x00, 0x00, reinterpret_cast<const uint8_t*>(&state.system), sizeof(state.system), out);
+}
+
+inline void sendBulkDump(uint8_t device, const RDX_Patch& patch) {
+    SysExOut out;
+
+    // 1) send SYSTEM bulk message
+    sendSystemBulk(0x00, &out);
+
+    // 2) send VOICE blocks (header, common, ops, footer)
+    sendFullPatch(patch, 0x00, &out);
+}
+
+inline void sendTelemetry(uint8_t device = 0x00) {
+    if (!sysexTelemetry) return;
+    uint32_t fields[TELE_FIELDS] = {};
+    sysexTelemetry(fields);
+    fields[TELE_VERSION] = RDX_TELEMETRY_VERSION;
+    uint8_t data[TELE_FIELDS * 5];
+    for (int f = 0; f < TELE_FIELDS; ++f) {
+        for (int b = 0; b < 5; ++b) data[f * 5 + b] = (fields[f] >> (7 * b)) & 0x7F;
+    }
+    sendBlock(device, RDX_SYX_TELEMETRY, 0x00, 0x00, data, sizeof(data));
+}
+
+inline void sendIdentityReply(uint8_t deviceId = 0x7F) {
+    // SysEx Identity Reply for Yamaha Reface DX 
+    // F0 7E 7F 06 02 43 00 41 53 06 00 00 00 7F F7
+    const uint8_t reply[] = {
+        0xF0,       // SysEx start
+        0x7E,       // Non-realtime
+        deviceId,   // Device ID (0x7F = all-call)
+        0x06, 0x02, // Sub-ID #1/#2: Identity Reply
+        0x43,       // Yamaha (0x43)
+        0x00, 0x41, // Family code
+        0x53, 0x06, // Model ID = Reface DX
+        0x03, 0x00, 0x00, 0x7F, // version = 1.0 + data[10] / 10.0
+        0xF7        // SysEx end
+    };
+    uint32_t delayMs = RDX_Platform::random32() % 64 ;
+    RDX_Platform::sleepTicks(delayMs);
+    dumpSysex(reply, sizeof(reply), "OUT ID");
+    if (sysexSender) sysexSender(reply, sizeof(reply));
+}
+
+
+inline bool unpackCommonBlock(const uint8_t* data, uint32_t len, RDX_Patch& patch) {
+    if (len < 43) return false;
+    if (rdxSyxChecksum(data + 4, 38) != data[42]) return false;
+    memcpy(&patch.common, data + 4, 38);
+    return true;
+}
+
+inline bool unpackOperatorBlock(const uint8_t* data, uint32_t len, RDX_Patch& patch) {
+    if (len < 33) return false;
+    int opNum = data[2];
+    if (opNum < 0 || opNum > 3) return false;
+    if (rdxSyxChecksum(data + 4, 28) != data[32]) return false;
+    memcpy(&patch.ops[opNum], data + 4, 28);
+    return true;
+}
+
+
+
+// -----------------------------
+//  apply single param
+// -----------------------------
+inline void applyCommonParam(RDX_Patch& patch, uint8_t addr, uint8_t val) {
+    if (addr >= sizeof(RDX_Common)) return;
+    reinterpret_cast<uint8_t*>(&patch.common)[addr] = val;
+}
+
+inline void applyOperatorParam(RDX_Patch& patch, int opNum, uint8_t addr, uint8_t val) {
+    if (opNum < 0 || opNum > 3) return;
+    if (addr >= sizeof(RDX_OpParams)) return;
+    reinterpret_cast<uint8_t*>(&patch.ops[opNum])[addr] = val;
+}
+ 
+
+// One complete message (F0 .. F7) from the editor: parameter changes land in `patch`
+// and the system block, requests are answered through sysexSender.
+// False if it was malformed or not for us.
+inline bool handleSysExMessage(const uint8_t* data, uint32_t length, RDX_Patch& patch) {
+    dumpSysex( data, length, "SYSEX IN");
+    if (length < 6 || data[0] != 0xF0 || data[length - 1] != 0xF7) return false;
+
+    // ---------------- Identity Request ----------------
+    // F0 7E <device> 06 01 F7
+    if (data[1] == 0x7E && data[3] == 0x06 && data[4] == 0x01) {
+        ESP_LOGD("MIDI", "SysEx: Identity Request");
+        sendIdentityReply(0x7F);
+        return true;
+    }
+
+    // ---------------- Yamaha header check ----------------
+    if (data[1] != 0x43) return false;
+    uint8_t device = data[2];
+    if (data[3] != 0x7F || data[4] != 0x1C) return false; // group mismatch
+
+    uint8_t typeNibble = (device >> 4) & 0x0F;
+    uint8_t addrH = (length > 6) ? data[6] : 0;
+    uint8_t addrM = (length > 7) ? data[7] : 0;
+    uint8_t addrL = (length > 8) ? data[8] : 0;
+    uint32_t addr = (addrH << 16) | (addrM << 8) | addrL;
+    
+    switch (typeNibble) {
+
+    // ===================================================
+    case 0x1: { // PARAMETER CHANGE (editor → us)
+    // ===================================================
+        if (length < 10) return false;
+        uint8_t val = data[9];
+        if (addrH == 0x30) {
+            ESP_LOGD("IN", "Common param change: offset=0x%02X val=%d", addrL, val);
+            applyCommonParam(patch, addrL, val);
+        } else if (addrH == 0x31) {
+            ESP_LOGD("IN", "Operator %d param change: offset=0x%02X val=%d", addrM, addrL, val);
+            applyOperatorParam(patch, addrM, addrL, val);
+        } else if (addrH == 0x00 && addrL < sizeof(RDX_System)) {
+            ESP_LOGD("IN", "System param change: offset=0x%02X val=%d", addrL, val);
+            reinterpret_cast<uint8_t*>(&RDX_State::getState().system)[addrL] = val;
+            if (RDX_AudioConfig::isAudioParam(addrL)) RDX_AudioConfig::save(); // takes effect on the next boot
+        } else if (addrH == RDX_SYX_FX_SLOT && sysexFxSlot) {
+            ESP_LOGD("IN", "FX slot %d param change: %d val=%d", addrM, addrL, val);
+            sysexFxSlot(addrM, addrL, val);
+        } else {
+            ESP_LOGI("IN", "Unknown param change at addr=%02X%02X%02X", addrH, addrM, addrL);
+        }
+        // echo
+       // MIDI.sendSysEx(sizeof(data), data, true);
+        break;
+    }
+
+    // ===================================================
+    case 0x0: { // BULK DUMP (editor → us)
+    // ===================================================
+        ESP_LOGI("IN", "BulkDump received (%u bytes)", length);
+        // ModelID is data[7], Address is data[8..10], Data starts at [11]
+        // Here you’d call unpackCommonBlock/unpackOperatorBlock depending on addrH
+        break;
+    }
+
+    // ===================================================
+    case 0x2: { // DUMP REQUEST (editor → request us → reply with bulk)
+    // ===================================================
+        if (length < 10) return false;
+        ESP_LOGI("IN", "DumpRequest 0x02 addr=%02X%02X%02X", addrH, addrM, addrL);
+        if (addr == 0x00000000) sendBulkDump(0x00, patch);  // 0x00000000 is a SYSTEM block request addr
+        if (addr == 0x000e0f00) sendFullPatch( patch); // 0x0e0f00 is a VOICE block request addr
+        break;
+    }
+
+    // ===================================================
+    case 0x3: { // PARAMETER REQUEST (editor → request us → reply single block)
+    // ===================================================
+        if (length < 10) return false;
+        ESP_LOGD("IN", "ParamRequest addr=%02X%02X%02X", addrH, addrM, addrL);
+        if (addrH == 0x30) {
+            sendCommonBlock(patch);
+        } else if (addrH == 0x31) {
+            sendOperatorBlock(patch, addrM);
+        } else if (addrH == 0x0E) {
+            sendFullPatch(patch);
+        } else if (addrH == RDX_SYX_TELEMETRY) {
+            sendTelemetry();
+        } else {
+            ESP_LOGI("IN", "Unhandled param request at addr=%02X%02X%02X", addrH, addrM, addrL);
+        }
+        break;
+    }
+
+    default:
+        ESP_LOGI("IN", "Unhandled SysEx device=0x%02X", device);
+        break;
+    }
+    return true;
+}
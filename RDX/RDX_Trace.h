@@ -0,0 +1,335 @@
+// RDX_Trace.h
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include <atomic>
+#include <algorithm>
+#include <FS.h>
+#include "RDX_Platform.h"
+#include "RDX_State.h"
+#include "config.h"
+
+// =========================================================
+// Record-and-replay trace of what drives the engine.
+//
+// A ring of 16-byte records, each stamped with the audio
+// sample position (blocks rendered or idled x block length):
+//   MIDI       a channel message, as the MIDI task handled it
+//   BLOB       a SysEx message, a patch or the MIDI controls,
+//              split over BLOB_DATA records: SysEx as received,
+//              patches on applyPatch() (program change, preset
+//              buttons) and, with the controls, as a keyframe
+//              every KEYFRAME_S and when the voices fall silent
+//   FX         an extra FX slot configured, or its parameters
+//   BLOCK      one rendered block: synth and FX cycles, the
+//              VOICES it ran with and the voices sounding
+//
+// A writer claims a record with one fetch_add and publishes it
+// with a sequence number; the oldest records are overwritten.
+// No lock, no allocation after init(). The audio task writes
+// BLOCK, the MIDI task the rest, so the pieces of a blob stay
+// in order among the MIDI task's records.
+//
+// A block over its budget (an xrun, as RDX_Profiler counts
+// them) schedules a flush POST_S later, so the file holds what
+// led to the dropout and its aftermath; requestFlush() asks
+// for one now (long press of button 20). service(), on the log
+// task, writes the ring to FILE_NAME on LittleFS. The host's
+// rdx_replay plays it back through the engine from a keyframe,
+// block by block with the recorded VOICES, and reports the
+// host cost of every block beside the device's.
+//
+// Timestamps are block-accurate: an event is stamped with the
+// block the audio task is rendering, replay applies it before
+// that block. Audio input, GUI edits and the FX budget's slot
+// drops are not recorded; the next keyframe catches up with
+// the patch.
+//
+// RDX_TRACE (config.h) off: the recorder and its RDX_TRACE_*
+// macros compile out, the file format stays for the host.
+// =========================================================
+
+enum RDX_TraceType : uint8_t {
+    TRACE_NONE = 0,
+    TRACE_BLOCK,        // u32 synth cycles, u32 FX cycles, VOICES, voices sounding
+    TRACE_MIDI,         // status, data 1, data 2
+    TRACE_BLOB,         // kind, reason, u16 size; BLOB_DATA records follow
+    TRACE_BLOB_DATA,    // the next up to 10 bytes of the blob
+    TRACE_FX,           // FX_OP_SLOT: slot, id, route, send level x 255; FX_OP_PARAMS: slot, p1, p2
+};
+
+enum RDX_TraceBlob : uint8_t { BLOB_SYSEX, BLOB_PATCH, BLOB_CONTROLS };
+
+enum RDX_TraceReason : uint8_t {
+    TRACE_LOAD = 0,         // patch: applyPatch(), the voices were reset
+    TRACE_KEYFRAME,         // periodic snapshot, voices may be sounding
+    TRACE_KEYFRAME_QUIET,   // snapshot as the last voice stopped
+};
+
+enum RDX_TraceFxOp : uint8_t { FX_OP_SLOT, FX_OP_PARAMS };
+
+enum RDX_TraceFlush : uint8_t { FLUSH_USER, FLUSH_XRUN };
+
+struct RDX_TraceRecord {
+    uint32_t sample;
+    uint8_t  type;
+    uint8_t  len;           // payload bytes used
+    uint8_t  data[10];
+};
+static_assert(sizeof(RDX_TraceRecord) == 16, "trace records are 16 bytes");
+
+// file: the header, then header.records records, oldest first
+struct RDX_TraceHeader {
+    char     magic[4];          // "RDXT"
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t sampleRate;
+    uint32_t blockLen;
+    uint32_t cpuMHz;
+    uint32_t budgetCycles;      // one block's time
+    uint32_t records;
+    uint8_t  reason;            // RDX_TraceFlush
+    uint8_t  maxVoices;
+    uint16_t patchSize;         // sizeof(RDX_Patch) of the build that wrote it
+};
+
+static constexpr uint16_t RDX_TRACE_VERSION = 1;
+
+#ifdef RDX_TRACE
+
+class RDX_Trace {
+public:
+    static constexpr uint32_t RECORDS    = 4096;    // power of two: 80 kB of PSRAM, ~10 s of blocks with playing
+    static constexpr float    KEYFRAME_S = 2.0f;
+    static constexpr float    POST_S     = 0.5f;    // recorded after an xrun before the flush
+    static constexpr float    HOLDOFF_S  = 10.0f;   // after a flush before an xrun triggers the next
+    static constexpr uint32_t MAX_SYSEX  = 2048;    // longer messages are left out
+    static constexpr const char* FILE_NAME = "/trace.rdt";
+
+    static RDX_Trace& get() {
+        static RDX_Trace instance;
+        return instance;
+    }
+
+    // before the audio task starts; recording starts here
+    inline bool init(uint32_t sampleRate, uint32_t blockLen) {
+        sampleRate_ = sampleRate;
+        blockLen_ = blockLen;
+        budgetCycles_ = (uint32_t)((uint64_t)blockLen * RDX_Platform::cpuMHz() * 1000000ull / sampleRate);
+        keyframeSamples_ = (uint32_t)(KEYFRAME_S * sampleRate);
+        postSamples_ = (uint32_t)(POST_S * sampleRate);
+        holdoffSamples_ = (uint32_t)(HOLDOFF_S * sampleRate);
+        lastFlush_.store(now() - holdoffSamples_, std::memory_order_relaxed);  // no holdoff before the first flush
+        if (!ring_) ring_ = (Slot*)heap_caps_calloc(RECORDS, sizeof(Slot), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!ring_) {
+            ESP_LOGE("TRACE", "No memory for the trace ring");
+            return false;
+        }
+        ESP_LOGI("TRACE", "Tracing on: %u records, flushed to %s on an xrun", RECORDS, FILE_NAME);
+        return true;
+    }
+
+    // ---- audio task ----
+
+    inline IRAM_ATTR void block(uint32_t synthCycles, uint32_t fxCycles, uint8_t voices, uint8_t active) {
+        const uint32_t pos = sample_.load(std::memory_order_relaxed);
+        sample_.store(pos + blockLen_, std::memory_order_relaxed);  // events from here on belong to the next block
+        uint8_t d[10];
+        memcpy(d, &synthCycles, 4);
+        memcpy(d + 4, &fxCycles, 4);
+        d[8] = voices;
+        d[9] = active;
+        put(TRACE_BLOCK, pos, d, sizeof(d));
+        if (synthCycles + fxCycles > budgetCycles_ && pos - lastFlush_.load(std::memory_order_relaxed) >= holdoffSamples_) {
+            schedule(FLUSH_XRUN, pos + postSamples_);
+        }
+    }
+
+    // a block the audio task skipped (power idle): time goes on, nothing is rendered
+    inline IRAM_ATTR void idle() {
+        sample_.store(sample_.load(std::memory_order_relaxed) + blockLen_, std::memory_order_relaxed);
+    }
+
+    // ---- MIDI task ----
+
+    inline void midi(uint8_t status, uint8_t d1, uint8_t d2) {
+        const uint8_t d[3] = { status, d1, d2 };
+        put(TRACE_MIDI, now(), d, sizeof(d));
+    }
+
+    inline void sysex(const uint8_t* data, uint32_t len) {
+        if (len <= MAX_SYSEX) blob(BLOB_SYSEX, 0, data, len);
+    }
+
+    // applyPatch(): the patch, then the controls it plays with
+    inline void patchLoad(const RDX_Patch& patch) {
+        blob(BLOB_PATCH, TRACE_LOAD, &patch, sizeof(patch));
+        blob(BLOB_CONTROLS, TRACE_LOAD, &RDX_State::getState().controls, sizeof(RDX_Controls));
+        lastKeyframe_ = now();
+    }
+
+    // every MIDI task loop: a snapshot when the voices fall silent, or every KEYFRAME_S
+    inline void keyframe(const RDX_Patch& patch, const RDX_Controls& ctl, int active) {
+        if (!ring_) return;
+        const uint32_t pos = now();
+        const bool fellSilent = !active && wasActive_;
+        wasActive_ = active > 0;
+        if (!fellSilent && pos - lastKeyframe_ < keyframeSamples_) return;
+        const uint8_t reason = active ? TRACE_KEYFRAME : TRACE_KEYFRAME_QUIET;
+        blob(BLOB_PATCH, reason, &patch, sizeof(patch));
+        blob(BLOB_CONTROLS, reason, &ctl, sizeof(ctl));
+        lastKeyframe_ = pos;
+    }
+
+    inline void fxSlot(uint8_t slot, uint8_t id, uint8_t route, float sendLevel) {
+        const uint8_t d[5] = { FX_OP_SLOT, slot, id, route, (uint8_t)(std::min(std::max(sendLevel, 0.f), 1.f) * 255.f + 0.5f) };
+        put(TRACE_FX, now(), d, sizeof(d));
+    }
+
+    inline void fxParams(uint8_t slot, uint8_t p1, uint8_t p2) {
+        const uint8_t d[4] = { FX_OP_PARAMS, slot, p1, p2 };
+        put(TRACE_FX, now(), d, sizeof(d));
+    }
+
+    // ---- any task ----
+
+    inline void requestFlush() { schedule(FLUSH_USER, now()); }
+
+    inline uint32_t now() const { return sample_.load(std::memory_order_relaxed); }
+
+    // log task: writes a scheduled flush once its time has come
+    inline void service(fs::FS& fs) {
+        const uint8_t pending = pending_.load(std::memory_order_acquire);
+        if (!pending || pending == CLAIMED || (int32_t)(now() - flushAt_) < 0) return;
+        fs::File f = fs.open(FILE_NAME, "w");
+        if (f) {
+            const uint32_t n = write(f, pending - 1);
+            ESP_LOGI("TRACE", "%s: %u records (%s) written to %s", pending - 1 == FLUSH_XRUN ? "xrun" : "flush", n,
+                     n ? "replay with rdx_replay" : "empty", FILE_NAME);
+            f.close();
+        } else {
+            ESP_LOGE("TRACE", "Can't write %s", FILE_NAME);
+        }
+        lastFlush_.store(now(), std::memory_order_relaxed);
+        pending_.store(0, std::memory_order_release);
+    }
+
+    // the header and every record still in the ring, oldest first; returns the record count
+    inline uint32_t write(fs::File& f, uint8_t reason) {
+        RDX_TraceHeader h {};
+        memcpy(h.magic, "RDXT", 4);
+        h.version = RDX_TRACE_VERSION;
+        h.recordSize = sizeof(RDX_TraceRecord);
+        h.sampleRate = sampleRate_;
+        h.blockLen = blockLen_;
+        h.cpuMHz = RDX_Platform::cpuMHz();
+        h.budgetCycles = budgetCycles_;
+        h.reason = reason;
+        h.maxVoices = MAX_VOICES;
+        h.patchSize = sizeof(RDX_Patch);
+        f.write((const uint8_t*)&h, sizeof(h));
+        if (!ring_) return 0;
+
+        // records overwritten while this runs fail their check and are left out
+        RDX_TraceRecord buf[32];
+        uint32_t n = 0;
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        for (uint32_t i = head > RECORDS ? head - RECORDS : 0; i != head; ++i) {
+            if (!read(i, buf[n % 32])) continue;
+            if (++n % 32 == 0) f.write((const uint8_t*)buf, sizeof(buf));
+        }
+        if (n % 32) f.write((const uint8_t*)buf, (n % 32) * sizeof(RDX_TraceRecord));
+        h.records = n;
+        f.seek(0);
+        f.write((const uint8_t*)&h, sizeof(h));
+        return n;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;      // index + 1 once written, 0 while being written
+        RDX_TraceRecord rec;
+    };
+
+    Slot*    ring_ = nullptr;
+    std::atomic<uint32_t> head_ {0};        // next record to claim
+    std::atomic<uint32_t> sample_ {0};      // start of the block being rendered
+    std::atomic<uint32_t> lastFlush_ {0};
+    std::atomic<uint8_t>  pending_ {0};     // RDX_TraceFlush + 1 while a flush is scheduled
+    static constexpr uint8_t CLAIMED = 0xFF;   // a request is setting flushAt_
+    uint32_t flushAt_ = 0;
+    uint32_t sampleRate_ = SAMPLE_RATE;
+    uint32_t blockLen_ = DMA_BUFFER_LEN;
+    uint32_t budgetCycles_ = 0;
+    uint32_t keyframeSamples_ = 0;
+    uint32_t postSamples_ = 0;
+    uint32_t holdoffSamples_ = 0;
+    uint32_t lastKeyframe_ = 0;             // MIDI task
+    bool     wasActive_ = false;            // MIDI task
+
+    inline IRAM_ATTR void put(uint8_t type, uint32_t sample, const void* data, uint8_t len) {
+        if (!ring_) return;
+        const uint32_t i = head_.fetch_add(1, std::memory_order_relaxed);
+        Slot& s = ring_[i & (RECORDS - 1)];
+        s.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.rec.sample = sample;
+        s.rec.type = type;
+        s.rec.len = len;
+        memcpy(s.rec.data, data, len);
+        memset(s.rec.data + len, 0, sizeof(s.rec.data) - len);
+        s.seq.store(i + 1, std::memory_order_release);
+    }
+
+    // copies record i if it is written and still there after the copy
+    inline bool read(uint32_t i, RDX_TraceRecord& out) const {
+        const Slot& s = ring_[i & (RECORDS - 1)];
+        if (s.seq.load(std::memory_order_acquire) != i + 1) return false;
+        memcpy(&out, &s.rec, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return s.seq.load(std::memory_order_relaxed) == i + 1;
+    }
+
+    inline void blob(uint8_t kind, uint8_t reason, const void* data, uint32_t size) {
+        const uint32_t pos = now();
+        const uint8_t d[4] = { kind, reason, (uint8_t)size, (uint8_t)(size >> 8) };
+        put(TRACE_BLOB, pos, d, sizeof(d));
+        const uint8_t* p = (const uint8_t*)data;
+        for (uint32_t off = 0; off < size; off += sizeof(RDX_TraceRecord::data)) {
+            put(TRACE_BLOB_DATA, pos, p + off, (uint8_t)std::min<uint32_t>(size - off, sizeof(RDX_TraceRecord::data)));
+        }
+    }
+
+    // the first request wins until service() has written it
+    inline void schedule(uint8_t reason, uint32_t at) {
+        uint8_t none = 0;
+        if (pending_.load(std::memory_order_relaxed)) return;
+        if (!pending_.compare_exchange_strong(none, CLAIMED, std::memory_order_acquire)) return;
+        flushAt_ = at;
+        pending_.store(reason + 1, std::memory_order_release);
+    }
+};
+
+#define RDX_TRACE_MIDI(status, d1, d2)  RDX_Trace::get().midi((status), (d1), (d2))
+#define RDX_TRACE_SYSEX(data, len)      RDX_Trace::get().sysex((data), (len))
+#define RDX_TRACE_PATCH(patch)          RDX_Trace::get().patchLoad(patch)
+#define RDX_TRACE_FX_SLOT(slot, id, route, send)  RDX_Trace::get().fxSlot((slot), (id), (uint8_t)(route), (send))
+#define RDX_TRACE_FX_PARAMS(slot, p1, p2)         RDX_Trace::get().fxParams((slot), (p1), (p2))
+#define RDX_TRACE_BLOCK_START()         const uint32_t traceStart_ = RDX_Platform::cycles(); const uint8_t traceVoices_ = VOICES
+#define RDX_TRACE_SYNTH_DONE()          const uint32_t traceSynth_ = RDX_Platform::cycles()
+#define RDX_TRACE_BLOCK_END(active)     RDX_Trace::get().block(traceSynth_ - traceStart_, RDX_Platform::cycles() - traceSynth_, traceVoices_, (active))
+#define RDX_TRACE_IDLE()                RDX_Trace::get().idle()
+
+#else
+
+#define RDX_TRACE_MIDI(status, d1, d2)  do {} while (0)
+#define RDX_TRACE_SYSEX(data, len)      do {} while (0)
+#define RDX_TRACE_PATCH(patch)          do {} while (0)
+#define RDX_TRACE_FX_SLOT(slot, id, route, send)  do {} while (0)
+#define RDX_TRACE_FX_PARAMS(slot, p1, p2)         do {} while (0)
+#define RDX_TRACE_BLOCK_START()         do {} while (0)
+#define RDX_TRACE_SYNTH_DONE()          do {} while (0)
+#define RDX_TRACE_BLOCK_END(active)     do {} while (0)
+#define RDX_TRACE_IDLE()                do {} while (0)
+
+#endif // RDX_TRACE
@@ -154,7 +154,11 @@ struct __attribute__((packed)) RDX_System {
     uint8_t autoPowerOff = 1;   // 00-01 : off/ON
     uint8_t speakerOn = 1;      // 00-01 : off/ON 
     uint8_t midiControl = 1;    // 00-01 : off/ON
-    uint8_t reserved[17];
+    // not on the Reface, stored in NVS and applied on the next boot (RDX_AudioConfig.h)
+    uint8_t audioBlock = 2;     // 00-03 : 32/64/128/256 samples per block
+    uint8_t audioDmaBufs = 2;   // 02-08 : I2S DMA buffers
+    uint8_t audioRate = 2;      // 00-03 : 22050/32000/44100/48000 Hz
+    uint8_t reserved[14];
 };
 
 // ---------------------------------------------------------
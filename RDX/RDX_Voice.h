@@ -1,6 +1,6 @@
 // RDX_Voice.h
 #pragma once
-#include <Arduino.h>
+#include "RDX_Platform.h"
 #include <cmath>
 #include "RDX_Types.h"
 #include "RDX_Constants.h"
@@ -56,7 +56,7 @@ inline void noteOn(uint8_t note, uint8_t vel) {
         portamentoStartNote_  = currentNoteSemitone_;
         portamentoTargetNote_ = noteTarget;
         portamentoPos_        = 0.f;
-        portamentoInc_        = 1.f / (ctl_.portaTimeS * (float)sampleRate_);
+        portamentoInc_        = DIV_SAMPLE_RATE / ctl_.portaTimeS;
     } else {
         portamentoStartNote_  = noteTarget;
         portamentoTargetNote_ = noteTarget;
@@ -206,8 +206,8 @@ inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
     }
 
 
-    inline  IRAM_ATTR __attribute__((always_inline)) void  updateLfo() {
-        lfo_.updateState();          // advance once per block
+    inline  IRAM_ATTR __attribute__((always_inline)) void  updateLfo(uint32_t len) {
+        lfo_.updateState(len);       // advance once per block
         lfoValue_ = lfo_.getValue();      // cache start-of-block value
         lfoIncrement_ = lfo_.getIncrement(); // cache per-sample increment
     }
@@ -329,10 +329,8 @@ inline IRAM_ATTR __attribute__((always_inline)) void updateMods() {
                         ampMod_[2] * ops_[2].compute(0.0f, phaseMod_[2]) +
                         ampMod_[3] * ops_[3].compute(0.0f, phaseMod_[3])));
 
-            default: {
-                vTaskDelay(1); // invalid RDX_State ?
+            default: // invalid algorithm: silence, never block the audio task
                 return 0.f;
-            }
         }
     }
 
@@ -368,7 +366,6 @@ private:
     float noteOnBaseNote_       = 0.f;   // absolute semitone that ops were set with
     float currentNoteSemitone_ = 0.0f;
     bool justAllocated_         = false; // score modifier
-    float sampleRate_ = (float)SAMPLE_RATE;
 
     RDX_Operator ops_[4] = { // a bit of verbose so the ops would know who they are on creation, and could have a firm ref to their params structs
         RDX_Operator(0),
@@ -3,6 +3,7 @@
 #pragma once
 #include "RDX_Voice.h"
 #include "RDX_Types.h"
+#include "RDX_Log.h"
 
 // ======================================================
 // RDX_VoiceAllocator
@@ -27,7 +28,7 @@ public:
         // --- polyphonic ---
         for (int i = 0; i < count; ++i) {
             if (!voices[i].isActive()) {
-                ESP_LOGD("VA", "Using inactive voice %d", i);
+                RDX_LOGD("VA", "Using inactive voice %d", i);
                 return i;
             }
         }
@@ -40,9 +41,9 @@ public:
                 minScore = s;
                 victim = i;
             }
-            ESP_LOGD("VA", "  ? voice %d score %f", i, s );
+            RDX_LOGD("VA", "  ? voice %d score %f", i, s );
         }
-        ESP_LOGD("VA", "Using victim voice %d score %f", victim, minScore );
+        RDX_LOGD("VA", "Using victim voice %d score %f", victim, minScore );
         voices[victim].setJustAllocated();
         return victim;
     }
@@ -3,21 +3,55 @@
 
 
 // ===================== AUDIO ==================================
-#define   DMA_BUFFER_NUM        2     // number of internal DMA buffers
-#define   DMA_BUFFER_LEN        128    // length of each buffer in samples
+#define   DMA_BUFFER_NUM        2     // number of internal DMA buffers (default, 2..MAX_DMA_BUFFER_NUM at boot)
+#define   DMA_BUFFER_LEN        128    // length of each buffer in samples (default, 32/64/128/256 at boot)
+#define   MIN_BLOCK_LEN         32    // static audio buffers are sized for MAX_BLOCK_LEN,
+#define   MAX_BLOCK_LEN         256   // the block length in use comes from RDX_AudioConfig.h
+#define   MAX_DMA_BUFFER_NUM    8
 #define   CHANNEL_SAMPLE_BYTES  2     // can be 1, 2, 3 or 4 (2 and 4 only supported yet)
-#define   SAMPLE_RATE           44100
+#define   SAMPLE_RATE           44100 // default, 22050/32000/44100/48000 at boot (RDX_AudioConfig.h)
+#define   AUDIO_ZERO_COPY_OUT   1     // 1: render into the I2S DMA buffers as they free up (IDF 5 cores, 16-bit), 0: buffered i2s_channel_write()
+
+// ===================== AUDIO INPUT ============================
+#define   AUDIO_IN_NONE         0     // synth only
+#define   AUDIO_IN_FX           1     // effects processor: the input alone runs through the FX chain
+#define   AUDIO_IN_MIX          2     // the input is mixed with the synth ahead of the FX chain
+#define   AUDIO_INPUT           AUDIO_IN_NONE   // select one of the above
+// #define AUDIO_INPUT_FILE     "/audio/in.wav" // take the input from a looped LittleFS file instead of I2S_DIN_PIN (PCM16 .wav or stereo int16 .raw)
 
 // ===================== MIDI ===================================
 #define   USE_USB_MIDI_DEVICE   1     // definition: the synth appears as a USB MIDI Device "S3 SF2 Synth"
 #define   USE_MIDI_STANDARD     2     // definition: the synth receives MIDI messages via serial 31250 bps
 #define   MIDI_IN_DEV           USE_USB_MIDI_DEVICE     // select the appropriate (one of the above) 
 #define   NUM_MIDI_CHANNELS		16
+#define   MIDI_SERVICE_MS       2       // MIDI task: control scan and FX service period; MIDI input wakes it at once
 
 // ===================== SYNTHESIZER ============================
 #define MAX_VOICES 8
 #define MAX_VOICES_PER_NOTE 2
 
+// ===================== EFFECTS ================================
+#define FX_MAX_SLOTS          4       // 2 patch slots (Reface FX1/FX2) + extra insert/send slots
+#define FX_CPU_BUDGET_US      1500    // FX share per 128 samples (~2900 us at 44100), the rest keeps ~4 voices; scaled to the block length
+
+// ===================== POWER ==================================
+#define POWER_IDLE_MS         3000    // no voice and silent FX output this long -> idle (no rendering, lower clock); 0: never
+#define POWER_IDLE_CPU_MHZ    80      // CPU clock while idle (80 keeps APB and I2S untouched)
+#define POWER_IDLE_POLL_MS    20      // control scan while idle; MIDI input and button edges wake the MIDI task at once
+#define POWER_IDLE_GUI_MS     100     // display refresh while idle
+
+// ===================== DEBUG ==================================
+// #define DEBUG_FX_BENCH      // measure FX cycles per block at boot (delay: PSRAM direct vs DRAM-staged; touch-wah, phaser: per-channel vs 2-lane cascade)
+// #define DEBUG_BENCH  RDX_Bench::JSON  // run the RDX_Bench.h micro-benchmarks at boot, printed on Serial (TEXT, JSON or CSV)
+// #define DEBUG_METER         // log the bus levels (RDX_Meter.h) with the MIDI task's periodic state report
+#ifndef RDX_LOG_LEVEL
+#define RDX_LOG_LEVEL       3   // audio/MIDI path logs (RDX_Log.h, drained by a low-priority task): 0 off, 1 error, 2 warn, 3 info, 4 debug
+#endif
+#ifndef RDX_HOST
+// #define RDX_PROFILE         // per-stage cycle profile of the audio task (RDX_Profiler.h), logged by the MIDI task (host: -DRDX_PROFILE=ON)
+// #define RDX_TRACE           // record-and-replay trace (RDX_Trace.h): MIDI, patch/FX changes and block times, written to LittleFS on an xrun (host: -DRDX_TRACE=ON)
+#endif
+
 // ===================== MIDI PINS ==============================
 #define MIDI_IN         4      // if USE_MIDI_STANDARD is selected as MIDI_IN, this pin receives MIDI messages
 
@@ -39,7 +73,9 @@
 
 // ===================== GUI SETTINGS ===========================
 
-#define ENABLE_GUI
+#ifndef RDX_HOST
+#define ENABLE_GUI      // no display on the host build
+#endif
 
 #define ACTIVE_STATE  LOW   // LOW = switch connects to GND, HIGH = switch connects to 3V3
 
@@ -75,12 +111,18 @@
 #endif
 
 // ===================== COMPILE GUARDS =========================
+#ifndef RDX_HOST
 #ifndef BOARD_HAS_PSRAM
 #error "OPI-PSRAM or better is required, enable it in the [Tools] -> [PSRAM] menu"
 #endif
 
+#if AUDIO_INPUT != AUDIO_IN_NONE && !defined(AUDIO_INPUT_FILE) && I2S_DIN_PIN < 0
+#error "AUDIO_INPUT needs I2S_DIN_PIN (or an AUDIO_INPUT_FILE)"
+#endif
+
 #if MIDI_IN_DEV == USE_USB_MIDI_DEVICE 
   #if ARDUINO_USB_MODE != 0
   #error "[Tools] -> [USB Mode] should be set to [USB-OTG (TinyUSB)] if you want to use USB MIDI Device"
   #endif
 #endif
+#endif // RDX_HOST
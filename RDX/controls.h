@@ -4,6 +4,8 @@
 #include "misc.h"
 #include "src/InputManager/src/mux4067.h"
 #include "src/InputManager/src/InputManager.h"
+#include "RDX_Power.h"
+#include "RDX_Trace.h"
 
 extern RDX_Synth synth;
 extern PresetManager pm;
@@ -54,12 +56,21 @@ void onButton(int id, MuxButton::btnEvents evt) {
             synth.applyPatch(patch);
             ESP_LOGI("CTRL", "%s", patch.common.voiceName);
         }
+    } else if (evt == MuxButton::EVENT_LONGPRESS && id == 20) {
+#ifdef RDX_TRACE
+        RDX_Trace::get().requestFlush();    // the last seconds to LittleFS, for rdx_replay
+#endif
     }
 
 }
 
 
 
+// any edge on a control pin ends idle power saving right away, the polling is slow then
+static void IRAM_ATTR onControlEdge() {
+    RDX_Power::get().wakeFromISR();
+}
+
 void initControls() {
     
   //  Mux.reset();
@@ -90,6 +101,10 @@ void initControls() {
     */
     // Initialize with callbacks
     inputManager.initialize(onEncoder, onButton);
+
+    for (int pin : { BTN0_PIN, BTN1_PIN, BTN2_PIN, BTN3_PIN, BTN4_PIN, BTN5_PIN, ENC0_A_PIN, ENC0_B_PIN }) {
+        attachInterrupt(digitalPinToInterrupt(pin), onControlEdge, CHANGE);
+    }
     
     ESP_LOGI("CTRL", "Total encoders: %d" , inputManager.getTotalEncoderCount());
     ESP_LOGI("CTRL", "Total buttons: %d",  inputManager.getTotalButtonCount());
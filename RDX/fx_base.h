@@ -1,6 +1,17 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include "RDX_Log.h"   // effects log through the ring: prepare() runs on the MIDI task, the rest on the audio task
+
+// FX_CPU_BUDGET_US is given per 128 samples, this is the share of one block of n
+inline uint32_t fxBudgetUs(uint32_t n) { return (uint64_t)FX_CPU_BUDGET_US * n / 128; }
+
+// Scratch an effect instance asks the host for, in floats.
+// fast: internal RAM, slow: PSRAM
+struct FxMemory {
+    uint32_t fast = 0;
+    uint32_t slow = 0;
+};
 
 class  FXBase {
 public:
@@ -24,6 +35,20 @@ public:
         (void)sampleRate;
         return true;
     }
+    // Effects whose wet path doesn't need full bandwidth may ask the host to run them
+    // at sampleRate / 2 or / 4 (see fx_multirate.h). init() and prepare() then receive
+    // the reduced rate, and processBlock() gets n / rateDivider() frames.
+    virtual uint8_t rateDivider() const { return 1; }
+    // How much scratch prepare() will want at this (already divided) rate. The host
+    // allocates exactly this per instance, so only effects in use cost memory.
+    virtual FxMemory memoryNeeds(int sampleRate) const { (void)sampleRate; return {}; }
+    // Frames per processBlock() call (the audio block, divided like the rate). Set by the
+    // host before memoryNeeds(), so block-sized scratch follows the boot-time block length.
+    inline void setBlockLen(uint32_t n) { blockLen_ = n; }
+    inline uint32_t blockLen() const { return blockLen_; }
+    // Parameter bytes {type, p1, p2}: the patch's effects[slot] or a host-owned copy
+    inline void bindParams(const uint8_t* p) { params_ = p; }
+    inline uint8_t param(int idx) const { return params_[idx]; }
     inline void enable(bool s) { enabled_ = s; }
     inline bool enabled() const { return enabled_; }
 
@@ -32,6 +57,10 @@ protected:
     bool prepared_ = false;
     float sampleRate_ = (float)SAMPLE_RATE;
     uint8_t slotId_ = 0;
+    uint32_t blockLen_ = DMA_BUFFER_LEN;
+    const uint8_t* params_ = DEFAULT_PARAMS;
+
+    static constexpr uint8_t DEFAULT_PARAMS[3] = { 0, 64, 64 };
 };
 
 
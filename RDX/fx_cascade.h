@@ -0,0 +1,95 @@
+// fx_cascade.h
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include "config.h"
+
+// =========================================================
+// Stereo first-order allpass cascade.
+//
+// L and R travel together as one 2-lane value through N
+// stages, so each stage loads its coefficient once for both
+// channels. Coefficients glide linearly from their current
+// value to the block target, one add per stage per sample,
+// instead of being recomputed in steps inside the loop.
+//
+// The S3 vector unit is integer-only, so the lanes are plain
+// floats here. L and R are two independent dependency chains
+// through the same coefficients, which lets the compiler
+// interleave the two channels' multiply-adds.
+//
+// tickSplit() is the per-channel form the effects had before:
+// L through every stage, then R, no glide. FxTouchWah and
+// FxPhaser keep that path behind setSplit() so benchmarks can
+// time both in the same run.
+// =========================================================
+
+struct Lanes2 {
+    float l, r;
+};
+
+template <int N>
+class AllpassCascade2 {
+public:
+    inline void reset() {
+        memset(z_, 0, sizeof(z_));
+    }
+
+    // set every stage at once, no glide
+    inline void setCoef(float a) {
+        for (int s = 0; s < N; ++s) { a_[s] = a; inc_[s] = 0.f; }
+    }
+
+    inline void setCoef(int stage, float a) { a_[stage] = a; inc_[stage] = 0.f; }
+
+    // glide all stages to one target over `frames` ticks
+    inline void glideTo(float target, uint32_t frames) {
+        const float k = 1.0f / (float)frames;
+        for (int s = 0; s < N; ++s) inc_[s] = (target - a_[s]) * k;
+    }
+
+    // glide each stage to its own target over `frames` ticks
+    inline void glideTo(const float* targets, uint32_t frames) {
+        const float k = 1.0f / (float)frames;
+        for (int s = 0; s < N; ++s) inc_[s] = (targets[s] - a_[s]) * k;
+    }
+
+    inline float coef(int stage) const { return a_[stage]; }
+
+    // one sample through all stages; coefficients advance by one glide step
+    inline IRAM_ATTR __attribute__((always_inline))
+    Lanes2 tick(Lanes2 x) {
+        for (int s = 0; s < N; ++s) {
+            const float a = a_[s];
+            const float yL = z_[s].l - a * x.l;
+            const float yR = z_[s].r - a * x.r;
+            z_[s].l = x.l + a * yL;
+            z_[s].r = x.r + a * yR;
+            x.l = yL;
+            x.r = yR;
+            a_[s] = a + inc_[s];
+        }
+        return x;
+    }
+
+    // one sample, one channel after the other at the current coefficients
+    inline IRAM_ATTR __attribute__((always_inline))
+    Lanes2 tickSplit(Lanes2 x) {
+        for (int s = 0; s < N; ++s) {
+            const float yL = z_[s].l - a_[s] * x.l;
+            z_[s].l = x.l + a_[s] * yL;
+            x.l = yL;
+        }
+        for (int s = 0; s < N; ++s) {
+            const float yR = z_[s].r - a_[s] * x.r;
+            z_[s].r = x.r + a_[s] * yR;
+            x.r = yR;
+        }
+        return x;
+    }
+
+private:
+    Lanes2 z_[N] {};
+    float  a_[N] {};
+    float  inc_[N] {};
+};
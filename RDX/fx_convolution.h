@@ -0,0 +1,338 @@
+// fx_convolution.h
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include <FS.h>
+#include <LittleFS.h>
+#include "config.h"
+#include "misc.h"
+#include "RDX_Constants.h"
+#include "fx_base.h"
+#include "fx_fft.h"
+
+// =========================================================
+// FxConvolution - impulse response reverb
+//
+// Uniform-partitioned overlap-save: the IR is cut into
+// block-length partitions, each kept as a half spectrum
+// in PSRAM next to a frequency-domain delay line of past
+// input spectra. Every block one FFT of (L + jR) goes in,
+// each partition is staged into DRAM and multiply-added,
+// one inverse FFT comes out. A mono IR has a Hermitian
+// spectrum, so L and R ride the real and imaginary parts
+// of a single complex transform.
+//
+// IR files: .wav (PCM 16/24/32 or float, channels are summed)
+// or .raw (mono float32 little-endian at the effect's rate),
+// /ir/default.wav in data/ unless setImpulse() picks another.
+// At most MAX_IR_MS of it is loaded: PSRAM for every partition
+// of a long file would buy nothing the CPU budget can convolve.
+//
+// params: 1 = wet mix, 2 = tail length (share of the loaded
+// partitions that is convolved, i.e. CPU spent)
+// =========================================================
+
+class FxConvolution : public FXBase {
+public:
+    static constexpr uint32_t MAX_IR_MS = 1500;    // the FX time budget convolves well under a second of it
+
+    FxConvolution() = default;
+
+    // IR the next instance loads
+    static inline void setImpulse(fs::FS* fs, const char* path) {
+        irFs_ = fs;
+        strncpy(irPath_, path, sizeof(irPath_) - 1);
+        irPath_[sizeof(irPath_) - 1] = 0;
+    }
+
+    FxMemory memoryNeeds(int sampleRate) const override {
+        IrInfo info;
+        uint32_t parts = 0;
+        fs::File f;
+        if (openIr(f, info)) {
+            parts = std::min(partitionsFor(outFrames(info, sampleRate)), maxPartitions(sampleRate));
+            f.close();
+        }
+        return { fastFloats(), parts * (specFloats() + frameFloats()) };
+    }
+
+    bool prepare(float* scratchFast, uint32_t fastSize, float* scratchSlow, uint32_t slowSize, int sampleRate) override {
+        sampleRate_ = sampleRate;
+        if (!scratchFast || fastSize < fastFloats() || !fft_.init(fftLen())) return false;
+
+        const uint32_t FRAME_FLOATS = frameFloats();
+        in_     = scratchFast;
+        work_   = in_ + FRAME_FLOATS;
+        acc_    = work_ + FRAME_FLOATS;
+        stageX_ = acc_ + FRAME_FLOATS;
+        stageH_ = stageX_ + FRAME_FLOATS;
+
+        capacity_ = scratchSlow ? slowSize / (specFloats() + FRAME_FLOATS) : 0;
+        spec_ = scratchSlow;
+        fdl_  = scratchSlow + capacity_ * specFloats();
+
+        loaded_ = capacity_ ? loadIr(sampleRate) : 0;
+        maxParts_ = measureBudget();
+        active_ = std::min(loaded_, maxParts_);
+
+        ESP_LOGI("CONV", "prepared slot %d | IR %s: %u ms loaded, %u ms in use | %d us budget fits %u ms of IR",
+                 slotId_, irPath_, partsToMs(loaded_), partsToMs(active_), fxBudgetUs(blockLen_), partsToMs(maxParts_));
+        prepared_ = true;
+        reset();
+        return true;
+    }
+
+    inline void reset() override {
+        if (!prepared_) return;
+        memset(in_, 0, frameFloats() * sizeof(float));
+        if (active_) memset(fdl_, 0, active_ * frameFloats() * sizeof(float));
+        head_ = 0;
+        enabled_ = true;
+    }
+
+    inline void processBlock(float* left, float* right, uint32_t frames) override {
+        if (!prepared_ || !active_) return;
+        const float mix = param(1) * MIDI_NORM;
+        const uint32_t parts = 1 + (uint32_t)(param(2) * MIDI_NORM * (active_ - 1) + 0.5f);
+        for (uint32_t off = 0; off + blockLen_ <= frames; off += blockLen_) {
+            convolve(left + off, right + off, mix, parts);
+        }
+    }
+
+    // longest IR the per-block CPU budget allows, measured at prepare()
+    inline uint32_t maxIrMs() const { return partsToMs(maxParts_); }
+    inline uint32_t activeIrMs() const { return partsToMs(active_); }
+
+private:
+    // partition = block (blockLen_), so the sizes follow the block length picked at boot
+    inline uint32_t fftLen() const      { return 2 * blockLen_; }
+    inline uint32_t frameFloats() const { return 4 * blockLen_; }          // full complex spectrum
+    inline uint32_t specFloats() const  { return 2 * (blockLen_ + 1); }    // bins 0..N/2 of a Hermitian spectrum
+    inline uint32_t fastFloats() const  { return 4 * frameFloats() + specFloats(); }
+
+    static inline fs::FS* irFs_ = &LittleFS;
+    static inline char irPath_[48] = "/ir/default.wav";
+
+    Fft fft_;
+    float* in_     = nullptr;   // overlap-save input, previous block then current
+    float* work_   = nullptr;   // current input spectrum
+    float* acc_    = nullptr;   // output spectrum accumulator
+    float* stageX_ = nullptr;   // DRAM window for one past spectrum
+    float* stageH_ = nullptr;   // DRAM window for one IR partition
+    float* spec_   = nullptr;   // PSRAM: IR partitions, SPEC_FLOATS each
+    float* fdl_    = nullptr;   // PSRAM: past input spectra, FRAME_FLOATS each
+
+    uint32_t capacity_ = 0;     // partitions the slow scratch holds
+    uint32_t loaded_   = 0;     // partitions the IR filled
+    uint32_t maxParts_ = 0;     // partitions the CPU budget allows
+    uint32_t active_   = 0;     // min(loaded_, maxParts_), also the delay line length
+    uint32_t head_     = 0;
+
+    struct IrInfo {
+        uint32_t frames = 0;
+        uint32_t rate = 0;          // 0: already at the effect's rate
+        uint16_t channels = 1;
+        uint16_t bits = 32;
+        uint16_t format = 3;        // 1 = PCM, 3 = float
+    };
+
+    inline uint32_t partsToMs(uint32_t parts) const { return (uint64_t)parts * blockLen_ * 1000 / sampleRate_; }
+    inline uint32_t partitionsFor(uint32_t frames) const { return (frames + blockLen_ - 1) / blockLen_; }
+    inline uint32_t maxPartitions(int sampleRate) const { return partitionsFor((uint64_t)MAX_IR_MS * sampleRate / 1000); }
+    static inline uint32_t outFrames(const IrInfo& info, int sampleRate) {
+        return info.rate ? (uint64_t)info.frames * sampleRate / info.rate : info.frames;
+    }
+
+    inline IRAM_ATTR void convolve(float* l, float* r, float mix, uint32_t parts) {
+        const uint32_t B = blockLen_;
+        const uint32_t FRAME_FLOATS = frameFloats();
+        const uint32_t SPEC_FLOATS = specFloats();
+        // current block into the second half: left in re, right in im
+        for (uint32_t i = 0; i < B; ++i) {
+            in_[2 * (B + i)]     = l[i];
+            in_[2 * (B + i) + 1] = r[i];
+        }
+        memcpy(work_, in_, FRAME_FLOATS * sizeof(float));
+        fft_.forward(work_);
+
+        head_ = (head_ + 1 == active_) ? 0 : head_ + 1;
+        memcpy(fdl_ + head_ * FRAME_FLOATS, work_, FRAME_FLOATS * sizeof(float));
+
+        memset(acc_, 0, FRAME_FLOATS * sizeof(float));
+        uint32_t idx = head_;
+        for (uint32_t p = 0; p < parts; ++p) {
+            const float* X = work_;
+            if (p) {
+                memcpy(stageX_, fdl_ + idx * FRAME_FLOATS, FRAME_FLOATS * sizeof(float));
+                X = stageX_;
+            }
+            memcpy(stageH_, spec_ + p * SPEC_FLOATS, SPEC_FLOATS * sizeof(float));
+            macHermitian(acc_, X, stageH_);
+            idx = idx ? idx - 1 : active_ - 1;
+        }
+
+        fft_.inverse(acc_);
+        const float dry = 1.0f - mix;
+        for (uint32_t i = 0; i < B; ++i) {
+            l[i] = l[i] * dry + acc_[2 * (B + i)]     * mix;
+            r[i] = r[i] * dry + acc_[2 * (B + i) + 1] * mix;
+        }
+        memcpy(in_, in_ + 2 * B, 2 * B * sizeof(float));
+    }
+
+    // Y += X * H over the full spectrum, H stored as bins 0..N/2 only
+    inline IRAM_ATTR __attribute__((always_inline))
+    void macHermitian(float* Y, const float* X, const float* H) const {
+        const uint32_t B = blockLen_;
+        const uint32_t N = 2 * B;
+        for (uint32_t k = 0; k <= B; ++k) {
+            const float hr = H[2 * k], hi = H[2 * k + 1];
+            const float xr = X[2 * k], xi = X[2 * k + 1];
+            Y[2 * k]     += xr * hr - xi * hi;
+            Y[2 * k + 1] += xr * hi + xi * hr;
+        }
+        for (uint32_t k = 1; k < B; ++k) {
+            const float hr = H[2 * k], hi = -H[2 * k + 1];
+            const uint32_t m = N - k;
+            const float xr = X[2 * m], xi = X[2 * m + 1];
+            Y[2 * m]     += xr * hr - xi * hi;
+            Y[2 * m + 1] += xr * hi + xi * hr;
+        }
+    }
+
+    // Cycles for one block with the fixed part (2 FFTs, mixing) plus per-partition staging and MAC
+    inline uint32_t measureBudget() {
+        if (!loaded_) return 0;
+        constexpr int RUNS = 8;
+        const uint32_t FRAME_FLOATS = frameFloats();
+        const uint32_t SPEC_FLOATS = specFloats();
+        memset(work_, 0, FRAME_FLOATS * sizeof(float));
+        uint32_t t0 = RDX_Platform::cycles();
+        for (int i = 0; i < RUNS; ++i) {
+            fft_.forward(work_);
+            fft_.inverse(work_);
+        }
+        const uint32_t fixed = (RDX_Platform::cycles() - t0) / RUNS + 4 * FRAME_FLOATS; // + copies and mixing
+        t0 = RDX_Platform::cycles();
+        for (int i = 0; i < RUNS; ++i) {
+            const uint32_t p = i % loaded_;
+            memcpy(stageX_, fdl_ + p * FRAME_FLOATS, FRAME_FLOATS * sizeof(float));
+            memcpy(stageH_, spec_ + p * SPEC_FLOATS, SPEC_FLOATS * sizeof(float));
+            macHermitian(acc_, stageX_, stageH_);
+        }
+        const uint32_t perPart = (RDX_Platform::cycles() - t0) / RUNS + 1;
+        const uint32_t budget = fxBudgetUs(blockLen_) * RDX_Platform::cpuMHz();
+        return budget > fixed ? (budget - fixed) / perPart : 0;
+    }
+
+    static inline bool openIr(fs::File& f, IrInfo& info) {
+        if (!irFs_) return false;
+        f = irFs_->open(irPath_, "r");
+        if (!f) return false;
+        const size_t len = strlen(irPath_);
+        if (len > 4 && !strcasecmp(irPath_ + len - 4, ".raw")) {
+            info = IrInfo();
+            info.frames = f.size() / sizeof(float);
+            return true;
+        }
+        return parseWav(f, info);
+    }
+
+    // leaves the file positioned at the first sample
+    static inline bool parseWav(fs::File& f, IrInfo& info) {
+        uint8_t h[12];
+        if (f.read(h, 12) != 12 || memcmp(h, "RIFF", 4) || memcmp(h + 8, "WAVE", 4)) return false;
+        bool haveFmt = false;
+        while (f.read(h, 8) == 8) {
+            const uint32_t size = h[4] | (h[5] << 8) | (h[6] << 16) | ((uint32_t)h[7] << 24);
+            if (!memcmp(h, "fmt ", 4)) {
+                uint8_t fmt[16];
+                if (size < 16 || f.read(fmt, 16) != 16) return false;
+                info.format   = fmt[0] | (fmt[1] << 8);
+                info.channels = fmt[2] | (fmt[3] << 8);
+                info.rate     = fmt[4] | (fmt[5] << 8) | (fmt[6] << 16) | ((uint32_t)fmt[7] << 24);
+                info.bits     = fmt[14] | (fmt[15] << 8);
+                if (info.format == 0xFFFE && size >= 26) info.format = 1;  // WAVE_FORMAT_EXTENSIBLE, assume PCM
+                f.seek(f.position() + size - 16 + (size & 1));
+                haveFmt = true;
+            } else if (!memcmp(h, "data", 4)) {
+                if (!haveFmt || !info.channels || !info.bits) return false;
+                info.frames = size / (info.channels * (info.bits / 8));
+                return (info.format == 1 && (info.bits == 16 || info.bits == 24 || info.bits == 32))
+                    || (info.format == 3 && info.bits == 32);
+            } else {
+                f.seek(f.position() + size + (size & 1));
+            }
+        }
+        return false;
+    }
+
+    static inline float decode(const uint8_t* p, const IrInfo& info) {
+        switch (info.bits) {
+            case 16: return (int16_t)(p[0] | (p[1] << 8)) * (1.0f / 32768.0f);
+            case 24: return (int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24)) * (1.0f / 2147483648.0f);
+            default:
+                if (info.format == 3) { float v; memcpy(&v, p, 4); return v; }
+                return (int32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24)) * (1.0f / 2147483648.0f);
+        }
+    }
+
+    // Reads, downmixes, resamples and normalises the IR, then stores one half spectrum per partition.
+    // Runs on the control side (prepare), never on the audio task.
+    inline uint32_t loadIr(int sampleRate) {
+        IrInfo info;
+        fs::File f;
+        if (!openIr(f, info)) {
+            ESP_LOGW("CONV", "no IR at %s", irPath_);
+            return 0;
+        }
+        const uint32_t B = blockLen_;
+        const uint32_t rateIn = info.rate ? info.rate : sampleRate;
+        const uint32_t full = partitionsFor(outFrames(info, sampleRate));
+        const uint32_t parts = std::min(capacity_, full);
+        if (parts < full) ESP_LOGW("CONV", "IR %s cut to %u of %u ms", irPath_, partsToMs(parts), partsToMs(full));
+        const uint32_t need = std::min<uint32_t>(info.frames, (uint64_t)parts * B * rateIn / sampleRate + 2);
+
+        float* h = (float*) heap_caps_malloc(need * sizeof(float), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (!h) {
+            f.close();
+            return 0;
+        }
+        const uint32_t frameBytes = info.channels * (info.bits / 8);
+        uint8_t chunk[256];
+        const uint32_t perChunk = sizeof(chunk) / frameBytes;
+        uint32_t got = 0;
+        while (got < need && perChunk) {
+            const uint32_t n = std::min(perChunk, need - got);
+            if (f.read(chunk, n * frameBytes) != n * frameBytes) break;
+            for (uint32_t i = 0; i < n; ++i) {
+                float s = 0.f;
+                for (uint32_t c = 0; c < info.channels; ++c) s += decode(chunk + i * frameBytes + c * (info.bits / 8), info);
+                h[got + i] = s;
+            }
+            got += n;
+        }
+        f.close();
+
+        float energy = 0.f;
+        for (uint32_t i = 0; i < got; ++i) energy += h[i] * h[i];
+        const float gain = energy > 0.f ? 1.0f / sqrtf(energy) : 0.f;
+
+        // linear resampling to the effect's rate, one partition at a time
+        const float step = (float)rateIn / (float)sampleRate;
+        for (uint32_t p = 0; p < parts; ++p) {
+            memset(work_, 0, frameFloats() * sizeof(float));
+            for (uint32_t i = 0; i < B; ++i) {
+                const float pos = (p * B + i) * step;
+                const uint32_t k = (uint32_t)pos;
+                if (k + 1 >= got) break;
+                const float frac = pos - k;
+                work_[2 * i] = (h[k] + frac * (h[k + 1] - h[k])) * gain;
+            }
+            fft_.forward(work_);
+            memcpy(spec_ + p * specFloats(), work_, specFloats() * sizeof(float));
+        }
+        heap_caps_free(h);
+        return parts;
+    }
+};
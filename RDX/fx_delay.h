@@ -35,28 +35,42 @@ public:
 
     virtual bool prepare(float* scratchFast, uint32_t fastSize, float* scratchSlow, uint32_t slowSize, int sampleRate) {
         sampleRate_ = sampleRate;
+        maxDelay_ = maxDelayFor(sampleRate);
 
-        // need space for 2 * MAX_DELAY samples
-        if (slowSize < MAX_DELAY * 2) return false;
+        // need space for 2 * maxDelay_ samples
+        if (slowSize < maxDelay_ * 2) return false;
 
         delayLine_l_ = scratchSlow;
-        delayLine_r_ = scratchSlow + MAX_DELAY;
-        std::memset(delayLine_l_, 0, sizeof(float) * MAX_DELAY);
-        std::memset(delayLine_r_, 0, sizeof(float) * MAX_DELAY);
+        delayLine_r_ = scratchSlow + maxDelay_;
+        std::memset(delayLine_l_, 0, sizeof(float) * maxDelay_);
+        std::memset(delayLine_r_, 0, sizeof(float) * maxDelay_);
+
+        // small DRAM windows the PSRAM line is staged through, one block per channel
+        if (scratchFast && fastSize >= blockLen_ * 2) {
+            stageL_ = scratchFast;
+            stageR_ = scratchFast + blockLen_;
+            stageLen_ = blockLen_;
+        } else {
+            stageL_ = stageR_ = nullptr;
+        }
 
         delayIn_ = 0;
         delayFeedback_ = 0.2f;
-        delayLen_ = MAX_DELAY / 4;
+        delayLen_ = maxDelay_ / 4;
         mode_ = DelayMode::Normal;
         prepared_ = true;
         return true;
     }
 
+    FxMemory memoryNeeds(int sampleRate) const override {
+        return { blockLen_ * 2, maxDelayFor(sampleRate) * 2 };
+    }
+
     inline void reset() override {
         if (prepared_) {
             delayIn_ = 0;
             delayFeedback_ = 0.2f;
-            delayLen_ = MAX_DELAY / 4;
+            delayLen_ = maxDelay_ / 4;
             mode_ = DelayMode::Normal;
         }
     }
@@ -64,14 +78,61 @@ public:
     inline void processBlock(float* left, float* right, uint32_t frames) override {
         if (!prepared_) return;
 
-        setFbParam( st.effects[slotId_][1] ) ;
-        setTimeParam( st.effects[slotId_][2] ); 
+        setFbParam( param(1) ) ;
+        setTimeParam( param(2) ); 
 
     //    setMode(modeParam > 63 ? DelayMode::PingPong : DelayMode::Normal);
 
-        for (int i = 0; i < frames; ++i) {
-            uint32_t outIndex = (delayIn_ + MAX_DELAY - delayLen_) ;
-            if (outIndex >= MAX_DELAY) outIndex -= MAX_DELAY;
+        // the read window must not overlap what this block writes
+        if (staging_ && stageL_ && frames <= stageLen_ && delayLen_ >= frames) {
+            processStaged(left, right, frames);
+        } else {
+            processDirect(left, right, frames);
+        }
+    }
+
+    // Whole-block PSRAM traffic: one contiguous read and one contiguous write
+    // per channel, the per-sample loop touches DRAM only
+    inline void processStaged(float* left, float* right, uint32_t frames) {
+        uint32_t outIndex = delayIn_ + maxDelay_ - delayLen_;
+        if (outIndex >= maxDelay_) outIndex -= maxDelay_;
+
+        ringRead(delayLine_l_, outIndex, stageL_, frames);
+        ringRead(delayLine_r_, outIndex, stageR_, frames);
+
+        const float fb = delayFeedback_;
+        const float dry = 1.0f - MIX;
+        const float wet = MIX;
+        const bool pingPong = (mode_ == DelayMode::PingPong);
+
+        for (uint32_t i = 0; i < frames; ++i) {
+            const float outL = stageL_[i];
+            const float outR = stageR_[i];
+
+            // the window is reused for what goes back into the line
+            if (pingPong) {
+                stageL_[i] = left[i]  + outR * fb;
+                stageR_[i] = right[i] + outL * fb;
+            } else {
+                stageL_[i] = left[i]  + outL * fb;
+                stageR_[i] = right[i] + outR * fb;
+            }
+
+            left[i]  = left[i]  * dry + outL * wet;
+            right[i] = right[i] * dry + outR * wet;
+        }
+
+        ringWrite(delayLine_l_, delayIn_, stageL_, frames);
+        ringWrite(delayLine_r_, delayIn_, stageR_, frames);
+
+        delayIn_ += frames;
+        if (delayIn_ >= maxDelay_) delayIn_ -= maxDelay_;
+    }
+
+    inline void processDirect(float* left, float* right, uint32_t frames) {
+        for (uint32_t i = 0; i < frames; ++i) {
+            uint32_t outIndex = (delayIn_ + maxDelay_ - delayLen_) ;
+            if (outIndex >= maxDelay_) outIndex -= maxDelay_;
             const float outL = delayLine_l_[outIndex];
             const float outR = delayLine_r_[outIndex];
 
@@ -88,10 +149,17 @@ public:
             right[i] = right[i] * (1.0f - MIX) + outR * MIX;
 
             delayIn_++;
-            if (delayIn_ >= MAX_DELAY) delayIn_ -= MAX_DELAY;
+            if (delayIn_ >= maxDelay_) delayIn_ -= maxDelay_;
         }
     }
 
+    // the feedback path is band-limited anyway, half rate halves the PSRAM line
+    uint8_t rateDivider() const override { return 2; }
+
+    // false: per-sample PSRAM access as before, kept for benchmarking
+    inline void setStaging(bool s) { staging_ = s; }
+    inline bool staging() const { return staging_; }
+
     inline void setslotId_(int idx) { slotId_ = idx; }
 
     inline void setFeedback(float value) { delayFeedback_ = fclamp(value, 0.0f, 0.95f); }
@@ -115,7 +183,7 @@ public:
     }
 
     inline void setCustomLength(float seconds) {
-        delayLen_ = fclamp((uint32_t)(seconds * sampleRate_), 1, MAX_DELAY - 1);
+        delayLen_ = fclamp((uint32_t)(seconds * sampleRate_), 1, maxDelay_ - 1);
     }
 
     inline void setMode(DelayMode m) { mode_ = m; }
@@ -139,19 +207,40 @@ private:
     int timeParam_ = 64;
     int fbParam_ = 64;
     float MIX = 0.14f;
-    RDX_Common& st = RDX_State::getState().workingPatch.common ;
 
+    uint32_t maxDelay_ = SAMPLE_RATE / 2;   // set in prepare() from the effect's own rate
+
+    static inline uint32_t maxDelayFor(int sampleRate) {
 #ifdef BOARD_HAS_PSRAM
-    static constexpr int MAX_DELAY = SAMPLE_RATE; // 1 second
+        return (uint32_t)sampleRate; // 1 second
 #else
-    static constexpr int MAX_DELAY = SAMPLE_RATE / 4; // 0.25 second
+        return (uint32_t)sampleRate / 4; // 0.25 second
 #endif
+    }
+
+    uint32_t stageLen_ = 0;                 // frames per window, the host's block length
+    float* stageL_ = nullptr;
+    float* stageR_ = nullptr;
+    bool staging_ = true;
+
+    // ring <-> linear copies, split in two where the window wraps
+    inline void ringRead(const float* ring, uint32_t pos, float* dst, uint32_t n) const {
+        const uint32_t first = std::min(n, maxDelay_ - pos);
+        memcpy(dst, ring + pos, first * sizeof(float));
+        if (first < n) memcpy(dst + first, ring, (n - first) * sizeof(float));
+    }
+
+    inline void ringWrite(float* ring, uint32_t pos, const float* src, uint32_t n) const {
+        const uint32_t first = std::min(n, maxDelay_ - pos);
+        memcpy(ring + pos, src, first * sizeof(float));
+        if (first < n) memcpy(ring, src + first, (n - first) * sizeof(float));
+    }
 
     float* delayLine_l_ = nullptr;
     float* delayLine_r_ = nullptr;
 
     float delayFeedback_ = 0.2f;
-    uint32_t delayLen_ = MAX_DELAY / 4;
+    uint32_t delayLen_ = maxDelay_ / 4;
     uint32_t delayIn_ = 0;
     DelayMode mode_ = DelayMode::Normal;
 };
@@ -50,8 +50,8 @@ public:
     inline void processBlock(float* l, float* r, uint32_t n) override {
         if (!enabled_) return;
 
-        setDrive(st.effects[slotId_][1] / 127.0f);
-        setTone(st.effects[slotId_][2] / 127.0f);
+        setDrive(param(1) / 127.0f);
+        setTone(param(2) / 127.0f);
 
         const float dg = driveGain_;
         const float mg = makeupGain_;
@@ -71,7 +71,6 @@ public:
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
     float driveParam_ = 0.5f;
     float driveGain_  = 1.f;
     float makeupGain_ = 1.f;
@@ -83,7 +82,7 @@ private:
     inline void calcToneCoeff() {
         // Map tone [0..1] → fc [300..8000 Hz]
         float fc = 300.f + tone_ * (8000.f - 300.f);
-        float x = expf(-2.f * M_PI * fc * DIV_SAMPLE_RATE);
+        float x = expf(-2.f * M_PI * fc / sampleRate_);
         toneCoef_ = 1.f - x;
     }
 };
@@ -0,0 +1,103 @@
+// fx_fft.h
+#pragma once
+#include <stdint.h>
+#include <cmath>
+
+// =========================================================
+// Complex radix-2 FFT on interleaved (re, im) floats, in place,
+// natural order in and out.
+// On the S3 the esp-dsp kernels are used when the library is
+// installed; otherwise (and on the host) a plain iterative
+// Cooley-Tukey with a precomputed twiddle table.
+// =========================================================
+
+#if __has_include(<esp_dsp.h>) && !defined(RDX_HOST)
+  #include <esp_dsp.h>
+  #define FX_FFT_ESP_DSP 1
+#else
+  #define FX_FFT_ESP_DSP 0
+#endif
+
+constexpr uint32_t FFT_MAX_N = 512;    // 2 * the largest block the FX chain runs
+
+class Fft {
+public:
+    inline bool init(uint32_t n) {
+        if (n < 2 || n > FFT_MAX_N || (n & (n - 1))) return false;
+        n_ = n;
+#if FX_FFT_ESP_DSP
+        static bool tablesReady = false;   // esp-dsp keeps one shared table
+        if (!tablesReady) {
+            if (dsps_fft2r_init_fc32(nullptr, CONFIG_DSP_MAX_FFT_SIZE) != ESP_OK) return false;
+            tablesReady = true;
+        }
+#else
+        for (uint32_t k = 0; k < n / 2; ++k) {
+            const float a = -2.0f * (float)M_PI * k / n;
+            tw_[2 * k]     = cosf(a);
+            tw_[2 * k + 1] = sinf(a);
+        }
+#endif
+        return true;
+    }
+
+    inline uint32_t size() const { return n_; }
+
+    inline IRAM_ATTR void forward(float* data) const {
+#if FX_FFT_ESP_DSP
+        dsps_fft2r_fc32(data, n_);
+        dsps_bit_rev_fc32(data, n_);
+#else
+        bitReverse(data);
+        for (uint32_t len = 2; len <= n_; len <<= 1) {
+            const uint32_t half = len >> 1;
+            const uint32_t step = n_ / len;
+            for (uint32_t i = 0; i < n_; i += len) {
+                for (uint32_t j = 0; j < half; ++j) {
+                    const float wr = tw_[2 * j * step];
+                    const float wi = tw_[2 * j * step + 1];
+                    float* a = data + 2 * (i + j);
+                    float* b = data + 2 * (i + j + half);
+                    const float tr = b[0] * wr - b[1] * wi;
+                    const float ti = b[0] * wi + b[1] * wr;
+                    b[0] = a[0] - tr;
+                    b[1] = a[1] - ti;
+                    a[0] += tr;
+                    a[1] += ti;
+                }
+            }
+        }
+#endif
+    }
+
+    // scaled by 1/n, so inverse(forward(x)) == x
+    inline IRAM_ATTR void inverse(float* data) const {
+        // conj -> forward -> conj
+        for (uint32_t i = 0; i < n_; ++i) data[2 * i + 1] = -data[2 * i + 1];
+        forward(data);
+        const float k = 1.0f / n_;
+        for (uint32_t i = 0; i < n_; ++i) {
+            data[2 * i]     *= k;
+            data[2 * i + 1] *= -k;
+        }
+    }
+
+private:
+    uint32_t n_ = 0;
+#if !FX_FFT_ESP_DSP
+    float tw_[FFT_MAX_N];
+
+    inline void bitReverse(float* data) const {
+        for (uint32_t i = 1, j = 0; i < n_; ++i) {
+            uint32_t bit = n_ >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j ^= bit;
+            if (i < j) {
+                float t;
+                t = data[2 * i];     data[2 * i]     = data[2 * j];     data[2 * j]     = t;
+                t = data[2 * i + 1]; data[2 * i + 1] = data[2 * j + 1]; data[2 * j + 1] = t;
+            }
+        }
+    }
+#endif
+};
@@ -2,6 +2,7 @@
 #pragma once
 #include "fx_base.h"
 #include "misc.h"
+#include "fx_moddelay.h"
 #include <cstring>
 
 class FxFlanger : public FXBase {
@@ -10,7 +11,6 @@ public:
         FXBase::init(sampleRate, slot);
         setDepth(0.5f);
         setRate(0.5f);
-        writeIndex_ = 0;
         lfoPhase_ = 0.f;
         lfoCur_ = 0.f;
         prepared_ = false;
@@ -18,18 +18,20 @@ public:
 
     inline bool prepare(float* scratchFast, uint32_t fastSize, float*, uint32_t, int sampleRate) override {
         sampleRate_ = sampleRate;
-        bufferSize_ = std::min<int>(fastSize / 2, (int)(0.015f * sampleRate) + 4); // 15 ms max
-        delayL_ = scratchFast;
-        delayR_ = scratchFast + bufferSize_;
-        memset(delayL_, 0, bufferSize_ * 2 * sizeof(float));
+        if (!line_.init(scratchFast, fastSize, MAX_DELAY_SEC * sampleRate)) return false;
+        line_.setInterp(ModInterp::LINEAR);
         prepared_ = true;
         updateParams();
         return true;
     }
 
+    FxMemory memoryNeeds(int sampleRate) const override {
+        return { ModDelayLine::floatsFor(MAX_DELAY_SEC * sampleRate), 0 };
+    }
+
     inline void reset() override {
         if (prepared_) {            
-            writeIndex_ = 0;
+            line_.clear();
             depth_ = 0.5f;
             rate_ = 0.5f;
             minDelay_ = 0.f;
@@ -47,42 +49,23 @@ public:
     inline void processBlock(float* l, float* r, uint32_t n) override {
         if (!enabled_ || !prepared_) return;
 
-        setDepth(st.effects[slotId_][1] );
-        setRate(st.effects[slotId_][2] );
+        setDepth(param(1) );
+        setRate(param(2) );
         updateParams();
 
-        for (uint32_t i = 0; i < n; ++i) {
-            float phase = lfoPhase_ + (float)i * lfoInc_;
-            if (phase >= 1.f) phase -= 1.f;
-            float lfo = 0.5f + 0.5f * sin01(phase);
-            float dSamp = minDelay_ + (maxDelay_ - minDelay_) * lfo;
-
-            float dL = getDelayed(delayL_, dSamp);
-            float dR = getDelayed(delayR_, dSamp * 1.1f);
-
-            float outL = (l[i] + dL) * mixDry_;
-            float outR = (r[i] + dR) * mixDry_;
-
-            delayL_[writeIndex_] = l[i] + dL * mixWet_;
-            delayR_[writeIndex_] = r[i] + dR * mixWet_;
-
-            l[i] = outL;
-            r[i] = outR;
-
-            writeIndex_++;
-            if (writeIndex_ >= bufferSize_) writeIndex_ = 0;
-        }
+        float endPhase = lfoPhase_ + (float)n * lfoInc_;
+        if (endPhase >= 1.f) endPhase -= 1.f;
+        const float dA = delayAt(lfoPhase_);
+        const float dB = delayAt(endPhase);
+        lfoPhase_ = endPhase;
 
-        lfoPhase_ += rate_ * (float)n / sampleRate_;
-        if (lfoPhase_ >= 1.f) lfoPhase_ -= 1.f;
+        // out = (in + delayed) * dry, fed back at mixWet_
+        line_.processRamp(l, r, n, dA, dB, dA * 1.1f, dB * 1.1f, mixDry_, mixDry_, mixWet_);
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
-    float* delayL_ = nullptr;
-    float* delayR_ = nullptr;
-    int bufferSize_ = 0;
-    int writeIndex_ = 0;
+    static constexpr float MAX_DELAY_SEC = 0.015f;
+    ModDelayLine line_;
 
     int depthParam_ = 64;
     int rateParam_  = 64;
@@ -111,13 +94,8 @@ private:
         maxDelay_ = minDelay_ + depth_ * 0.010f * sampleRate_;
     }
 
-    inline IRAM_ATTR __attribute__((always_inline))
-    float getDelayed(float* buf, float delaySamp) {
-        float readPos = writeIndex_ - delaySamp;
-        if (readPos < 0) readPos += bufferSize_;
-        int i1 = (int)readPos;
-        int i2 = (i1 + 1) % bufferSize_;
-        float frac = readPos - i1;
-        return buf[i1] * (1.f - frac) + buf[i2] * frac;
+    inline float delayAt(float phase) const {
+        const float lfo = 0.5f + 0.5f * sin01(phase);
+        return minDelay_ + (maxDelay_ - minDelay_) * lfo;
     }
 };
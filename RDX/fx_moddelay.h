@@ -0,0 +1,171 @@
+// fx_moddelay.h
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include "config.h"
+#include "misc.h"
+
+// =========================================================
+// Stereo modulated delay line shared by chorus, flanger and
+// the phaser's flanger stage.
+//
+// - power-of-two ring, index wrap is a mask
+// - L and R lanes interleaved, one index serves both channels
+// - delay trajectories are computed per block by the effect
+//   (usually a linear ramp between two LFO evaluations),
+//   so the inner loop has no LFO math in it
+// - linear, first-order allpass or 4-point Hermite reads
+//
+// Delay is measured from the slot about to be written:
+// 1.0 is the previous input sample.
+// =========================================================
+
+enum class ModInterp : uint8_t {
+    LINEAR = 0,
+    ALLPASS,
+    CUBIC
+};
+
+class ModDelayLine {
+public:
+    static constexpr float MIN_DELAY = 3.0f;   // the cubic read needs two samples ahead of the read point
+
+    // buf holds interleaved L/R frames; the ring gets the largest power of two
+    // that fits in bufLen floats and covers maxDelay samples
+    inline bool init(float* buf, uint32_t bufLen, float maxDelay) {
+        const uint32_t frames = framesFor(maxDelay);
+        if (!buf || frames * 2 > bufLen) {
+            buf_ = nullptr;
+            return false;
+        }
+        buf_ = buf;
+        mask_ = frames - 1;
+        maxDelay_ = (float)(frames - 4);
+        clear();
+        return true;
+    }
+
+    // ring length for a given longest delay, and the floats init() will take for it
+    static inline uint32_t framesFor(float maxDelay) {
+        uint32_t frames = 1;
+        while (frames < (uint32_t)maxDelay + 4) frames <<= 1;
+        return frames;
+    }
+    static inline uint32_t floatsFor(float maxDelay) { return framesFor(maxDelay) * 2; }
+
+    inline void clear() {
+        if (buf_) memset(buf_, 0, (mask_ + 1) * 2 * sizeof(float));
+        writeIdx_ = 0;
+        apL_ = apR_ = 0.f;
+    }
+
+    inline void setInterp(ModInterp m) { interp_ = m; }
+    inline ModInterp interp() const { return interp_; }
+    inline uint32_t frames() const { return mask_ + 1; }
+    inline bool ready() const { return buf_ != nullptr; }
+
+    // Fill dst[0..n) with a straight line from `from` towards `to` (reached at n)
+    static inline void ramp(float* dst, uint32_t n, float from, float to) {
+        const float inc = (to - from) / (float)n;
+        for (uint32_t i = 0; i < n; ++i) {
+            dst[i] = from;
+            from += inc;
+        }
+    }
+
+    // Per frame: read both lanes at delayL[i] / delayR[i] samples, then write
+    // in + feedback * delayed. outL/outR may alias delayL/delayR.
+    inline IRAM_ATTR void process(const float* inL, const float* inR,
+                                  const float* delayL, const float* delayR,
+                                  float* outL, float* outR, uint32_t n, float feedback = 0.f) {
+        if (!buf_) return;
+        switch (interp_) {
+            case ModInterp::ALLPASS: run<ModInterp::ALLPASS>(inL, inR, delayL, delayR, outL, outR, n, feedback); break;
+            case ModInterp::CUBIC:   run<ModInterp::CUBIC>  (inL, inR, delayL, delayR, outL, outR, n, feedback); break;
+            default:                 run<ModInterp::LINEAR> (inL, inR, delayL, delayR, outL, outR, n, feedback); break;
+        }
+    }
+
+    // Common case: delays ramp linearly across the block, output mixed in place,
+    // out = in * dry + delayed * wet
+    inline IRAM_ATTR void processRamp(float* l, float* r, uint32_t n,
+                                      float fromL, float toL, float fromR, float toR,
+                                      float dry, float wet, float feedback = 0.f) {
+        if (!buf_) return;
+        const float incL = (toL - fromL) / (float)n;
+        const float incR = (toR - fromR) / (float)n;
+        for (uint32_t done = 0; done < n; ) {
+            const uint32_t len = (n - done < TRAJ_LEN) ? (n - done) : TRAJ_LEN;
+            ramp(trajL_, len, fromL, fromL + incL * len);
+            ramp(trajR_, len, fromR, fromR + incR * len);
+            fromL += incL * len;
+            fromR += incR * len;
+            process(l + done, r + done, trajL_, trajR_, trajL_, trajR_, len, feedback);
+            for (uint32_t i = 0; i < len; ++i) {
+                l[done + i] = l[done + i] * dry + trajL_[i] * wet;
+                r[done + i] = r[done + i] * dry + trajR_[i] * wet;
+            }
+            done += len;
+        }
+    }
+
+private:
+    // trajectory scratch is shared: effects run one at a time on the audio task
+    static constexpr uint32_t TRAJ_LEN = DMA_BUFFER_LEN;
+    static inline float trajL_[TRAJ_LEN];
+    static inline float trajR_[TRAJ_LEN];
+
+    float*      buf_      = nullptr;
+    uint32_t    mask_     = 0;
+    uint32_t    writeIdx_ = 0;
+    float       maxDelay_ = 0.f;
+    ModInterp   interp_   = ModInterp::LINEAR;
+    float       apL_ = 0.f, apR_ = 0.f;     // allpass interpolator state
+
+    inline float at(uint32_t idx, int lane) const { return buf_[((idx & mask_) << 1) + lane]; }
+
+    template <ModInterp I>
+    inline IRAM_ATTR __attribute__((always_inline))
+    float read(float delay, int lane, float& apState) const {
+        delay = fclamp(delay, MIN_DELAY, maxDelay_);
+        const float pos = (float)(writeIdx_ + mask_ + 1) - delay;   // never negative
+        const uint32_t i = (uint32_t)pos;
+        const float f = pos - (float)i;
+        const float x0 = at(i, lane);
+        const float x1 = at(i + 1, lane);
+
+        if (I == ModInterp::LINEAR) {
+            return x0 + f * (x1 - x0);
+        } else if (I == ModInterp::ALLPASS) {
+            // fractional delay of (1 - f) behind x1
+            const float a = f / (2.0f - f);
+            apState = a * (x1 - apState) + x0;
+            return apState;
+        } else {
+            const float xm1 = at(i - 1, lane);
+            const float x2  = at(i + 2, lane);
+            const float c1 = 0.5f * (x1 - xm1);
+            const float c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+            const float c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+            return ((c3 * f + c2) * f + c1) * f + x0;
+        }
+    }
+
+    template <ModInterp I>
+    inline IRAM_ATTR __attribute__((always_inline))
+    void run(const float* inL, const float* inR, const float* delayL, const float* delayR,
+             float* outL, float* outR, uint32_t n, float feedback) {
+        float apL = apL_, apR = apR_;
+        for (uint32_t k = 0; k < n; ++k) {
+            const float yL = read<I>(delayL[k], 0, apL);
+            const float yR = read<I>(delayR[k], 1, apR);
+            float* w = buf_ + ((writeIdx_ & mask_) << 1);
+            w[0] = inL[k] + yL * feedback;
+            w[1] = inR[k] + yR * feedback;
+            outL[k] = yL;
+            outR[k] = yR;
+            writeIdx_ = (writeIdx_ + 1) & mask_;
+        }
+        apL_ = apL; apR_ = apR;
+    }
+};
@@ -0,0 +1,182 @@
+// fx_multirate.h
+#pragma once
+#include <stdint.h>
+#include <cstring>
+#include "config.h"
+#include "misc.h"
+#include "fx_base.h"
+
+// =========================================================
+// Half-band polyphase resampling for effects that run at
+// sampleRate / 2 or sampleRate / 4.
+//
+// 27-tap half-band FIR (Kaiser, beta 5): flat to 0.18 fs,
+// ~54 dB down above 0.32 fs. Every other tap is zero, so only
+// HB_PAIRS multiplies (plus the centre tap) are spent per output.
+// =========================================================
+
+constexpr int HB_PAIRS = 7;
+constexpr int HB_DEC_HIST = 4 * HB_PAIRS - 2;   // input samples the decimator looks back
+constexpr int HB_INT_HIST = 2 * HB_PAIRS - 1;   // input samples the interpolator looks back
+
+static constexpr float HB_COEF[HB_PAIRS] = {
+    0.314115768f, -0.094069034f, 0.045230323f, -0.022699933f, 0.010493597f, -0.003969573f, 0.000898852f
+};
+
+// n input samples -> n/2 output samples, in-place (out == in) is fine
+class HalfbandDecimator {
+public:
+    inline void reset() { memset(buf_, 0, sizeof(buf_)); }
+
+    inline IRAM_ATTR void process(const float* in, float* out, uint32_t n) {
+        memcpy(buf_ + HB_DEC_HIST, in, n * sizeof(float));
+        const float* x = buf_ + HB_DEC_HIST - (2 * HB_PAIRS - 1);
+        for (uint32_t m = 0; m < n / 2; ++m) {
+            const float* c = x + 2 * m;          // centre tap
+            float acc = 0.5f * c[0];
+            for (int k = 0; k < HB_PAIRS; ++k) {
+                acc += HB_COEF[k] * (c[2 * k + 1] + c[-2 * k - 1]);
+            }
+            out[m] = acc;
+        }
+        memmove(buf_, buf_ + n, HB_DEC_HIST * sizeof(float));
+    }
+
+private:
+    float buf_[HB_DEC_HIST + MAX_BLOCK_LEN] = {0};
+};
+
+// n input samples -> 2n output samples, out must not alias in
+class HalfbandInterpolator {
+public:
+    inline void reset() { memset(buf_, 0, sizeof(buf_)); }
+
+    inline IRAM_ATTR void process(const float* in, float* out, uint32_t n) {
+        memcpy(buf_ + HB_INT_HIST, in, n * sizeof(float));
+        const float* x = buf_ + HB_INT_HIST;
+        for (uint32_t m = 0; m < n; ++m) {
+            const float* c = x + m;
+            float acc = 0.f;
+            for (int k = 0; k < HB_PAIRS; ++k) {
+                acc += HB_COEF[k] * (c[-HB_PAIRS - k] + c[-HB_PAIRS + 1 + k]);
+            }
+            out[2 * m]     = 2.0f * acc;
+            out[2 * m + 1] = c[-(HB_PAIRS - 1)];
+        }
+        memmove(buf_, buf_ + n, HB_INT_HIST * sizeof(float));
+    }
+
+private:
+    float buf_[HB_INT_HIST + MAX_BLOCK_LEN] = {0};
+};
+
+
+// =========================================================
+// Per-slot multirate wrapper.
+// The dry signal stays at full rate: only the difference the
+// effect makes (out - in at the low rate) is interpolated back,
+// so the decimation filters colour nothing but the wet path.
+// The dry path is delayed by the filters' group delay
+// (26 samples at rate/2, 78 at rate/4) to stay phase aligned.
+// =========================================================
+class FxMultirate {
+public:
+    static constexpr int MAX_STAGES = 2; // rate / 4
+
+    inline void reset() {
+        for (int s = 0; s < MAX_STAGES; ++s) {
+            decL_[s].reset(); decR_[s].reset();
+            intL_[s].reset(); intR_[s].reset();
+        }
+        memset(alignL_, 0, sizeof(alignL_));
+        memset(alignR_, 0, sizeof(alignR_));
+        alignIdx_ = 0;
+    }
+
+    // group delay of the down + up filter chain, in full-rate samples
+    static constexpr int latency(int stages) { return 2 * (2 * HB_PAIRS - 1) * ((1 << stages) - 1); }
+
+    // pcm != nullptr: also emit the result as interleaved 16-bit PCM from the final merge loop
+    inline IRAM_ATTR void process(FXBase* fx, float* left, float* right, uint32_t n, int16_t* pcm = nullptr) {
+        const uint8_t div = fx->rateDivider();
+        const int stages = (div >= 4) ? 2 : (div >= 2) ? 1 : 0;
+        if (stages == 0 || (n & ((1u << stages) - 1))) {
+            fx->processBlock(left, right, n);
+            if (pcm) floatToPcm16(left, right, pcm, n);
+            return;
+        }
+
+        // full rate -> low rate
+        uint32_t len = n;
+        decL_[0].process(left,  lowL_, len);
+        decR_[0].process(right, lowR_, len);
+        len >>= 1;
+        for (int s = 1; s < stages; ++s) {
+            decL_[s].process(lowL_, lowL_, len);
+            decR_[s].process(lowR_, lowR_, len);
+            len >>= 1;
+        }
+
+        memcpy(dryL_, lowL_, len * sizeof(float));
+        memcpy(dryR_, lowR_, len * sizeof(float));
+
+        fx->processBlock(lowL_, lowR_, len);
+
+        for (uint32_t i = 0; i < len; ++i) {
+            lowL_[i] -= dryL_[i];
+            lowR_[i] -= dryR_[i];
+        }
+
+        // low rate -> full rate, ping-ponging between the two scratch pairs
+        float* srcL = lowL_;
+        float* srcR = lowR_;
+        float* dstL = dryL_;
+        float* dstR = dryR_;
+        for (int s = stages - 1; s >= 0; --s) {
+            intL_[s].process(srcL, dstL, len);
+            intR_[s].process(srcR, dstR, len);
+            len <<= 1;
+            float* t;
+            t = srcL; srcL = dstL; dstL = t;
+            t = srcR; srcR = dstR; dstR = t;
+        }
+
+        const uint32_t lat = latency(stages);
+        if (pcm) {
+            uint32_t* out = (uint32_t*)pcm;
+            for (uint32_t i = 0; i < n; ++i) {
+                alignL_[alignIdx_] = left[i];
+                alignR_[alignIdx_] = right[i];
+                const uint32_t rd = (alignIdx_ - lat) & ALIGN_MASK;
+                left[i]  = alignL_[rd] + srcL[i];
+                right[i] = alignR_[rd] + srcR[i];
+                out[i] = pcm16Frame(left[i], right[i]);
+                alignIdx_ = (alignIdx_ + 1) & ALIGN_MASK;
+            }
+            return;
+        }
+        for (uint32_t i = 0; i < n; ++i) {
+            alignL_[alignIdx_] = left[i];
+            alignR_[alignIdx_] = right[i];
+            const uint32_t rd = (alignIdx_ - lat) & ALIGN_MASK;
+            left[i]  = alignL_[rd] + srcL[i];
+            right[i] = alignR_[rd] + srcR[i];
+            alignIdx_ = (alignIdx_ + 1) & ALIGN_MASK;
+        }
+    }
+
+private:
+    HalfbandDecimator    decL_[MAX_STAGES], decR_[MAX_STAGES];
+    HalfbandInterpolator intL_[MAX_STAGES], intR_[MAX_STAGES];
+
+    float lowL_[MAX_BLOCK_LEN];
+    float lowR_[MAX_BLOCK_LEN];
+    float dryL_[MAX_BLOCK_LEN];
+    float dryR_[MAX_BLOCK_LEN];
+
+    static constexpr uint32_t ALIGN_LEN = 128;    // power of two, > latency(MAX_STAGES)
+    static constexpr uint32_t ALIGN_MASK = ALIGN_LEN - 1;
+    float alignL_[ALIGN_LEN] = {0};
+    float alignR_[ALIGN_LEN] = {0};
+    uint32_t alignIdx_ = 0;
+};
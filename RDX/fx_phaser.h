@@ -2,6 +2,8 @@
 #include "config.h"
 #include "misc.h"
 #include "fx_base.h"
+#include "fx_moddelay.h"
+#include "fx_cascade.h"
 #include <cmath>
 
 class FxPhaser : public FXBase {
@@ -17,31 +19,34 @@ public:
         // Reset phaser
         resetPhaser();
 
-        // Flanger remains untouched
-        if (scratchFastLen >= FLANGER_BUF_SIZE * 2) {
-            delayL_ = scratchFast;
-            delayR_ = scratchFast + FLANGER_BUF_SIZE;
-            flangerWritePos_ = 0;
-        }
+        // Flanger is optional: without scratch the phaser runs alone
+        flanger_.init(scratchFast, scratchFastLen, MAX_FLANGER_DEPTH * sampleRate);
+        flanger_.setInterp(ModInterp::LINEAR);
 
         prepared_ = true;
         return true;
     }
 
+    FxMemory memoryNeeds(int sampleRate) const override {
+        return { ModDelayLine::floatsFor(MAX_FLANGER_DEPTH * sampleRate), 0 };
+    }
+
     inline void processBlock(float* left, float* right, uint32_t frames) override {
         if (!prepared_) return;
 
-        setDepth(st.effects[slotId_][1] );
-        setRate(st.effects[slotId_][2] );
+        setDepth(param(1) );
+        setRate(param(2) );
         updatePhaserCoeffs(frames);
-        updateFlangerLFO(frames); 
 
-        for (uint32_t i = 0; i < frames; ++i) {
-            // Stereo 2-notch phaser
-            processPhaserSample(left[i], right[i]);
-            // Flanger 
-            processFlangerSample(left[i], right[i]);
+        // Stereo 2-notch phaser
+        if (split_) {
+            for (uint32_t i = 0; i < frames; ++i) processPhaserSample<true>(left[i], right[i]);
+        } else {
+            for (uint32_t i = 0; i < frames; ++i) processPhaserSample<false>(left[i], right[i]);
         }
+
+        // Flanger, on the phaser output
+        processFlanger(left, right, frames);
     }
 
     inline void reset() override {
@@ -76,13 +81,16 @@ public:
         flangerRate_ = LFO_SPEED[r] * 0.5f;  // adjust multiplier if needed
     }
 
+    // the per-channel notch loop from before the 2-lane cascade, for A/B benchmarks
+    inline void setSplit(bool s) { split_ = s; }
+    inline bool split() const { return split_; }
+
 
 private:
 
     uint8_t lastDepth_ = 0xFF;  // cache last MIDI value
     uint8_t lastRate_  = 0xFF;
 
-    static constexpr int FLANGER_BUF_SIZE = 4096;
     static constexpr float MAX_FLANGER_DEPTH = 0.03f;
     float flangerDepth_ = 0.01f;  // mapped depth in seconds for flanger
     float flangerRate_  = 0.25f;  // mapped LFO increment for flanger
@@ -98,15 +106,15 @@ private:
         return 1.f - fabsf(2.f * phase - 1.f); 
     }
 
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
     int sampleRate_ = SAMPLE_RATE;
     bool prepared_ = false;
+    bool split_ = false;
 
     // --------------- Phaser ------------------
     static constexpr int NUM_NOTCHES = 2;
     float FREQ_LOW[NUM_NOTCHES] = { 90.f, 500.0f }; // known lower notch frequencies
     float fNotch_[NUM_NOTCHES]{};
-    float z1L_[NUM_NOTCHES]{}, z1R_[NUM_NOTCHES]{};
+    AllpassCascade2<NUM_NOTCHES> notches_;
     float alpha_[NUM_NOTCHES]{};
     float alphaTarget_[NUM_NOTCHES]{};
     float prev_inL_ = 0.f, prev_outL_ = 0.f;
@@ -117,19 +125,13 @@ private:
     float depthSemitones_ = 24.f;
 
     // --- Stereo Flanger ---
-    float* delayL_ = nullptr;
-    float* delayR_ = nullptr;
-    uint32_t flangerWritePos_ = 0;    
+    ModDelayLine flanger_;
     float flangerPhaseL_ = 0.f;
     float flangerPhaseR_ = 0.5f; // 180° offset
-    uint32_t flangerWritePosL_ = 0;
-    uint32_t flangerWritePosR_ = 0;
 
 
     inline void resetPhaser() {
-        for (int i = 0; i < NUM_NOTCHES; ++i) {
-            z1L_[i] = z1R_[i] = 0.f;
-        }
+        notches_.reset();
         prev_inL_ = prev_outL_ = 0.f;
         prev_inR_ = prev_outR_ = 0.f;
         feedbackL_ = feedbackR_ = 0.f;
@@ -150,10 +152,17 @@ private:
             alpha_[i] += 0.15f * (alphaTarget_[i] - alpha_[i]);   // 0.1–0.2 works well
 
         }
+        // the cascade glides there across the block; the split loop jumps
+        if (split_) {
+            for (int i = 0; i < NUM_NOTCHES; ++i) notches_.setCoef(i, alpha_[i]);
+        } else {
+            notches_.glideTo(alpha_, frames);
+        }
     }
 
 
 
+    template <bool SPLIT>
     inline void processPhaserSample(float& left, float& right) {
         float yL = dcBlock(left,  prev_inL_, prev_outL_, DcTimeConst_);
         yL += feedbackL_ * phaserFb_;
@@ -161,25 +170,13 @@ private:
         float yR = dcBlock(right, prev_inR_, prev_outR_, DcTimeConst_);
         yR += feedbackR_ * phaserFb_;
 
-        for (int n = 0; n < 1; ++n) {
-            for (int i = 0; i < NUM_NOTCHES; ++i) {
-                // left
-                float tL = -alpha_[i] * yL + z1L_[i];
-                z1L_[i] = yL + alpha_[i] * tL;
-                yL = tL;
-
-                // right
-                float tR = -alpha_[i] * yR + z1R_[i];
-                z1R_[i] = yR + alpha_[i] * tR;
-                yR = tR;
-            }
-        }
+        const Lanes2 y = SPLIT ? notches_.tickSplit({ yL, yR }) : notches_.tick({ yL, yR });
 
-        feedbackL_ = yL;
-        feedbackR_ = yR;
+        feedbackL_ = y.l;
+        feedbackR_ = y.r;
 
-        left  = left  * (1.f - phaserMix_) + yL * phaserMix_;
-        right = right * (1.f - phaserMix_) + yR * phaserMix_;
+        left  = left  * (1.f - phaserMix_) + y.l * phaserMix_;
+        right = right * (1.f - phaserMix_) + y.r * phaserMix_;
     }
 
 
@@ -187,60 +184,25 @@ private:
 
     // ---------------- flanger ----------------
     inline void resetFlanger() {
-        if (!delayL_ || !delayR_) return;
-        for (uint32_t i = 0; i < FLANGER_BUF_SIZE; ++i) delayL_[i] = delayR_[i] = 0.f;
-        flangerWritePos_ = 0;
+        flanger_.clear();
         flangerPhaseL_ = 0.f;
         flangerPhaseR_ = 0.5f;
     }
 
-    inline void updateFlangerLFO(uint32_t frames) {
-        float inc = flangerRate_ * frames * DIV_SAMPLE_RATE;
+    inline void processFlanger(float* l, float* r, uint32_t frames) {
+        if (!flanger_.ready()) return;
+        // modulation at the block edges, ramped in between
+        const float depthSamp = flangerDepth_ * sampleRate_;
+        const float lfoA = 0.6f * triLFO(flangerPhaseL_);
+        const float inc = flangerRate_ * frames / (float)sampleRate_;
         flangerPhaseL_ = wrap01(flangerPhaseL_ + inc);
         flangerPhaseR_ = wrap01(flangerPhaseR_ + inc);
-    }
-
-
-    inline void processFlangerSample(float& l, float& r) {
-        if (!delayL_ || !delayR_) return;
-        float lfoL = 0.6f * triLFO(flangerPhaseL_) ;
-        float modL = (0.1f + lfoL) * flangerDepth_ * sampleRate_;
-        float modR = (0.7f - lfoL) * flangerDepth_ * sampleRate_;
-
-        // Compute fractional read index
-        float readPosL = flangerWritePosL_ - modL;
-        if (readPosL < 0.f) readPosL += FLANGER_BUF_SIZE;
-
-        // Integer + fractional part
-        uint32_t iL = (uint32_t)readPosL;
-        uint32_t iL2 = (iL + 1) & (FLANGER_BUF_SIZE - 1);   // only works if buf size is power of 2
-        float fracL = readPosL - (float)iL;
-
-        // Linear interpolation
-        float outL = delayL_[iL] * (1.f - fracL) + delayL_[iL2] * fracL;
-
-        // Compute fractional read index
-        float readPosR = flangerWritePosR_ - modR;
-        if (readPosR < 0.f) readPosR += FLANGER_BUF_SIZE;
-
-        // Integer + fractional part
-        uint32_t iR = (uint32_t)readPosR;
-        uint32_t iR2 = (iR + 1) & (FLANGER_BUF_SIZE - 1);   // only works if buf size is power of 2
-        float fracR = readPosR - (float)iR;
-
-        // Linear interpolation
-        float outR = delayL_[iR] * (1.f - fracR) + delayL_[iR2] * fracR;
-
-        delayL_[flangerWritePosL_] = l;
-        delayR_[flangerWritePosR_] = r;
-
-        l = l * (1.f - flangerMix_) + outL * flangerMix_;
-        r = r * (1.f - flangerMix_) + outR * flangerMix_;
+        const float lfoB = 0.6f * triLFO(flangerPhaseL_);
 
-        flangerWritePosL_ = (flangerWritePosL_ + 1) % FLANGER_BUF_SIZE;
-        if (flangerWritePosL_ >= FLANGER_BUF_SIZE) flangerWritePosL_ -= FLANGER_BUF_SIZE;
-        flangerWritePosR_ = (flangerWritePosR_ + 1) % FLANGER_BUF_SIZE;
-        if (flangerWritePosR_ >= FLANGER_BUF_SIZE) flangerWritePosR_ -= FLANGER_BUF_SIZE;
+        flanger_.processRamp(l, r, frames,
+                             (0.1f + lfoA) * depthSamp, (0.1f + lfoB) * depthSamp,
+                             (0.7f - lfoA) * depthSamp, (0.7f - lfoB) * depthSamp,
+                             1.f - flangerMix_, flangerMix_);
     }
 
     inline IRAM_ATTR __attribute__((always_inline))
@@ -3,7 +3,7 @@
 
 
 #include "fx_base.h"
-#include "esp32-hal.h"
+#include "RDX_Platform.h"
 #include <cmath>
 #include <cstring>
 
@@ -23,6 +23,9 @@ public:
     {
         (void)scratchSlow; (void)slowSize;
         sampleRate_ = sampleRate; 
+        DcTimeConst = 1.0f - 2.0f * M_PI * DC_FC / sampleRate_;
+
+        if (!scratchFast || fastSize < tankFloats(sampleRate)) return false;
 
         float* ptr = scratchFast;
 
@@ -48,7 +51,7 @@ public:
         }
 
         uint32_t used = ptr - scratchFast;
-        ESP_LOGI("Reverb", "prepared slot %d: %.1f kB DRAM used", slotId_, used * 4 / 1024.0f);
+        RDX_LOGI("Reverb", "prepared slot %d: %.1f kB DRAM used", slotId_, used * 4 / 1024.0f);
         prepared_ = true;
         return true;
     }
@@ -61,11 +64,16 @@ public:
         prev_out = 0.0f;
     }
 
+    // the tail is dark anyway: run the tank at half rate, halving comb memory and cost
+    uint8_t rateDivider() const override { return 2; }
+
+    FxMemory memoryNeeds(int sampleRate) const override { return { tankFloats(sampleRate), 0 }; }
+
     inline void processBlock(float* L, float* R, uint32_t n) override {
         if (!prepared_) return;
 
-        float depth = st.effects[slotId_][1] / 127.0f * 0.2f;
-        float time  = st.effects[slotId_][2] / 127.0f;
+        float depth = param(1) / 127.0f * 0.2f;
+        float time  = param(2) / 127.0f;
         updateFeedback(time);
 
         for (uint32_t i=0; i<n; ++i) {
@@ -80,7 +88,6 @@ public:
     }
 
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
     float* combBuf_[2][NUM_COMBS];
     int combSize_[2][NUM_COMBS];
     int combIdx_[2][NUM_COMBS];
@@ -99,13 +106,24 @@ private:
     // DC blocking
     float prev_in = 0.0f;
     float prev_out = 0.0f;
-    float DcTimeConst = 0.996f; // ~15-20 Hz, float R = 1.0f - 2.0f * M_PI * fc / sampleRate; // fc in Hz
+    static constexpr float DC_FC = 28.0f;   // DC blocker corner, Hz
+    float DcTimeConst = 0.996f; // 1 - 2 pi fc / sampleRate, set in prepare()
+
+    // same lengths prepare() carves out
+    static inline uint32_t tankFloats(int sampleRate) {
+        uint32_t n = 0;
+        for (int ch=0; ch<2; ++ch) {
+            for (int i=0; i<NUM_COMBS; ++i)     n += int((comb_lengths_ms[i] / 1000.f) * sampleRate) + ch * 17;
+            for (int i=0; i<NUM_ALLPASSES; ++i) n += int((allpass_lengths_ms[i] / 1000.f) * sampleRate) + i + ch;
+        }
+        return n;
+    }
 
     inline void updateFeedback(float t) {
         if (fabsf(t - lastTime_) < 1e-4f) return;
         float rt60 = 0.25f * powf(24.f, t); // 0.25–6 s range
         for (int i=0; i<NUM_COMBS; ++i) {
-            float delaySec = combSize_[0][i] * DIV_SAMPLE_RATE;
+            float delaySec = combSize_[0][i] / sampleRate_;
             float g = powf(10.0f, -3.0f * delaySec / rt60);
             combGain_[i] = fminf(g, 0.95f);
         }
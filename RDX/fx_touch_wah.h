@@ -2,6 +2,7 @@
 #include "config.h"
 #include "misc.h"
 #include "fx_base.h"
+#include "fx_cascade.h"
 
 class FxTouchWah : public FXBase {
 public:
@@ -17,8 +18,8 @@ public:
     inline void processBlock(float* left, float* right, uint32_t frames) override {
         if (!prepared_) return;
 
-        const uint8_t sensParam = st.effects[slotId_][1];
-        const uint8_t resoParam = st.effects[slotId_][2];
+        const uint8_t sensParam = param(1);
+        const uint8_t resoParam = param(2);
         setSens(sensParam);
         setReso(resoParam);
 
@@ -29,31 +30,27 @@ public:
                 recovering_ = false;
             }
         }
+        if (split_) { processSplit(left, right, frames); return; }
 
-        const float minF = 0.02f;
-        const float maxF = 0.4f;
+        // envelope follower over the block, the cascade glides to where it ends
         const float envAttack = 0.02f + 0.08f * sens_;
-        const float envRelease = 0.003f;
-
         float env = env_;
-        float a = a_; // current allpass coefficient
+        for (uint32_t i = 0; i < frames; ++i) {
+            float level = 0.5f * (fabsf(left[i]) + fabsf(right[i]));
+            float coeff = (level > env) ? envAttack : ENV_RELEASE;
+            env += (level - env) * coeff;
+        }
+        env_ = env;
+
+        cascade_.glideTo(envToCoef(env), frames);
+
+        const float fb = (FEEDBACK_BASE + reso_ * 0.2f) * recoveryFade_;
+        const float mixAmt = WET_DRY_MIX * recoveryFade_;
 
         for (uint32_t i = 0; i < frames; ++i) {
             float l = left[i];
             float r = right[i];
 
-            // envelope follower
-            float level = 0.5f * (fabsf(l) + fabsf(r));
-            float coeff = (level > env) ? envAttack : envRelease;
-            env += (level - env) * coeff;
-
-            // update coeff occasionally (every 8 samples)
-            if ((i & 7) == 0) {
-                float freq = minF + (maxF - minF) * env * sens_;
-                freq = fclamp(freq, minF, maxF);
-                a = (1.f - freq) / (1.f + freq); // recompute only occasionally
-            }
-
             // DC removal
             float xL = l - prevInL_ + DC_TC * prevOutL_;
             prevInL_ = l;
@@ -62,41 +59,24 @@ public:
             prevInR_ = r;
             prevOutR_ = xR;
 
-            float fb = (FEEDBACK_BASE + reso_ * 0.2f) * recoveryFade_;
-            xL += feedbackL_ * fb;
-            xR += feedbackR_ * fb;
-
-            // 6-stage cascade
-            for (int s = 0; s < STAGES; ++s) {
-                float yL = -a * xL + z1L_[s];
-                z1L_[s] = xL + a * yL;
-                xL = yL;
-
-                float yR = -a * xR + z1R_[s];
-                z1R_[s] = xR + a * yR;
-                xR = yR;
-            }
+            // 6-stage cascade, both channels at once
+            Lanes2 y = cascade_.tick({ xL + feedbackL_ * fb, xR + feedbackR_ * fb });
 
-            feedbackL_ = xL * reso_;
-            feedbackR_ = xR * reso_;
+            feedbackL_ = y.l * reso_;
+            feedbackR_ = y.r * reso_;
 
-            float mixAmt = WET_DRY_MIX * recoveryFade_;
-            left[i]  = l * (1.f - mixAmt) + xL * mixAmt;
-            right[i] = r * (1.f - mixAmt) + xR * mixAmt;
+            left[i]  = l * (1.f - mixAmt) + y.l * mixAmt;
+            right[i] = r * (1.f - mixAmt) + y.r * mixAmt;
         }
-
-        env_ = env;
-        a_ = a;
     }
 
     inline void reset(bool instant = false) {
         if (!prepared_) return;
-        memset(z1L_, 0, sizeof(z1L_));
-        memset(z1R_, 0, sizeof(z1R_));
+        cascade_.reset();
+        cascade_.setCoef(0.5f);
 
         feedbackL_ = 0.f, feedbackR_ = 0.f;
         env_ = 0.f;
-        a_ = 0.5f;
         sens_ = 0.5f;
         reso_ = 0.5f;
 
@@ -106,30 +86,76 @@ public:
         prevOutR_ = 0.f;
     }
 
+    // the per-channel loop from before the 2-lane cascade, for A/B benchmarks
+    inline void setSplit(bool s) { split_ = s; }
+    inline bool split() const { return split_; }
+
 private:
-    RDX_Common& st = RDX_State::getState().workingPatch.common;
 
     static constexpr int STAGES = 6;
     static constexpr float FEEDBACK_BASE = 0.6f;
     static constexpr float WET_DRY_MIX = 0.7f;
     static constexpr float DC_TC = 0.996f;
+    static constexpr float MIN_F = 0.02f;
+    static constexpr float MAX_F = 0.4f;
+    static constexpr float ENV_RELEASE = 0.003f;
 
     bool prepared_ = false;
+    bool split_ = false;
     bool recovering_ = false;
     float recoveryFade_ = 1.f;
     int sampleRate_ = SAMPLE_RATE;
 
-    float z1L_[STAGES]{};
-    float z1R_[STAGES]{};
+    AllpassCascade2<STAGES> cascade_;
     float feedbackL_ = 0.f, feedbackR_ = 0.f;
     float env_ = 0.f;
-    float a_ = 0.5f;
     float sens_ = 0.5f;
     float reso_ = 0.5f;
 
     float prevInL_ = 0.f, prevOutL_ = 0.f;
     float prevInR_ = 0.f, prevOutR_ = 0.f;
 
+    inline float envToCoef(float env) const {
+        const float freq = fclamp(MIN_F + (MAX_F - MIN_F) * env * sens_, MIN_F, MAX_F);
+        return (1.f - freq) / (1.f + freq);
+    }
+
+    // The old per-sample loop: follower, coefficient every 8 samples
+    // and feedback inline, the cascade one channel after the other
+    inline void processSplit(float* left, float* right, uint32_t frames) {
+        const float envAttack = 0.02f + 0.08f * sens_;
+        float env = env_;
+
+        for (uint32_t i = 0; i < frames; ++i) {
+            float l = left[i];
+            float r = right[i];
+
+            float level = 0.5f * (fabsf(l) + fabsf(r));
+            float coeff = (level > env) ? envAttack : ENV_RELEASE;
+            env += (level - env) * coeff;
+
+            if ((i & 7) == 0) cascade_.setCoef(envToCoef(env));
+
+            float xL = l - prevInL_ + DC_TC * prevOutL_;
+            prevInL_ = l;
+            prevOutL_ = xL;
+            float xR = r - prevInR_ + DC_TC * prevOutR_;
+            prevInR_ = r;
+            prevOutR_ = xR;
+
+            float fb = (FEEDBACK_BASE + reso_ * 0.2f) * recoveryFade_;
+            Lanes2 y = cascade_.tickSplit({ xL + feedbackL_ * fb, xR + feedbackR_ * fb });
+
+            feedbackL_ = y.l * reso_;
+            feedbackR_ = y.r * reso_;
+
+            float mixAmt = WET_DRY_MIX * recoveryFade_;
+            left[i]  = l * (1.f - mixAmt) + y.l * mixAmt;
+            right[i] = r * (1.f - mixAmt) + y.r * mixAmt;
+        }
+        env_ = env;
+    }
+
     inline void setSens(uint8_t s) { sens_ = s * MIDI_NORM; }
     inline void setReso(uint8_t r) { reso_ = 0.4f +  r * 0.7f * MIDI_NORM; }
 };
@@ -2,7 +2,7 @@
 
 
 
-#include "esp_heap_caps.h"
+#include "RDX_Platform.h"
 
 
 
@@ -24,16 +24,62 @@ inline  IRAM_ATTR __attribute__((always_inline)) float saturate_cubic(float x) {
 }
 
 inline float __attribute__((always_inline)) IRAM_ATTR fast_floorf(float x) {
-    int i = (int)x - (int)(i>x);
-    return (float)i;
+    int i = (int)x;
+    return (float)(i - (int)((float)i > x));
 }
 
 inline float __attribute__((always_inline)) IRAM_ATTR wrap01(float x)  {
     return x - fast_floorf(x);
 }
 
+// float -> 16-bit PCM, rounded and saturated at +/-1.0
+// On Xtensa ROUND.S scales by 2^15 while converting and CLAMPS saturates, two instructions per sample.
+// LSB is forced to 1 so the DAC never sees digital silence and doesn't auto-mute.
+inline int32_t __attribute__((always_inline)) IRAM_ATTR pcm16(float x) {
+#if defined(__XTENSA__)
+    int32_t v;
+    asm ("round.s %0, %1, 15" : "=a"(v) : "f"(x));
+    asm ("clamps %0, %0, 15" : "+a"(v));
+#else
+    float s = x * 32768.0f;
+    s = (s > 32767.0f) ? 32767.0f : (s < -32768.0f) ? -32768.0f : s;
+    int32_t v = (int32_t)lrintf(s);
+#endif
+    return v | 1;
+}
+
+// one stereo frame as the I2S DMA expects it: L in the low half-word, R in the high one
+inline uint32_t __attribute__((always_inline)) IRAM_ATTR pcm16Frame(float l, float r) {
+    return (uint16_t)pcm16(l) | ((uint32_t)(uint16_t)pcm16(r) << 16);
+}
+
+// L/R float blocks -> interleaved 16-bit PCM, one 32-bit store per frame
+inline void IRAM_ATTR floatToPcm16(const float* L, const float* R, int16_t* dst, uint32_t n) {
+    uint32_t* out = (uint32_t*)dst;
+    for (uint32_t i = 0; i < n; ++i) out[i] = pcm16Frame(L[i], R[i]);
+}
 
-void logMemoryStats(const char* tag = "MEM") {
+// interleaved 16-bit PCM -> L/R float blocks, one 32-bit load per frame; mix: add onto what's there
+inline void IRAM_ATTR pcm16ToFloat(const int16_t* src, float* L, float* R, uint32_t n, bool mix = false) {
+    constexpr float k = 1.0f / 32768.0f;
+    const uint32_t* in = (const uint32_t*)src;
+    if (mix) {
+        for (uint32_t i = 0; i < n; ++i) {
+            const uint32_t f = in[i];
+            L[i] += (float)(int16_t)(f & 0xFFFF) * k;
+            R[i] += (float)(int16_t)(f >> 16) * k;
+        }
+    } else {
+        for (uint32_t i = 0; i < n; ++i) {
+            const uint32_t f = in[i];
+            L[i] = (float)(int16_t)(f & 0xFFFF) * k;
+            R[i] = (float)(int16_t)(f >> 16) * k;
+        }
+    }
+}
+
+
+inline void logMemoryStats(const char* tag = "MEM") {
     uint32_t dram_free  = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
     uint32_t dram_largest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL);
     uint32_t psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
@@ -46,6 +92,9 @@ void logMemoryStats(const char* tag = "MEM") {
 
 inline uint32_t lfsr_ = 0x12345678;
 
+// restarts randomFloat() from a known state (reproducible renders); xorshift needs a non-zero seed
+inline void seedRandom(uint32_t seed) { lfsr_ = seed ? seed : 0x12345678; }
+
 inline float randomFloat() {
     lfsr_ ^= lfsr_ << 13;
     lfsr_ ^= lfsr_ >> 17;
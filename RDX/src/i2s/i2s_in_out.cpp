@@ -19,6 +19,67 @@ static const char* TAG = "I2SAUDIO";
       MALLOC_CAP_INVALID  Memory can't be used / list end marker
 */
 
+#ifdef I2S_ZERO_COPY_OUT
+// TX DMA buffer done: it is free until the DMA wraps around to it again
+bool IRAM_ATTR I2S_Audio::onTxSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    I2S_Audio* self = (I2S_Audio*)user_ctx;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)
+    void* buf = event->dma_buf;
+#else
+    void* buf = *(void**)event->data;
+#endif
+    // the previous one is still waiting: the audio task missed it and it plays again
+    if (self->_tx_started && uxQueueMessagesWaitingFromISR(self->_tx_free)) self->_underruns = self->_underruns + 1;
+    BaseType_t woken = pdFALSE;
+    xQueueOverwriteFromISR(self->_tx_free, &buf, &woken);
+    return woken == pdTRUE;
+}
+
+// RX DMA buffer filled: newest block wins, an unclaimed older one is an overrun
+bool IRAM_ATTR I2S_Audio::onRxRecv(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx) {
+    I2S_Audio* self = (I2S_Audio*)user_ctx;
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 4, 0)
+    void* buf = event->dma_buf;
+#else
+    void* buf = *(void**)event->data;
+#endif
+    if (self->_rx_started && uxQueueMessagesWaitingFromISR(self->_rx_full)) self->_overruns = self->_overruns + 1;
+    BaseType_t woken = pdFALSE;
+    xQueueOverwriteFromISR(self->_rx_full, &buf, &woken);
+    return woken == pdTRUE;
+}
+#endif
+
+const int16_t* I2S_Audio::acquireInputBuffer() {
+#ifdef I2S_ZERO_COPY_OUT
+    if (_rx_full) {
+        void* buf = nullptr;
+        xQueueReceive(_rx_full, &buf, portMAX_DELAY);
+        _rx_started = true;
+        return (const int16_t*)buf;
+    }
+#endif
+#if (CHANNEL_SAMPLE_BYTES == 2)
+    if (!_input_buf) return nullptr;
+    readBuffer(_input_buf);
+    return (const int16_t*)_input_buf;
+#else
+    return nullptr;
+#endif
+}
+
+int16_t* I2S_Audio::acquireOutputBuffer() {
+#ifdef I2S_ZERO_COPY_OUT
+    if (!_tx_free) return nullptr;
+    void* buf = nullptr;
+    xQueueReceive(_tx_free, &buf, portMAX_DELAY);
+    _tx_started = true;
+    return (int16_t*)buf;
+#else
+    return nullptr;
+#endif
+}
+
 BUF_TYPE* I2S_Audio::allocateBuffer(const char* name) {
     BUF_TYPE* buf = (BUF_TYPE*)heap_caps_calloc(16, _buffer_size, _malloc_caps);
     if (!buf) {
@@ -33,6 +94,7 @@ void I2S_Audio::init(eI2sMode select_mode) {
 	_i2s_mode = select_mode;
 	_read_remain_smp = 0;
 	_write_remain_smp = 0;
+	_buffer_size = _channel_num * _buffer_len * sizeof(BUF_TYPE);
 	
 #ifndef USE_V3
 	i2s_mode_t port_mode;
@@ -59,6 +121,9 @@ void I2S_Audio::init(eI2sMode select_mode) {
       pinMode(I2S_DOUT_PIN, OUTPUT);
       pinMode(I2S_DIN_PIN, INPUT);
       _input_buf = allocateBuffer("_input_buf");
+    #ifdef I2S_ZERO_COPY_OUT
+      if (_zero_copy) break;
+    #endif
       _output_buf = allocateBuffer("_output_buf");
       break;
     case MODE_OUT:
@@ -67,6 +132,9 @@ void I2S_Audio::init(eI2sMode select_mode) {
       port_mode = (i2s_mode_t)( I2S_MODE_MASTER | I2S_MODE_TX );
     #endif
       pinMode(I2S_DOUT_PIN, OUTPUT);
+    #ifdef I2S_ZERO_COPY_OUT
+      if (_zero_copy) break; // blocks go straight into the DMA buffers
+    #endif
       _output_buf = allocateBuffer("_output_buf");
 
   }
@@ -75,20 +143,25 @@ void I2S_Audio::init(eI2sMode select_mode) {
 
 #ifdef USE_V3
 
+  const bool use_tx = (_i2s_mode != MODE_IN);
+  const bool use_rx = (_i2s_mode != MODE_OUT);
+
+  // TX and RX on one controller share BCLK/WS: a duplex pair is clock-locked,
+  // every input block arrives together with an output buffer freeing up
   i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(_i2s_port, I2S_ROLE_MASTER);
-    chan_cfg.dma_frame_num = DMA_BUFFER_LEN;
-    chan_cfg.dma_desc_num = DMA_BUFFER_NUM;
-  i2s_new_channel(&chan_cfg, &tx_handle, &rx_handle);
+    chan_cfg.dma_frame_num = _buffer_len;
+    chan_cfg.dma_desc_num = _buffer_num;
+  i2s_new_channel(&chan_cfg, use_tx ? &tx_handle : nullptr, use_rx ? &rx_handle : nullptr);
   i2s_std_config_t std_cfg = {
-      .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SAMPLE_RATE),
+      .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(_sample_rate),
     //  .slot_cfg = I2S_STD_MSB_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
       .slot_cfg = I2S_STD_PHILIP_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_16BIT, I2S_SLOT_MODE_STEREO),
       .gpio_cfg = {
           .mclk = I2S_GPIO_UNUSED,
           .bclk = (gpio_num_t)I2S_BCLK_PIN,
           .ws = (gpio_num_t)I2S_WCLK_PIN,
-          .dout = (gpio_num_t)I2S_DOUT_PIN,
-          .din = I2S_GPIO_UNUSED,
+          .dout = use_tx ? (gpio_num_t)I2S_DOUT_PIN : I2S_GPIO_UNUSED,
+          .din = use_rx ? (gpio_num_t)I2S_DIN_PIN : I2S_GPIO_UNUSED,
           .invert_flags = {
               .mclk_inv = false,
               .bclk_inv = false,
@@ -97,10 +170,42 @@ void I2S_Audio::init(eI2sMode select_mode) {
       },
   };
 
-  i2s_channel_init_std_mode(tx_handle, &std_cfg);
-  i2s_channel_enable(tx_handle);
+  if (use_tx) i2s_channel_init_std_mode(tx_handle, &std_cfg);
+  if (use_rx) i2s_channel_init_std_mode(rx_handle, &std_cfg);
+
+#ifdef I2S_ZERO_COPY_OUT
+  // callbacks can only be registered before the channel is enabled;
+  // DMA auto-clear stays off (default), the buffers must keep what we write into them
+  if (_zero_copy && use_tx) {
+    _tx_free = xQueueCreate(1, sizeof(void*));
+    i2s_event_callbacks_t cbs = {};
+    cbs.on_sent = onTxSent;
+    if (!_tx_free || i2s_channel_register_event_callback(tx_handle, &cbs, this) != ESP_OK) {
+      ESP_LOGE(TAG, "Zero-copy output unavailable, using buffered writes");
+      if (_tx_free) { vQueueDelete(_tx_free); _tx_free = nullptr; }
+      _output_buf = allocateBuffer("_output_buf");
+    } else {
+      ESP_LOGI(TAG, "Zero-copy output: latency %d samples (%.2f ms)", getOutputLatencySmp(), 1000.0f * getOutputLatencySmp() / _sample_rate);
+    }
+  }
+  // input side: each RX DMA buffer is read where the DMA left it, until it wraps around to it again
+  if (_zero_copy && use_rx) {
+    _rx_full = xQueueCreate(1, sizeof(void*));
+    i2s_event_callbacks_t cbs = {};
+    cbs.on_recv = onRxRecv;
+    if (!_rx_full || i2s_channel_register_event_callback(rx_handle, &cbs, this) != ESP_OK) {
+      ESP_LOGE(TAG, "Zero-copy input unavailable, using buffered reads");
+      if (_rx_full) { vQueueDelete(_rx_full); _rx_full = nullptr; }
+    }
+  }
+#endif
+
+  // RX first, so the first TX buffer never goes out before its matching input starts
+  if (use_rx) i2s_channel_enable(rx_handle);
+  if (use_tx) i2s_channel_enable(tx_handle);
   
-  ESP_LOGI(TAG, "I2S started: BCK %d, WCK %d, DAT %d", I2S_BCLK_PIN, I2S_WCLK_PIN, I2S_DOUT_PIN);
+  ESP_LOGI(TAG, "I2S started: BCK %d, WCK %d, DOUT %d, DIN %d", I2S_BCLK_PIN, I2S_WCLK_PIN,
+           use_tx ? I2S_DOUT_PIN : -1, use_rx ? I2S_DIN_PIN : -1);
   
   
   
@@ -113,8 +218,8 @@ void I2S_Audio::init(eI2sMode select_mode) {
     .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
     .communication_format = (i2s_comm_format_t)(I2S_COMM_FORMAT_STAND_I2S ),
     .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
-    .dma_buf_count = DMA_BUFFER_NUM,
-    .dma_buf_len = DMA_BUFFER_LEN,
+    .dma_buf_count = _buffer_num,
+    .dma_buf_len = _buffer_len,
     .use_apll = true,
     .tx_desc_auto_clear = true,
   //  .fixed_mclk = 0
@@ -144,8 +249,14 @@ void I2S_Audio::deInit() {
 	if (_input_buf) { free(_input_buf); _input_buf = nullptr; }
 	if (_output_buf) { free(_output_buf); _output_buf = nullptr; }
 #ifdef USE_V3  
-	i2s_channel_disable(tx_handle);
-	i2s_del_channel(tx_handle);
+	if (tx_handle) { i2s_channel_disable(tx_handle); i2s_del_channel(tx_handle); tx_handle = nullptr; }
+	if (rx_handle) { i2s_channel_disable(rx_handle); i2s_del_channel(rx_handle); rx_handle = nullptr; }
+  #ifdef I2S_ZERO_COPY_OUT
+	if (_tx_free) { vQueueDelete(_tx_free); _tx_free = nullptr; }
+	if (_rx_full) { vQueueDelete(_rx_full); _rx_full = nullptr; }
+	_tx_started = false;
+	_rx_started = false;
+  #endif
 #else
 	i2s_zero_dma_buffer(_i2s_port);
 	i2s_driver_uninstall(_i2s_port);
@@ -158,7 +269,7 @@ void   I2S_Audio::readBuffer(BUF_TYPE* buf) {
 	int32_t err = 0;
 #ifdef USE_V3
 	err = i2s_channel_read(rx_handle, buf, _buffer_size, &bytes_read, portMAX_DELAY);
-	_read_remain_smp = DMA_BUFFER_LEN;
+	_read_remain_smp = _buffer_len;
 #else
 	err = i2s_read(_i2s_port, (void*) buf, _buffer_size, &bytes_read, portMAX_DELAY);
 #endif
@@ -191,7 +302,7 @@ void I2S_Audio::getSamples(float& sampleLeft, float& sampleRight){
 }
 
 void I2S_Audio::getSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf ){
-  int n = DMA_BUFFER_LEN - _read_remain_smp;
+  int n = _buffer_len - _read_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   *sampleLeft = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n ]);
   *sampleRight = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n + 1]);
@@ -205,7 +316,7 @@ void I2S_Audio::getSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf
 }
 
 void I2S_Audio::getSamples(float& sampleLeft, float& sampleRight, BUF_TYPE* buf ){  
-  int n = DMA_BUFFER_LEN - _read_remain_smp;
+  int n = _buffer_len - _read_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   sampleLeft = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n ]);
   sampleRight = convertInSample(_input_buf[AUDIO_CHANNEL_NUM * n + 1]);
@@ -227,7 +338,7 @@ void I2S_Audio::putSamples(float& sampleLeft, float& sampleRight){
 }
 
 void I2S_Audio::putSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf ){
-  int n = DMA_BUFFER_LEN - _write_remain_smp;
+  int n = _buffer_len - _write_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   buf[AUDIO_CHANNEL_NUM * n ] = convertOutSample(*sampleLeft);
   buf[AUDIO_CHANNEL_NUM * n + 1] = convertOutSample(*sampleRight);
@@ -241,7 +352,7 @@ void I2S_Audio::putSamples(float* sampleLeft, float* sampleRight, BUF_TYPE* buf
 }
 
 void I2S_Audio::putSamples(float& sampleLeft, float& sampleRight, BUF_TYPE* buf ){
-  int n = DMA_BUFFER_LEN - _write_remain_smp;
+  int n = _buffer_len - _write_remain_smp;
 #if AUDIO_CHANNEL_NUM == 2
   buf[AUDIO_CHANNEL_NUM * n ] = convertOutSample(sampleLeft);
   buf[AUDIO_CHANNEL_NUM * n + 1] = convertOutSample(sampleRight);
@@ -257,17 +368,7 @@ void I2S_Audio::putSamples(float& sampleLeft, float& sampleRight, BUF_TYPE* buf
 void I2S_Audio::writeBuffers(float* L, float* R) {
     if (!_output_buf) return;
 
-    for (int i = 0; i < DMA_BUFFER_LEN; ++i) {
-        int16_t l = convertOutSample(L[i]);
-        int16_t r = convertOutSample(R[i]);
-
-#if CHANNEL_SAMPLE_BYTES == 4
-        _output_buf[i] = (uint16_t)l | ((uint32_t)(uint16_t)r << 16);
-#else
-        _output_buf[2 * i + 0] = l;
-        _output_buf[2 * i + 1] = r;
-#endif
-    }
+    convertBuffers(L, R, _output_buf);
 
 #ifdef USE_V3  
     size_t bytes_written = 0;
@@ -278,11 +379,25 @@ void I2S_Audio::writeBuffers(float* L, float* R) {
 #endif
 }
 
+void I2S_Audio::convertBuffers(const float* L, const float* R, BUF_TYPE* dst) {
+    for (int i = 0; i < _buffer_len; ++i) {
+        int16_t l = convertOutSample(L[i]);
+        int16_t r = convertOutSample(R[i]);
+
+#if CHANNEL_SAMPLE_BYTES == 4
+        dst[i] = (uint16_t)l | ((uint32_t)(uint16_t)r << 16);
+#else
+        dst[2 * i + 0] = l;
+        dst[2 * i + 1] = r;
+#endif
+    }
+}
+
 
 void I2S_Audio::writeBuffersQ24_8(int32_t* L, int32_t* R) {    
   if (!_output_buf) return;
 
-    for (int i = 0; i < DMA_BUFFER_LEN; ++i) {
+    for (int i = 0; i < _buffer_len; ++i) {
         _output_buf[2*i + 0] = convertOutSampleQ24_8(L[i]);
         _output_buf[2*i + 1] = convertOutSampleQ24_8(R[i]);
     }
@@ -23,6 +23,9 @@
   #define USE_V3
   // ESP Arduino cores 3.0.0 and up
   #include "driver/i2s_std.h"
+  #if (CHANNEL_SAMPLE_BYTES == 2)
+    #define I2S_ZERO_COPY_OUT   // render straight into the TX DMA buffers, see setZeroCopyOut()
+  #endif
 #endif
 
 // converting between float and int here assumes that float signal is normalized within -1.0 .. 1.0 range
@@ -79,12 +82,37 @@ class  I2S_Audio {
     inline eI2sMode             getMode()                         { return _i2s_mode; }
     inline void                 setSampleRate(int sr)             {_sample_rate = constrain(sr, 0, 192000); }
     inline int32_t              getSampleRate()                   { return _sample_rate; }
+    // DMA geometry, set before init(): frames per buffer (= the audio block) and number of buffers
+    inline void                 setBufferLen(int len)             {_buffer_len = constrain(len, MIN_BLOCK_LEN, MAX_BLOCK_LEN); }
+    inline void                 setBufferNum(int num)             {_buffer_num = constrain(num, 2, MAX_DMA_BUFFER_NUM); }
     
     // functions that read/write the whole built-in buffers
     void                        readBuffer()                      { readBuffer(_input_buf); }
     void                        writeBuffer()                     { writeBuffer(_output_buf); }
 
     void                        writeBuffers(float* L, float* R);
+    void                        convertBuffers(const float* L, const float* R, BUF_TYPE* dst); // writeBuffers()' conversion alone, into any block-sized buffer
+
+    /** zero-copy output (IDF 5 driver, 16-bit samples only)
+     * Call setZeroCopyOut(true) before init(). Every TX DMA buffer the hardware has just finished
+     * is handed back by the on_sent interrupt; acquireOutputBuffer() waits for it and the caller
+     * writes the next block into it in place (interleaved L/R int16). It plays after the other
+     * setBufferNum()-1 buffers, so the output latency is fixed, and there's no i2s_channel_write() copy.
+     * Falls back to writeBuffers() (acquireOutputBuffer() returns nullptr) where unsupported.
+    */
+    inline void                 setZeroCopyOut(bool on)           { _zero_copy = on; }
+    int16_t*                    acquireOutputBuffer();
+    inline uint32_t             getUnderruns()                    { return _underruns; }       // blocks replayed because the buffer wasn't refilled in time
+    inline int                  getOutputLatencySmp()             { return _buffer_len * (_buffer_num - 1); }
+
+    /** input side of the same scheme (MODE_IN / MODE_IN_OUT)
+     * acquireInputBuffer() waits for the RX DMA buffer just filled and returns it in place (interleaved
+     * L/R int16), valid until the DMA wraps around to it again. TX and RX share the clocks, so in
+     * MODE_IN_OUT every input block is matched by one freed output buffer. Without zero-copy it falls
+     * back to readBuffer() into the internal input buffer; nullptr if the samples aren't 16-bit.
+    */
+    const int16_t*              acquireInputBuffer();
+    inline uint32_t             getOverruns()                     { return _overruns; }        // input blocks dropped because they weren't taken in time
 
 
     // functions that read/write the whole custom buffers supplied via pointer argument
@@ -142,6 +170,7 @@ class  I2S_Audio {
     inline BUF_TYPE     convertOutSampleQ24_8(int32_t smp) { return (BUF_TYPE)(smp >> 8); } // Q24.8 -> 16-bit I2S
     inline int					getBufSizeBytes()				    { return _buffer_len * WHOLE_SAMPLE_BYTES; }
     inline int					getBufLenSmp()					    { return _buffer_len; }
+    inline int					getBufNum()					        { return _buffer_num; }
     inline int					getChanNum()					      { return _channel_num; }
     inline int					getChanBytes()					    { return CHANNEL_SAMPLE_BYTES; }
     inline int					getReadSamplesRemain()			{ return _read_remain_smp; }
@@ -154,9 +183,20 @@ class  I2S_Audio {
   protected:
 
 #ifdef USE_V3
-    i2s_chan_handle_t tx_handle;
-    i2s_chan_handle_t rx_handle;
+    i2s_chan_handle_t tx_handle                                   = nullptr;
+    i2s_chan_handle_t rx_handle                                   = nullptr;
+#endif
+#ifdef I2S_ZERO_COPY_OUT
+    static bool IRAM_ATTR       onTxSent(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+    static bool IRAM_ATTR       onRxRecv(i2s_chan_handle_t handle, i2s_event_data_t* event, void* user_ctx);
+    QueueHandle_t               _tx_free                          = nullptr; // the one DMA buffer free to fill, newest wins
+    QueueHandle_t               _rx_full                          = nullptr; // the last DMA buffer filled, newest wins
+    volatile bool               _tx_started                       = false;
+    volatile bool               _rx_started                       = false;
 #endif
+    bool                        _zero_copy                        = false;
+    volatile uint32_t           _underruns                        = 0;
+    volatile uint32_t           _overruns                         = 0;
 
     BUF_TYPE*                   allocateBuffer(const char* name);
     size_t                      _buffer_size                      = AUDIO_CHANNEL_NUM * DMA_BUFFER_LEN * sizeof(BUF_TYPE);
@@ -165,8 +205,8 @@ class  I2S_Audio {
     BUF_TYPE*                   _input_buf                        = nullptr;
     BUF_TYPE*                   _output_buf                       = nullptr;
     uint32_t                    _sample_rate                      = SAMPLE_RATE;
-    const int32_t               _buffer_len                       = DMA_BUFFER_LEN;
-    const int32_t               _buffer_num                       = DMA_BUFFER_NUM;
+    int32_t                     _buffer_len                       = DMA_BUFFER_LEN;
+    int32_t                     _buffer_num                       = DMA_BUFFER_NUM;
     const int32_t               _channel_num                      = AUDIO_CHANNEL_NUM;
     int32_t                     _read_remain_smp                  = 0;
     int32_t                     _write_remain_smp                 = 0;
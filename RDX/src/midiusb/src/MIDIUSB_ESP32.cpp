@@ -105,18 +105,63 @@ MIDIUSB::MIDIUSB() {
 MIDIUSB::~MIDIUSB(){};
 
 void MIDIUSB::begin() {
+    if (!lock_) lock_ = xSemaphoreCreateMutex();
     USB.begin();
 }
 
+// TinyUSB calls this from its task when an OUT transfer has landed in the FIFO
+extern "C" void tud_midi_rx_cb(uint8_t itf) {
+    (void)itf;
+    MidiUSB.onRx();
+}
+
+void MIDIUSB::onRx() {
+    pump();
+    if (rxTask_) xTaskNotifyGive(rxTask_);
+}
+
+// FIFO -> ring, in order; when the ring is full the rest stays in the FIFO
+// (the host is NAKed meanwhile) and the reader pumps it once it has room
+void MIDIUSB::pump() {
+    if (!lock_) return;
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    const uint32_t now = micros();
+    uint32_t head = head_.load(std::memory_order_relaxed);
+    uint8_t packet[4];
+    while (head - tail_.load(std::memory_order_acquire) < RX_RING && tud_midi_packet_read(packet)) {
+        RxEvent& e = ring_[head & (RX_RING - 1)];
+        memcpy(&e.packet, packet, 4);
+        e.us = now;
+        head_.store(++head, std::memory_order_release);
+    }
+    const bool stalled = tud_midi_available() > 0;
+    if (stalled && !stalled_) stalls_++;
+    stalled_ = stalled;
+    xSemaphoreGive(lock_);
+}
+
+bool MIDIUSB::read(midiEventPacket_t& packet, uint32_t& arrivalUs) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail == head_.load(std::memory_order_acquire)) {
+        if (!stalled_) return false;
+        pump();
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+    }
+    const RxEvent& e = ring_[tail & (RX_RING - 1)];
+    packet = e.packet;
+    arrivalUs = lastUs_ = e.us;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
 midiEventPacket_t MIDIUSB::read() {
     // The MIDI interface always creates input and output port/jack descriptors
     // regardless of these being used or not. Therefore incoming traffic should
-    // be read (possibly just discarded) to avoid the sender blocking in IO
-    uint8_t packet[4] = {0};
+    // be read (possibly just discarded) to avoid the sender blocking in IO:
+    // the rx callback keeps draining the endpoint into the ring
     midiEventPacket_t data = {0, 0, 0, 0};
-    if (tud_midi_packet_read(packet)) {
-        memcpy(&data, packet, 4);
-    }
+    uint32_t us;
+    read(data, us);
     return data;
 }
 void MIDIUSB::flush(void) {}
@@ -124,4 +169,18 @@ void MIDIUSB::sendMIDI(midiEventPacket_t event) {
     tud_midi_packet_write((uint8_t *)&event);
 }
 
+uint32_t MIDIUSB::write(const uint8_t* data, uint32_t len) {
+    uint32_t done = 0;
+    uint32_t waited = 0;
+    while (done < len && tud_midi_mounted()) {
+        const uint32_t n = tud_midi_stream_write(0, data + done, len - done);
+        done += n;
+        if (done == len) break;
+        if (n) waited = 0;
+        else if (++waited > TX_TIMEOUT_MS) break;   // the host stopped reading
+        vTaskDelay(1);
+    }
+    return done;
+}
+
 #endif /* CONFIG_TINYUSB_MIDI_ENABLED */
@@ -5,6 +5,7 @@
 
 #include <stdint.h>
 #include <inttypes.h>
+#include <atomic>
 #include "esp_event.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
@@ -48,6 +49,41 @@ class MIDIUSB
     void flush(void); 
     void sendMIDI(midiEventPacket_t event); 
 
+    // Transmit raw MIDI bytes (SysEx streams): TinyUSB packs them into packets,
+    // keeping a message's state across calls, and sends a call's packets in
+    // full endpoint transfers instead of one transfer per packet. Waits while
+    // the FIFO is full; gives up after TX_TIMEOUT_MS without progress.
+    uint32_t write(const uint8_t* data, uint32_t len);
+
+    // Receive: TinyUSB's rx callback moves the packets into a ring, stamped
+    // with their arrival (micros), and notifies the reading task, which then
+    // pops them here without polling the endpoint.
+    bool read(midiEventPacket_t& packet, uint32_t& arrivalUs);
+    uint32_t lastArrivalUs() const { return lastUs_; }     // of the last packet read
+    void setRxTask(TaskHandle_t task) { rxTask_ = task; }
+    uint32_t rxStalls() const { return stalls_; }           // times the ring was full
+
+    void onRx();    // TinyUSB task: FIFO -> ring, then the notification
+
+private:
+    static constexpr uint32_t RX_RING = 128;    // packets, power of two
+    static constexpr uint32_t TX_TIMEOUT_MS = 100;
+
+    struct RxEvent {
+        midiEventPacket_t packet;
+        uint32_t us;
+    };
+
+    void pump();
+
+    RxEvent ring_[RX_RING];
+    std::atomic<uint32_t> head_ {0};        // written under lock_ only
+    std::atomic<uint32_t> tail_ {0};        // reading task
+    volatile bool stalled_ = false;         // packets left in TinyUSB's FIFO, ring full
+    uint32_t stalls_ = 0;
+    uint32_t lastUs_ = 0;
+    SemaphoreHandle_t lock_ = nullptr;      // the rx callback and a reader pumping after a stall
+    TaskHandle_t rxTask_ = nullptr;
 };
 
 extern MIDIUSB MidiUSB;
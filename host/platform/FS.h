@@ -0,0 +1,111 @@
+// FS.h
+#pragma once
+
+// =========================================================
+// Host stand-in for the Arduino fs::FS / fs::File API, on
+// top of stdio and POSIX directories. A filesystem is a
+// directory on the host; paths are relative to it.
+// =========================================================
+
+#include <cstdio>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "rdx_host.h"
+
+namespace fs {
+
+class File {
+public:
+    File() = default;
+
+    explicit operator bool() const { return h_ && (h_->f || h_->dir); }
+
+    size_t read(uint8_t* buf, size_t n)         { return h_ && h_->f ? fread(buf, 1, n, h_->f) : 0; }
+    int    read()                               { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+    size_t write(const uint8_t* buf, size_t n)  { return h_ && h_->f ? fwrite(buf, 1, n, h_->f) : 0; }
+    size_t write(uint8_t c)                     { return write(&c, 1); }
+    bool   seek(uint32_t pos)                   { return h_ && h_->f && fseek(h_->f, pos, SEEK_SET) == 0; }
+    size_t position() const                     { return h_ && h_->f ? ftell(h_->f) : 0; }
+    size_t size() const {
+        struct stat st;
+        return h_ && stat(h_->path.c_str(), &st) == 0 ? st.st_size : 0;
+    }
+    int    available()                          { return (int)(size() - position()); }
+    void   flush()                              { if (h_ && h_->f) fflush(h_->f); }
+    bool   isDirectory() const                  { return h_ && h_->dir; }
+    const char* name() const {
+        if (!h_) return "";
+        const size_t slash = h_->path.find_last_of('/');
+        return h_->path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+    }
+    const char* path() const                    { return h_ ? h_->path.c_str() : ""; }
+    void   close()                              { h_.reset(); }
+
+    File openNextFile(const char* mode = "r") {
+        if (!isDirectory()) return File();
+        while (dirent* e = readdir(h_->dir)) {
+            if (!strcmp(e->d_name, ".") || !strcmp(e->d_name, "..")) continue;
+            return open(h_->path + "/" + e->d_name, mode);
+        }
+        return File();
+    }
+
+    // host path -> handle; directories are opened for listing
+    static File open(const std::string& hostPath, const char* mode) {
+        File file;
+        auto h = std::make_shared<Handle>();
+        h->path = hostPath;
+        struct stat st;
+        if (stat(hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            h->dir = opendir(hostPath.c_str());
+        } else {
+            std::string m = mode;
+            if (m.find('b') == std::string::npos) m += 'b';
+            h->f = fopen(hostPath.c_str(), m.c_str());
+        }
+        if (h->f || h->dir) file.h_ = h;
+        return file;
+    }
+
+private:
+    struct Handle {
+        std::string path;
+        FILE* f = nullptr;
+        DIR* dir = nullptr;
+        ~Handle() {
+            if (f) fclose(f);
+            if (dir) closedir(dir);
+        }
+    };
+    std::shared_ptr<Handle> h_;
+};
+
+class FS {
+public:
+    explicit FS(const char* envVar = nullptr, const char* defaultRoot = ".") {
+        const char* env = envVar ? getenv(envVar) : nullptr;
+        root_ = env ? env : defaultRoot;
+    }
+
+    File open(const char* path, const char* mode = "r") { return File::open(hostPath(path), mode); }
+    File open(const String& path, const char* mode = "r") { return open(path.c_str(), mode); }
+    bool exists(const char* path) {
+        struct stat st;
+        return stat(hostPath(path).c_str(), &st) == 0;
+    }
+
+    void setRoot(const char* root) { root_ = root; }
+    const std::string& root() const { return root_; }
+
+private:
+    std::string root_;
+    std::string hostPath(const char* path) const { return root_ + (path[0] == '/' ? "" : "/") + path; }
+};
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
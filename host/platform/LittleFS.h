@@ -0,0 +1,20 @@
+// LittleFS.h
+#pragma once
+#include "FS.h"
+
+// host: the sketch's data/ directory (what the LittleFS image is built from),
+// or $RDX_LITTLEFS_ROOT
+#ifndef RDX_HOST_DATA_DIR
+#define RDX_HOST_DATA_DIR "data"
+#endif
+
+namespace fs {
+class LittleFSFS : public FS {
+public:
+    LittleFSFS() : FS("RDX_LITTLEFS_ROOT", RDX_HOST_DATA_DIR) {}
+    bool begin(bool formatOnFail = false, const char* basePath = "/littlefs", uint8_t maxOpenFiles = 10, const char* partitionLabel = "spiffs") { return true; }
+    void end() {}
+};
+}
+
+inline fs::LittleFSFS LittleFS;
@@ -0,0 +1,53 @@
+// Preferences.h
+#pragma once
+
+// =========================================================
+// Host stand-in for the ESP32 NVS Preferences: one in-memory
+// store per process, so settings live as long as the run.
+// =========================================================
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        ns_ = name;
+        readOnly_ = readOnly;
+        return true;
+    }
+    void end() {}
+
+    bool clear()                        { if (readOnly_) return false; store()[ns_].clear(); return true; }
+    bool remove(const char* key)        { if (readOnly_) return false; return store()[ns_].erase(key) > 0; }
+    bool isKey(const char* key)         { return store()[ns_].count(key) > 0; }
+
+    size_t  putUChar(const char* key, uint8_t v)                 { return put(key, v, 1); }
+    size_t  putUInt(const char* key, uint32_t v)                 { return put(key, v, 4); }
+    size_t  putInt(const char* key, int32_t v)                   { return put(key, (uint32_t)v, 4); }
+    size_t  putBool(const char* key, bool v)                     { return put(key, v, 1); }
+    uint8_t getUChar(const char* key, uint8_t def = 0)           { return (uint8_t)get(key, def); }
+    uint32_t getUInt(const char* key, uint32_t def = 0)          { return (uint32_t)get(key, def); }
+    int32_t getInt(const char* key, int32_t def = 0)             { return (int32_t)get(key, (uint32_t)def); }
+    bool    getBool(const char* key, bool def = false)           { return get(key, def) != 0; }
+
+private:
+    std::string ns_;
+    bool readOnly_ = false;
+
+    static std::map<std::string, std::map<std::string, uint64_t>>& store() {
+        static std::map<std::string, std::map<std::string, uint64_t>> s;
+        return s;
+    }
+    size_t put(const char* key, uint64_t v, size_t bytes) {
+        if (readOnly_) return 0;
+        store()[ns_][key] = v;
+        return bytes;
+    }
+    uint64_t get(const char* key, uint64_t def) {
+        auto& m = store()[ns_];
+        auto it = m.find(key);
+        return it == m.end() ? def : it->second;
+    }
+};
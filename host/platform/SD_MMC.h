@@ -0,0 +1,17 @@
+// SD_MMC.h
+#pragma once
+#include "FS.h"
+#include "LittleFS.h"
+
+// host: $RDX_SD_ROOT, or the same directory as LittleFS
+namespace fs {
+class SDMMCFS : public FS {
+public:
+    SDMMCFS() : FS("RDX_SD_ROOT", RDX_HOST_DATA_DIR) {}
+    bool begin(const char* mountpoint = "/sdcard", bool mode1bit = false, bool formatOnFail = false, int sdmmcFrequency = 0, uint8_t maxOpenFiles = 5) { return true; }
+    bool setPins(int, int, int, int = -1, int = -1, int = -1) { return true; }
+    void end() {}
+};
+}
+
+inline fs::SDMMCFS SD_MMC;
@@ -0,0 +1,108 @@
+// rdx_host.h
+#pragma once
+
+// =========================================================
+// Host (Linux) side of RDX_Platform.h: the ESP-IDF / Arduino
+// names the engine uses, on top of the C++ standard library.
+// Only what the engine needs; nothing here talks to hardware.
+// =========================================================
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <strings.h>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+
+// ---------------- attributes ----------------
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define EXT_RAM_BSS_ATTR
+#define likely(x)      __builtin_expect(!!(x), 1)
+#define unlikely(x)    __builtin_expect(!!(x), 0)
+
+// ---------------- real-time checks ----------------
+// rdx_rtcheck points rtHook at its checker; the log macros report themselves through it
+// (what the engine can't report, malloc, locks, files, the tool interposes)
+namespace rdx_host {
+    inline void (*rtHook)(const char* call) = nullptr;
+    inline void rtCall(const char* call) { if (rtHook) rtHook(call); }
+}
+
+// ---------------- logging ----------------
+// E/W/I to stderr; D/V compile out, as with the Arduino core's default log level
+#ifndef RDX_HOST_LOG_LEVEL
+#define RDX_HOST_LOG_LEVEL 3    // 1 error, 2 warn, 3 info
+#endif
+#define RDX_HOST_LOG(lvl, ch, tag, fmt, ...) \
+    do { if (RDX_HOST_LOG_LEVEL >= (lvl)) { rdx_host::rtCall("ESP_LOG" ch); fprintf(stderr, ch " (%u) %s: " fmt "\n", (unsigned)rdx_host::millis(), tag, ##__VA_ARGS__); } } while (0)
+#define ESP_LOGE(tag, fmt, ...) RDX_HOST_LOG(1, "E", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) RDX_HOST_LOG(2, "W", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) RDX_HOST_LOG(3, "I", tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) do {} while (0)
+#define ESP_LOGV(tag, fmt, ...) do {} while (0)
+
+// ---------------- heap caps ----------------
+// one flat heap: every capability is plain malloc, so "PSRAM" is as fast as "DRAM"
+#define MALLOC_CAP_EXEC         (1 << 0)
+#define MALLOC_CAP_32BIT        (1 << 1)
+#define MALLOC_CAP_8BIT         (1 << 2)
+#define MALLOC_CAP_DMA          (1 << 3)
+#define MALLOC_CAP_SPIRAM       (1 << 10)
+#define MALLOC_CAP_INTERNAL     (1 << 11)
+#define MALLOC_CAP_DEFAULT      (1 << 12)
+
+inline void*  heap_caps_malloc(size_t size, uint32_t)              { return malloc(size); }
+inline void*  heap_caps_calloc(size_t n, size_t size, uint32_t)    { return calloc(n, size); }
+inline void*  heap_caps_realloc(void* p, size_t size, uint32_t)    { return realloc(p, size); }
+inline void   heap_caps_free(void* p)                              { free(p); }
+inline size_t heap_caps_get_free_size(uint32_t)                    { return 0; }  // unknown on the host
+inline size_t heap_caps_get_largest_free_block(uint32_t)           { return 0; }
+
+// ---------------- Arduino bits ----------------
+#ifndef TWO_PI
+#define TWO_PI 6.283185307179586476925286766559
+#endif
+#ifndef constrain
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#endif
+typedef uint8_t byte;
+
+// the part of Arduino's String the preset code uses
+class String : public std::string {
+public:
+    String() = default;
+    String(const char* s) : std::string(s ? s : "") {}
+    String(const std::string& s) : std::string(s) {}
+    inline bool endsWith(const String& suffix) const {
+        return size() >= suffix.size() && compare(size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+    inline bool startsWith(const String& prefix) const { return compare(0, prefix.size(), prefix) == 0; }
+    inline String operator+(const String& s) const { return String(static_cast<const std::string&>(*this) + s); }
+    inline String operator+(const char* s) const { return String(static_cast<const std::string&>(*this) + s); }
+};
+
+// ---------------- timing / tasks ----------------
+namespace rdx_host {
+    constexpr uint32_t CPU_MHZ = 1000;   // cycles() counts nanoseconds
+
+    inline uint64_t nanos() {
+        static const auto t0 = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count();
+    }
+    inline uint32_t cycles()            { return (uint32_t)nanos(); }
+    inline uint32_t micros()            { return (uint32_t)(nanos() / 1000); }
+    inline uint32_t millis()            { return (uint32_t)(nanos() / 1000000); }
+    inline void     sleepMs(uint32_t n) { std::this_thread::sleep_for(std::chrono::milliseconds(n)); }
+    inline void     yield()             { std::this_thread::yield(); }
+    inline uint32_t random32() {
+        static std::mt19937 gen(0x5EED);    // fixed seed: host runs are reproducible
+        return gen();
+    }
+}
@@ -0,0 +1,22 @@
+// rdx_engine.cpp
+
+// =========================================================
+// The engine is header-only. This unit holds the globals the
+// sketch defines in RDX.ino and pulls every engine header in
+// once, so the library builds (and warns) as a whole.
+// =========================================================
+
+#include "config.h"
+#include "RDX_Platform.h"
+
+int VOICES = MAX_VOICES;
+
+#include "RDX_Synth.h"
+#include "RDX_FX.h"
+#include "RDX_PresetManager.h"
+#include "RDX_SysEx.h"
+#include "RDX_AudioConfig.h"
+#include "RDX_AudioIn.h"
+#include "RDX_Bench.h"
+
+PresetManager pm;
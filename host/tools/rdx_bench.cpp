@@ -0,0 +1,110 @@
+// rdx_bench.cpp
+
+// =========================================================
+// Host runner for the RDX_Bench micro-benchmarks.
+//
+//   rdx_bench [--json | --csv] [-o FILE] [--rate HZ] [--block N]
+//             [--blocks N] [--filter TEXT] [--compare OLD.csv]
+//
+// --compare reads an earlier --csv run (host or a device
+// serial capture) and prints old/new cycles per block with
+// the change, for checking one firmware version against
+// another. ns/sample on the host counts nanoseconds of this
+// machine; cycles are nanoseconds too (RDX_Platform on the
+// host runs a 1000 MHz "clock").
+// =========================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <map>
+
+#include "config.h"
+#include "RDX_Platform.h"
+#include "RDX_Synth.h"
+#include "RDX_Bench.h"
+
+static FILE* out = stdout;
+static void toFile(const char* line) { fprintf(out, "%s\n", line); }
+
+static int usage() {
+    fprintf(stderr,
+        "usage: rdx_bench [--json | --csv] [-o FILE] [--rate HZ] [--block N] [--blocks N]\n"
+        "                 [--filter TEXT] [--compare OLD.csv]\n");
+    return 2;
+}
+
+// name -> cycles per block, from a CSV report
+static bool readCsv(const char* path, std::map<std::string, uint32_t>& rows) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char* comma = strchr(line, ',');
+        if (line[0] == '#' || !comma) continue;
+        *comma = 0;
+        char* end = nullptr;
+        const unsigned long c = strtoul(comma + 1, &end, 10);
+        if (end != comma + 1) rows[line] = (uint32_t)c;
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    RDX_Bench::Format fmt = RDX_Bench::TEXT;
+    const char* outPath = nullptr;
+    const char* filter = nullptr;
+    const char* compare = nullptr;
+    uint32_t rate = SAMPLE_RATE, block = DMA_BUFFER_LEN, blocks = 1024;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool more = i + 1 < argc;
+        if (!strcmp(a, "--json"))                  fmt = RDX_Bench::JSON;
+        else if (!strcmp(a, "--csv"))              fmt = RDX_Bench::CSV;
+        else if (!strcmp(a, "-o") && more)         outPath = argv[++i];
+        else if (!strcmp(a, "--rate") && more)     rate = atoi(argv[++i]);
+        else if (!strcmp(a, "--block") && more)    block = atoi(argv[++i]);
+        else if (!strcmp(a, "--blocks") && more)   blocks = atoi(argv[++i]);
+        else if (!strcmp(a, "--filter") && more)   filter = argv[++i];
+        else if (!strcmp(a, "--compare") && more)  compare = argv[++i];
+        else                                       return usage();
+    }
+    if (rate < 8000 || rate > 192000) return usage();
+
+    std::map<std::string, uint32_t> old;
+    if (compare && !readCsv(compare, old)) {
+        fprintf(stderr, "can't read %s\n", compare);
+        return 1;
+    }
+
+    setEngineSampleRate(rate);
+    static RDX_Synth synth;     // only for its built-in patch
+    static RDX_Bench bench(rate, block, blocks);
+    bench.run(synth.DigiChordPatch(), filter);
+
+    if (outPath && !(out = fopen(outPath, "w"))) {
+        fprintf(stderr, "can't write %s\n", outPath);
+        return 1;
+    }
+    bench.report(toFile, fmt);
+    if (out != stdout) fclose(out);
+    fflush(stdout);
+    RDX_Log::get().drain(UINT32_MAX);   // effect set-up lines, after the report (stderr)
+
+    if (compare) {
+        printf("%-24s %12s %12s %8s\n", "benchmark", "old", "new", "change");
+        for (int i = 0; i < bench.count(); ++i) {
+            const RDX_Bench::Result& r = bench.result(i);
+            auto it = old.find(r.name);
+            if (it == old.end() || !it->second) {
+                printf("%-24s %12s %12u %8s\n", r.name, "-", r.cycles, "new");
+                continue;
+            }
+            printf("%-24s %12u %12u %+7.1f%%\n", r.name, it->second, r.cycles, 100.0 * ((double)r.cycles / it->second - 1.0));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,337 @@
+// rdx_golden.cpp
+
+// =========================================================
+// Golden-render regression harness: renders every factory
+// voice and every effect type with a fixed note script and
+// fixed random seeds, and checks a later build against those
+// references, with the cost of each render beside the diff.
+//
+//   rdx_golden record  DIR [--patches PATH] [--rate HZ] [--block N]
+//   rdx_golden compare DIR [--patches PATH] [--exact] [--max-abs E]
+//                          [--max-lsd DB] [--filter TEXT]
+//
+// record writes DIR/<case>.wav (stereo float32, listenable)
+// and DIR/golden.csv (rate, block, per case frames and cost).
+// compare renders the same cases with the same settings and
+// reports per case:
+//   max_abs   largest sample difference
+//   lsd_db    log-spectral distance, 512-point Hann frames of
+//             the L+R mix, bins above -100 dBFS, mean over frames
+//   synth/fx  cycles per block (median), reference -> now
+// A case fails when it breaks a given tolerance: --exact
+// (every bit), --max-abs, --max-lsd. Default: --max-abs 1e-4
+// and --max-lsd 0.5. Exit status 1 on any failure.
+//
+// Cases: patch.<file> for each .syx in --patches (default
+// data/patches) with its own effects; fx.<type> for each
+// Reface effect on the DigiChord voice. Convolution is left
+// out: its IR comes from the filesystem and the length it
+// runs is sized by a timing measurement.
+// =========================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+#include <sys/stat.h>
+
+#include "rdx_offline.h"
+#include "fx_fft.h"
+
+using namespace rdx_offline;
+
+static constexpr uint32_t SEED = 0x00C0FFEE;
+static constexpr double   LENGTH_S = 2.5;
+
+struct Case {
+    std::string name;
+    RDX_Patch   patch;
+};
+
+struct Render {
+    std::vector<float> L, R;
+    double synthCycles = 0.0, fxCycles = 0.0;
+};
+
+// the script every case plays: notes, a chord, mod wheel (LFO), pitch bend, release
+static std::vector<MidiEvent> script() {
+    auto ev = [](double t, uint8_t st, uint8_t d1, uint8_t d2) {
+        MidiEvent e;
+        e.time = t; e.status = st; e.d1 = d1; e.d2 = d2;
+        return e;
+    };
+    return {
+        ev(0.00, 0x90, 60, 100),
+        ev(0.25, 0x90, 64, 80),
+        ev(0.50, 0x90, 67, 110),
+        ev(0.50, 0x90, 48, 90),
+        ev(0.90, 0xB0, 1, 64),
+        ev(1.00, 0xE0, 0x00, 0x50),     // +2048
+        ev(1.25, 0x80, 60, 0),
+        ev(1.25, 0x80, 64, 0),
+        ev(1.25, 0x80, 67, 0),
+        ev(1.25, 0x80, 48, 0),
+        ev(1.50, 0xE0, 0x00, 0x40),     // centre
+        ev(1.50, 0xB0, 1, 0),
+    };
+}
+
+static double median(std::vector<uint32_t>& v) {
+    if (v.empty()) return 0.0;
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+// a fresh engine from a reset state each time, so cases don't depend on their order
+static Render render(const Case& c, uint32_t rate, uint32_t block) {
+    resetEngineState(SEED);
+    std::unique_ptr<OfflineEngine> eng(new OfflineEngine());
+    eng->init(rate, block, MAX_VOICES);
+    eng->setPatch(c.patch);
+    block = eng->blockLen();
+
+    const std::vector<MidiEvent> events = script();
+    const uint32_t blocks = (uint32_t)(LENGTH_S * rate / block);
+    const double blockSec = (double)block / rate;
+    Render r;
+    r.L.resize((size_t)blocks * block);
+    r.R.resize((size_t)blocks * block);
+    std::vector<uint32_t> synth, fx;
+    size_t next = 0;
+    for (uint32_t b = 0; b < blocks; ++b) {
+        while (next < events.size() && events[next].time < (b + 1) * blockSec) eng->dispatch(events[next++]);
+        eng->render(&r.L[(size_t)b * block], &r.R[(size_t)b * block]);
+        synth.push_back(eng->synthCycles());
+        fx.push_back(eng->fxCycles());
+    }
+    r.synthCycles = median(synth);
+    r.fxCycles = median(fx);
+    return r;
+}
+
+static bool buildCases(const char* patchDir, const char* filter, std::vector<Case>& cases) {
+    std::vector<NamedPatch> patches;
+    std::string err;
+    if (!loadPatches(patchDir, patches, err)) {
+        fprintf(stderr, "%s\n", err.c_str());
+        return false;
+    }
+    for (const auto& np : patches) {
+        std::string stem = np.source.substr(np.source.rfind('/') + 1);
+        stem = stem.substr(0, stem.rfind('.'));
+        cases.push_back({"patch." + stem, np.patch});
+    }
+
+    static const char* const FX_NAMES[] = { "thru", "distortion", "touchwah", "chorus", "flanger", "phaser", "delay", "reverb" };
+    static RDX_Synth builtIn;   // only for its built-in patch
+    RDX_Patch base = builtIn.DigiChordPatch();
+    for (int id = FX_DISTORTION; id <= FX_REVERB; ++id) {
+        Case c {std::string("fx.") + FX_NAMES[id], base};
+        c.patch.common.effects[0][0] = id;
+        c.patch.common.effects[0][1] = 96;
+        c.patch.common.effects[0][2] = 64;
+        c.patch.common.effects[1][0] = FX_THRU;
+        cases.push_back(c);
+    }
+
+    if (filter) {
+        cases.erase(std::remove_if(cases.begin(), cases.end(),
+                    [&](const Case& c) { return c.name.find(filter) == std::string::npos; }), cases.end());
+    }
+    return !cases.empty();
+}
+
+// the stereo float32 WAV WavWriter writes
+static bool readWav(const std::string& path, std::vector<float>& L, std::vector<float>& R) {
+    std::vector<uint8_t> b;
+    if (!readFile(path.c_str(), b) || b.size() < 44 || memcmp(b.data(), "RIFF", 4) || b[20] != 3 || b[22] != 2) return false;
+    const size_t frames = (b.size() - 44) / 8;
+    L.resize(frames);
+    R.resize(frames);
+    const float* s = (const float*)(b.data() + 44);
+    for (size_t i = 0; i < frames; ++i) { L[i] = s[2 * i]; R[i] = s[2 * i + 1]; }
+    return true;
+}
+
+// mean log-spectral distance in dB between two mono signals
+static double spectralDistance(const std::vector<float>& a, const std::vector<float>& b) {
+    constexpr uint32_t N = FFT_MAX_N, HOP = N / 2;
+    static Fft fft;
+    if (fft.size() != N) fft.init(N);
+    static float win[N];
+    for (uint32_t i = 0; i < N; ++i) win[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / N);
+    const double floorAmp = N / 4.0 * 1e-5;     // -100 dBFS for a full-scale sine under a Hann window
+    const double eps = floorAmp * floorAmp;
+
+    static float x[2 * N], y[2 * N];
+    double sum = 0.0;
+    int frames = 0;
+    const size_t n = std::min(a.size(), b.size());
+    for (size_t start = 0; start + N <= n; start += HOP) {
+        for (uint32_t i = 0; i < N; ++i) {
+            x[2 * i] = a[start + i] * win[i]; x[2 * i + 1] = 0.f;
+            y[2 * i] = b[start + i] * win[i]; y[2 * i + 1] = 0.f;
+        }
+        fft.forward(x);
+        fft.forward(y);
+        double d2 = 0.0;
+        int bins = 0;
+        for (uint32_t k = 0; k <= N / 2; ++k) {
+            const double px = (double)x[2 * k] * x[2 * k] + (double)x[2 * k + 1] * x[2 * k + 1];
+            const double py = (double)y[2 * k] * y[2 * k] + (double)y[2 * k + 1] * y[2 * k + 1];
+            if (std::max(px, py) < eps) continue;
+            const double d = 10.0 * log10((px + eps) / (py + eps));
+            d2 += d * d;
+            bins++;
+        }
+        if (!bins) continue;
+        sum += sqrt(d2 / bins);
+        frames++;
+    }
+    return frames ? sum / frames : 0.0;
+}
+
+static std::vector<float> mix(const std::vector<float>& L, const std::vector<float>& R) {
+    std::vector<float> m(L.size());
+    for (size_t i = 0; i < L.size(); ++i) m[i] = 0.5f * (L[i] + R[i]);
+    return m;
+}
+
+static int usage() {
+    fprintf(stderr,
+        "usage: rdx_golden record  DIR [--patches PATH] [--rate HZ] [--block N]\n"
+        "       rdx_golden compare DIR [--patches PATH] [--exact] [--max-abs E] [--max-lsd DB] [--filter TEXT]\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+    const std::string mode = argv[1];
+    const std::string dir = argv[2];
+    std::string patchDir = std::string(RDX_HOST_DATA_DIR) + "/patches";
+    const char* filter = nullptr;
+    uint32_t rate = SAMPLE_RATE, block = DMA_BUFFER_LEN;
+    bool exact = false;
+    double maxAbs = -1.0, maxLsd = -1.0;     // < 0: not checked
+
+    for (int i = 3; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool more = i + 1 < argc;
+        if (!strcmp(a, "--patches") && more)       patchDir = argv[++i];
+        else if (!strcmp(a, "--rate") && more)     rate = atoi(argv[++i]);
+        else if (!strcmp(a, "--block") && more)    block = atoi(argv[++i]);
+        else if (!strcmp(a, "--filter") && more)   filter = argv[++i];
+        else if (!strcmp(a, "--exact"))            exact = true;
+        else if (!strcmp(a, "--max-abs") && more)  maxAbs = atof(argv[++i]);
+        else if (!strcmp(a, "--max-lsd") && more)  maxLsd = atof(argv[++i]);
+        else                                       return usage();
+    }
+    if (!exact && maxAbs < 0 && maxLsd < 0) {
+        maxAbs = 1e-4;
+        maxLsd = 0.5;
+    }
+
+    std::vector<Case> cases;
+    if (!buildCases(patchDir.c_str(), filter, cases)) return 1;
+    const std::string manifest = dir + "/golden.csv";
+
+    if (mode == "record") {
+        // mkdir -p: every level of DIR
+        for (size_t p = dir.find('/', 1); ; p = dir.find('/', p + 1)) {
+            const std::string part = dir.substr(0, p);
+            if (!part.empty() && mkdir(part.c_str(), 0755) && errno != EEXIST) {
+                fprintf(stderr, "can't create %s: %s\n", part.c_str(), strerror(errno));
+                return 1;
+            }
+            if (p == std::string::npos) break;
+        }
+        FILE* f = fopen(manifest.c_str(), "w");
+        if (!f) {
+            fprintf(stderr, "can't write %s\n", manifest.c_str());
+            return 1;
+        }
+        fprintf(f, "# rdx_golden,%u,%u,%u\n", rate, block, SEED);
+        fprintf(f, "name,frames,synth_cyc,fx_cyc\n");
+        for (const Case& c : cases) {
+            const Render r = render(c, rate, block);
+            WavWriter wav;
+            if (!wav.open((dir + "/" + c.name + ".wav").c_str(), rate, true)) {
+                fprintf(stderr, "can't write %s/%s.wav\n", dir.c_str(), c.name.c_str());
+                return 1;
+            }
+            wav.writeFloat(r.L.data(), r.R.data(), r.L.size());
+            fprintf(f, "%s,%zu,%.0f,%.0f\n", c.name.c_str(), r.L.size(), r.synthCycles, r.fxCycles);
+            printf("%-28s %zu frames, synth %.0f fx %.0f cycles/block\n", c.name.c_str(), r.L.size(), r.synthCycles, r.fxCycles);
+        }
+        fclose(f);
+        printf("%zu references in %s\n", cases.size(), dir.c_str());
+        return 0;
+    }
+    if (mode != "compare") return usage();
+
+    // settings and costs of the reference run
+    struct Ref { double synth, fx; };
+    std::map<std::string, Ref> refs;
+    FILE* f = fopen(manifest.c_str(), "r");
+    if (!f) {
+        fprintf(stderr, "no references: %s\n", manifest.c_str());
+        return 1;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned r, b, s;
+        if (sscanf(line, "# rdx_golden,%u,%u,%u", &r, &b, &s) == 3) { rate = r; block = b; continue; }
+        char name[128];
+        unsigned long frames;
+        double sc, fc;
+        if (sscanf(line, "%127[^,],%lu,%lf,%lf", name, &frames, &sc, &fc) == 4) refs[name] = {sc, fc};
+    }
+    fclose(f);
+
+    printf("%u Hz, %u-sample blocks; tolerance: %s", rate, block, exact ? "bit-exact" : "");
+    if (maxAbs >= 0) printf(" max abs %g", maxAbs);
+    if (maxLsd >= 0) printf(" LSD %.2f dB", maxLsd);
+    printf("\n%-28s %-6s %10s %8s %17s %17s\n", "case", "result", "max_abs", "lsd_db", "synth cyc", "fx cyc");
+
+    int failed = 0;
+    for (const Case& c : cases) {
+        std::vector<float> refL, refR;
+        auto it = refs.find(c.name);
+        if (it == refs.end() || !readWav(dir + "/" + c.name + ".wav", refL, refR)) {
+            printf("%-28s %-6s (no reference)\n", c.name.c_str(), "MISS");
+            failed++;
+            continue;
+        }
+        const Render r = render(c, rate, block);
+        const bool sameLen = refL.size() == r.L.size();
+        const bool bitExact = sameLen && !memcmp(refL.data(), r.L.data(), r.L.size() * sizeof(float))
+                                      && !memcmp(refR.data(), r.R.data(), r.R.size() * sizeof(float));
+        double worst = sameLen ? 0.0 : INFINITY;
+        const size_t n = std::min(refL.size(), r.L.size());
+        for (size_t i = 0; i < n; ++i) {
+            worst = std::max(worst, (double)fabsf(refL[i] - r.L[i]));
+            worst = std::max(worst, (double)fabsf(refR[i] - r.R[i]));
+        }
+        const double lsd = bitExact ? 0.0 : spectralDistance(mix(refL, refR), mix(r.L, r.R));
+
+        bool ok = true;
+        if (exact && !bitExact) ok = false;
+        if (maxAbs >= 0 && worst > maxAbs) ok = false;
+        if (maxLsd >= 0 && lsd > maxLsd) ok = false;
+        failed += !ok;
+
+        char synth[32], fx[32];
+        snprintf(synth, sizeof(synth), "%.0f->%.0f", it->second.synth, r.synthCycles);
+        snprintf(fx, sizeof(fx), "%.0f->%.0f", it->second.fx, r.fxCycles);
+        printf("%-28s %-6s %10.3g %8.3f %17s %17s\n", c.name.c_str(), !ok ? "FAIL" : bitExact ? "EXACT" : "ok",
+               worst, lsd, synth, fx);
+    }
+    printf("%zu cases, %d failed\n", cases.size(), failed);
+    return failed ? 1 : 0;
+}
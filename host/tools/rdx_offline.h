@@ -0,0 +1,461 @@
+// rdx_offline.h
+#pragma once
+
+// =========================================================
+// Offline rendering on the host: the pieces the host tools
+// share (rdx_render and the benchmark/profiling tools).
+//
+//   loadSmf()       Standard MIDI File, format 0/1, tempo map
+//                   applied: events in seconds, time-ordered
+//   loadPatch()     one .syx voice, voice N of a bulk dump
+//                   ("dump.syx:N") or file N of a directory
+//   WavWriter       16-bit PCM or 32-bit float WAV
+//   OfflineEngine   RDX_Synth + FXHost run the way the audio
+//                   and MIDI tasks run them on the device, one
+//                   block at a time, events at block starts;
+//                   optionally with an audio input (RDX_AudioIn)
+//                   as AUDIO_INPUT feeds it on the device
+//
+// Files are plain stdio here, not fs::FS: these tools only
+// exist on the host.
+// =========================================================
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <dirent.h>
+
+#include "config.h"
+#include "RDX_Platform.h"
+#include "RDX_Synth.h"
+#include "RDX_FX.h"
+#include "RDX_SysEx.h"
+#include "RDX_AudioIn.h"
+
+namespace rdx_offline {
+
+inline bool readFile(const char* path, std::vector<uint8_t>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    const long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(len > 0 ? len : 0);
+    const bool ok = len >= 0 && fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+// =========================================================
+// Standard MIDI File
+// =========================================================
+struct MidiEvent {
+    double  time = 0.0;             // seconds from the start
+    uint8_t status = 0;             // channel message status, or 0xF0 for SysEx
+    uint8_t d1 = 0, d2 = 0;
+    std::vector<uint8_t> sysex;     // F0 ... F7, complete
+};
+
+// Reads format 0 and 1 files (format 2 tracks are played together too).
+// Meta events other than tempo are dropped; SysEx escapes (F7) are skipped.
+inline bool loadSmf(const char* path, std::vector<MidiEvent>& events, std::string& err) {
+    std::vector<uint8_t> b;
+    if (!readFile(path, b)) { err = "can't read file"; return false; }
+    auto be32 = [&](size_t p) { return (uint32_t)b[p] << 24 | (uint32_t)b[p + 1] << 16 | (uint32_t)b[p + 2] << 8 | b[p + 3]; };
+    auto be16 = [&](size_t p) { return (uint16_t)(b[p] << 8 | b[p + 1]); };
+    if (b.size() < 14 || memcmp(b.data(), "MThd", 4) || be32(4) < 6) { err = "not a MIDI file"; return false; }
+
+    const uint16_t tracks = be16(10);
+    const uint16_t division = be16(12);
+    struct Raw { uint64_t tick; uint32_t order; MidiEvent ev; uint32_t tempo; };  // tempo != 0: tempo change
+    std::vector<Raw> raw;
+    uint32_t order = 0;
+
+    size_t p = 8 + be32(4);
+    for (uint16_t t = 0; t < tracks && p + 8 <= b.size(); ) {
+        const uint32_t len = be32(p + 4);
+        const bool isTrack = !memcmp(&b[p], "MTrk", 4);
+        const size_t end = std::min(b.size(), p + 8 + (size_t)len);
+        size_t q = p + 8;
+        p = p + 8 + len;
+        if (!isTrack) continue;
+        ++t;
+
+        auto vlq = [&](size_t& i) {
+            uint32_t v = 0;
+            for (int n = 0; n < 4 && i < end; ++n) {
+                const uint8_t c = b[i++];
+                v = (v << 7) | (c & 0x7F);
+                if (!(c & 0x80)) break;
+            }
+            return v;
+        };
+
+        uint64_t tick = 0;
+        uint8_t running = 0;
+        while (q < end) {
+            tick += vlq(q);
+            if (q >= end) break;
+            uint8_t st = b[q];
+            if (st & 0x80) q++;
+            else if (running) st = running;
+            else { err = "data byte without status"; return false; }
+
+            if (st == 0xFF) {                               // meta
+                if (q >= end) break;
+                const uint8_t type = b[q++];
+                const uint32_t n = vlq(q);
+                if (type == 0x51 && n == 3 && q + 3 <= end) {
+                    raw.push_back({tick, order++, {}, (uint32_t)b[q] << 16 | (uint32_t)b[q + 1] << 8 | b[q + 2]});
+                }
+                q += n;
+                if (type == 0x2F) break;                    // end of track
+            } else if (st == 0xF0 || st == 0xF7) {          // SysEx, escape
+                const uint32_t n = vlq(q);
+                if (st == 0xF0 && q + n <= end) {
+                    Raw r {tick, order++, {}, 0};
+                    r.ev.status = 0xF0;
+                    r.ev.sysex.push_back(0xF0);
+                    r.ev.sysex.insert(r.ev.sysex.end(), b.begin() + q, b.begin() + q + n);
+                    if (r.ev.sysex.back() != 0xF7) r.ev.sysex.push_back(0xF7);
+                    raw.push_back(std::move(r));
+                }
+                q += n;
+                running = 0;
+            } else {                                        // channel message
+                running = st;
+                const uint8_t type = st & 0xF0;
+                const int n = (type == 0xC0 || type == 0xD0) ? 1 : 2;
+                if (q + n > end) break;
+                Raw r {tick, order++, {}, 0};
+                r.ev.status = st;
+                r.ev.d1 = b[q] & 0x7F;
+                r.ev.d2 = n > 1 ? b[q + 1] & 0x7F : 0;
+                q += n;
+                raw.push_back(std::move(r));
+            }
+        }
+    }
+
+    // merge the tracks; equal ticks keep file order (tempo before notes of the same tick in format 1)
+    std::stable_sort(raw.begin(), raw.end(), [](const Raw& a, const Raw& c) { return a.tick < c.tick; });
+
+    events.clear();
+    double secPerTick, time = 0.0;
+    const bool smpte = division & 0x8000;
+    if (smpte) {
+        const int fps = -(int8_t)(division >> 8);
+        secPerTick = 1.0 / (fps * (division & 0xFF));
+    } else {
+        if (!division) { err = "zero division"; return false; }
+        secPerTick = 0.5 / division;                        // 120 bpm until the first tempo event
+    }
+    uint64_t lastTick = 0;
+    for (auto& r : raw) {
+        time += (r.tick - lastTick) * secPerTick;
+        lastTick = r.tick;
+        if (r.tempo) {
+            if (!smpte) secPerTick = r.tempo * 1e-6 / division;
+            continue;
+        }
+        r.ev.time = time;
+        events.push_back(std::move(r.ev));
+    }
+    return true;
+}
+
+// =========================================================
+// Patches
+// =========================================================
+
+// a reface DX voice starts at its common block (cmd 0x2A, address 0x30):
+// splits a bulk dump into voices, each running up to the next common block
+inline void splitVoices(const std::vector<uint8_t>& syx, std::vector<std::pair<size_t, size_t>>& voices) {
+    voices.clear();
+    for (size_t i = 0; i + 8 < syx.size(); ++i) {
+        if (syx[i] == 0xF0 && syx[i + 1] == 0x43 && syx[i + 6] == 0x2A && syx[i + 8] == 0x30) {
+            if (!voices.empty()) voices.back().second = i;
+            voices.push_back({i, syx.size()});
+        }
+    }
+}
+
+inline std::string patchName(const RDX_Patch& p) {
+    std::string s((const char*)p.common.voiceName, strnlen((const char*)p.common.voiceName, 10));
+    while (!s.empty() && s.back() == ' ') s.pop_back();
+    return s;
+}
+
+// spec: "voice.syx", "dump.syx:N" (voice N, from 0) or "dir:N" (Nth .syx file by name)
+inline bool loadPatch(const std::string& spec, RDX_Patch& patch, std::string& err) {
+    std::string path = spec;
+    long index = 0;
+    const size_t colon = spec.rfind(':');
+    if (colon != std::string::npos && colon + 1 < spec.size() && spec.find_first_not_of("0123456789", colon + 1) == std::string::npos) {
+        path = spec.substr(0, colon);
+        index = atol(spec.c_str() + colon + 1);
+    }
+
+    if (DIR* d = opendir(path.c_str())) {
+        std::vector<std::string> files;
+        while (dirent* e = readdir(d)) {
+            const std::string n = e->d_name;
+            if (n.size() > 4 && !strcasecmp(n.c_str() + n.size() - 4, ".syx")) files.push_back(n);
+        }
+        closedir(d);
+        std::sort(files.begin(), files.end());
+        if (index >= (long)files.size()) { err = "only " + std::to_string(files.size()) + " .syx files"; return false; }
+        path += "/" + files[index];
+        index = 0;
+    }
+
+    std::vector<uint8_t> syx;
+    if (!readFile(path.c_str(), syx)) { err = "can't read " + path; return false; }
+    std::vector<std::pair<size_t, size_t>> voices;
+    splitVoices(syx, voices);
+    if (voices.empty()) { err = path + ": no reface DX voice"; return false; }
+    if (index >= (long)voices.size()) { err = path + ": " + std::to_string(voices.size()) + " voices"; return false; }
+    const auto& v = voices[index];
+    patch = RDX_Patch();
+    if (!syxToPatch(syx.data() + v.first, v.second - v.first, patch)) { err = path + ": bad checksum"; return false; }
+    return true;
+}
+
+struct NamedPatch {
+    std::string source;     // "file.syx" or "dump.syx:N", loadPatch() takes it back
+    RDX_Patch   patch;
+};
+
+// every voice of a .syx file, or of every .syx file in a directory (sorted by name)
+inline bool loadPatches(const std::string& path, std::vector<NamedPatch>& out, std::string& err) {
+    std::vector<std::string> files;
+    if (DIR* d = opendir(path.c_str())) {
+        while (dirent* e = readdir(d)) {
+            const std::string n = e->d_name;
+            if (n.size() > 4 && !strcasecmp(n.c_str() + n.size() - 4, ".syx")) files.push_back(path + "/" + n);
+        }
+        closedir(d);
+        std::sort(files.begin(), files.end());
+    } else {
+        files.push_back(path);
+    }
+    for (const auto& file : files) {
+        std::vector<uint8_t> syx;
+        if (!readFile(file.c_str(), syx)) { err = "can't read " + file; return false; }
+        std::vector<std::pair<size_t, size_t>> voices;
+        splitVoices(syx, voices);
+        for (size_t i = 0; i < voices.size(); ++i) {
+            NamedPatch p {};
+            p.source = voices.size() > 1 ? file + ":" + std::to_string(i) : file;
+            if (!syxToPatch(syx.data() + voices[i].first, voices[i].second - voices[i].first, p.patch)) {
+                ESP_LOGW("OFFLINE", "%s: bad checksum, skipped", p.source.c_str());
+                continue;
+            }
+            out.push_back(std::move(p));
+        }
+    }
+    if (out.empty()) err = path + ": no reface DX voice";
+    return !out.empty();
+}
+
+// =========================================================
+// WAV out
+// =========================================================
+class WavWriter {
+public:
+    ~WavWriter() { close(); }
+
+    inline bool open(const char* path, uint32_t sampleRate, bool float32) {
+        close();
+        f_ = fopen(path, "wb");
+        if (!f_) return false;
+        float_ = float32;
+        rate_ = sampleRate;
+        frames_ = 0;
+        header();
+        return true;
+    }
+
+    // interleaved L/R int16, as FXHost::process() writes it
+    inline void writePcm16(const int16_t* pcm, uint32_t frames) {
+        if (!f_ || float_) return;
+        fwrite(pcm, sizeof(int16_t) * 2, frames, f_);
+        frames_ += frames;
+    }
+
+    inline void writeFloat(const float* L, const float* R, uint32_t frames) {
+        if (!f_ || !float_) return;
+        float buf[2 * MAX_BLOCK_LEN];
+        while (frames) {
+            const uint32_t n = std::min<uint32_t>(frames, MAX_BLOCK_LEN);
+            for (uint32_t i = 0; i < n; ++i) { buf[2 * i] = L[i]; buf[2 * i + 1] = R[i]; }
+            fwrite(buf, sizeof(float) * 2, n, f_);
+            frames_ += n; L += n; R += n; frames -= n;
+        }
+    }
+
+    inline void close() {
+        if (!f_) return;
+        fseek(f_, 0, SEEK_SET);
+        header();           // now with the sizes
+        fclose(f_);
+        f_ = nullptr;
+    }
+
+    inline uint64_t frames() const { return frames_; }
+
+private:
+    FILE*    f_ = nullptr;
+    bool     float_ = false;
+    uint32_t rate_ = 0;
+    uint64_t frames_ = 0;
+
+    inline void header() {
+        const uint16_t bits = float_ ? 32 : 16;
+        const uint16_t align = 2 * bits / 8;
+        const uint32_t data = (uint32_t)std::min<uint64_t>(frames_ * align, 0xFFFFFFF0u - 36);
+        uint8_t h[44];
+        auto le32 = [&](int p, uint32_t v) { h[p] = v; h[p + 1] = v >> 8; h[p + 2] = v >> 16; h[p + 3] = v >> 24; };
+        auto le16 = [&](int p, uint16_t v) { h[p] = v; h[p + 1] = v >> 8; };
+        memcpy(h, "RIFF", 4);       le32(4, 36 + data);
+        memcpy(h + 8, "WAVEfmt ", 8); le32(16, 16);
+        le16(20, float_ ? 3 : 1);   le16(22, 2);
+        le32(24, rate_);            le32(28, rate_ * align);
+        le16(32, align);            le16(34, bits);
+        memcpy(h + 36, "data", 4);  le32(40, data);
+        fwrite(h, 1, sizeof(h), f_);
+    }
+};
+
+// =========================================================
+// Engine
+// =========================================================
+
+// the state a render starts from, beyond the synth and FXHost objects: random
+// generators (FX noise, LFO sample & hold) and the MIDI controls. With a fresh
+// OfflineEngine after this, the same script renders the same samples every time.
+inline void resetEngineState(uint32_t seed) {
+    seedRandom(seed);
+    RDX_LFO::seed(seed ^ 0x5A5A5A5A);
+    RDX_State::getState().controls = RDX_Controls();
+}
+
+class OfflineEngine {
+public:
+    // voices: poly voices to run, 0 = let FXHost estimate them from its CPU time as on the device
+    inline void init(uint32_t sampleRate, uint32_t blockLen, int voices) {
+        setEngineSampleRate(sampleRate);    // before anything computes a coefficient
+        blockLen_ = std::max<uint32_t>(MIN_BLOCK_LEN, std::min<uint32_t>(MAX_BLOCK_LEN, blockLen));
+        sampleRate_ = sampleRate;
+        VOICES = voices > 0 ? std::min(voices, MAX_VOICES) : MAX_VOICES;
+        synth.init();
+        fx.init(sampleRate, blockLen_);
+        fx.setFixedVoices(voices);
+#ifdef RDX_PROFILE
+        RDX_Profiler::get().init(sampleRate, blockLen_);
+#endif
+#ifdef RDX_TRACE
+        RDX_Trace::get().init(sampleRate, blockLen_);
+#endif
+        RDX_Meter::get().init(sampleRate, blockLen_);
+    }
+
+    inline void setPatch(const RDX_Patch& patch) {
+        synth.applyPatch(patch);
+        fx.service();       // builds the patch's effects
+        RDX_Log::get().drain();
+    }
+
+    // program/bank changes load from the LittleFS patch folder as on the device; off by default,
+    // so the patch given to the tool stays
+    inline void followProgramChanges(bool on) { programChanges_ = on; }
+
+    // external input, as the audio task takes it: mix adds it to the synth (AUDIO_IN_MIX),
+    // otherwise it runs through the FX chain alone (AUDIO_IN_FX); nullptr: synth only
+    inline void setInput(RDX_AudioIn* in, bool mix) {
+        input_ = in;
+        mixInput_ = mix;
+    }
+
+    // the MIDI task's handlers (RDX_Midi.h), without the GUI and power parts
+    inline void dispatch(const MidiEvent& e) {
+        if (e.status == 0xF0) RDX_TRACE_SYSEX(e.sysex.data(), e.sysex.size());
+        else RDX_TRACE_MIDI(e.status, e.d1, e.d2);
+        switch (e.status & 0xF0) {
+            case 0x90:
+                if (e.d2) { synth.noteOn(e.d1, e.d2); break; }
+                // fall through: velocity 0 is a note-off, as the MIDI library reports it
+            case 0x80: synth.noteOff(e.d1); break;
+            case 0xB0:
+                if (!programChanges_ && (e.d1 == 0 || e.d1 == 32)) break;
+                synth.processCC(e.status & 0x0F, e.d1, e.d2);
+                break;
+            case 0xE0: synth.updatePB(e.status & 0x0F, (e.d1 | e.d2 << 7) - 8192); break;
+            case 0xC0:
+                if (programChanges_) {
+                    synth.programChange(e.status & 0x0F, e.d1);
+                    fx.service();
+                }
+                break;
+            case 0xF0:
+                if (handleSysExMessage(e.sysex.data(), e.sysex.size(), synth.currentPatch())) fx.service();
+                break;
+        }
+    }
+
+    // one block, as the audio task renders it; pcm (interleaved L/R) is optional
+    inline void render(float* L, float* R, int16_t* pcm = nullptr) {
+        RDX_PROF_BLOCK_START();
+        RDX_TRACE_BLOCK_START();
+        const uint32_t t0 = RDX_Platform::cycles();
+        const bool synthOn = !input_ || mixInput_;
+        if (synthOn) synth.renderAudioBlock(L, R, blockLen_);
+        const uint32_t t1 = RDX_Platform::cycles();
+        RDX_TRACE_SYNTH_DONE();
+        if (input_) pcm16ToFloat(input_->acquire(blockLen_), L, R, blockLen_, mixInput_);
+        fx.process(L, R, pcm);
+        RDX_PROF_BLOCK_END();
+        RDX_TRACE_BLOCK_END(synth.activeVoices());
+        RDX_Meter::get().blockDone(L, R, blockLen_);
+        synthCycles_ = t1 - t0;
+        fxCycles_ = RDX_Platform::cycles() - t1;
+        voiceBlocks_ += synth.activeVoices();
+        if (synthOn) steppedBlocks_ += VOICES;
+        // the MIDI task's per-loop work, and the log task's
+        synth.updateCache();
+        fx.service();
+#ifdef RDX_TRACE
+        RDX_Trace::get().keyframe(synth.currentPatch(), RDX_State::getState().controls, synth.activeVoices());
+#endif
+        RDX_Log::get().drain();
+    }
+
+    inline uint32_t blockLen() const { return blockLen_; }
+    inline uint32_t sampleRate() const { return sampleRate_; }
+
+    // cost of the last render(): synth (all VOICES stepped) and FX chain, RDX_Platform cycles
+    inline uint32_t synthCycles() const { return synthCycles_; }
+    inline uint32_t fxCycles() const { return fxCycles_; }
+
+    // seconds of sounding voices, and of voices stepped (the synth runs all VOICES, sounding or not)
+    inline double voiceSeconds() const { return (double)voiceBlocks_ * blockLen_ / sampleRate_; }
+    inline double steppedVoiceSeconds() const { return (double)steppedBlocks_ * blockLen_ / sampleRate_; }
+
+    RDX_Synth synth;
+    FXHost    fx;
+
+private:
+    uint32_t sampleRate_ = SAMPLE_RATE;
+    uint32_t blockLen_ = DMA_BUFFER_LEN;
+    uint64_t voiceBlocks_ = 0;
+    uint64_t steppedBlocks_ = 0;
+    uint32_t synthCycles_ = 0;
+    uint32_t fxCycles_ = 0;
+    bool     programChanges_ = false;
+    RDX_AudioIn* input_ = nullptr;
+    bool     mixInput_ = false;
+};
+
+} // namespace rdx_offline
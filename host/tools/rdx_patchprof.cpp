@@ -0,0 +1,201 @@
+// rdx_patchprof.cpp
+
+// =========================================================
+// Patch corpus profiler: what every voice costs and how long
+// it rings.
+//
+//   rdx_patchprof PATH... [-o costs.csv] [--rate HZ] [--block N] [--hold S]
+//
+// PATH is a .syx voice, a bulk dump (every voice in it) or a
+// directory of .syx files. Each patch plays the same script:
+// C4 alone, then a C3-C4-E4-G4 chord, each held --hold
+// seconds (1 s) and released, the render running on until the
+// output is silent (10 s at most). All MAX_VOICES voices are
+// stepped, as on the device.
+//
+// Per patch:
+//   voice_cyc   synth cycles per voice per block while held
+//               (median block: a busy host only adds outliers)
+//   rel         voice_cyc / the corpus median
+//   fx_cyc      FX chain cycles per block (the patch's FX1/FX2), median
+//   carriers    enabled carriers with an output level
+//   fb_ops      enabled operators with feedback
+//   peak_db     loudest output sample, dBFS (note and chord)
+//   vtail_ms    chord release until no voice is sounding
+//   tail_ms     chord release until the output (FX included)
+//               stays under one 16-bit LSB; -1: not in 10 s
+//
+// -o writes the same as CSV, one line per patch; the rel and
+// tail columns are what polyphony planning on the board can
+// use, cycles are host cycles (nanoseconds).
+// =========================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "rdx_offline.h"
+
+using namespace rdx_offline;
+
+// carrier operators per algorithm, as RDX_Voice::isActive() (and the GUI's UI_Algos.h) see them
+static const bool CARRIERS[12][4] = {
+    {1,0,0,0}, {1,0,0,0}, {1,0,0,0}, {1,0,0,0}, {1,0,0,0}, {1,1,0,0},
+    {1,1,0,0}, {1,0,1,0}, {1,1,1,0}, {1,1,1,0}, {1,1,1,0}, {1,1,1,1}
+};
+
+struct Profile {
+    std::string source, name;
+    int      algorithm = 0, carriers = 0, fbOps = 0;
+    double   voiceCycles = 0.0, fxCycles = 0.0, rel = 0.0;
+    float    peak = 0.f;
+    int      voiceTailMs = -1, tailMs = -1;
+};
+
+static int usage() {
+    fprintf(stderr, "usage: rdx_patchprof PATH... [-o costs.csv] [--rate HZ] [--block N] [--hold S]\n"
+                    "  PATH: a .syx voice, a bulk dump or a directory of .syx files\n");
+    return 2;
+}
+
+static float blockPeak(const float* L, const float* R, uint32_t n) {
+    float p = 0.f;
+    for (uint32_t i = 0; i < n; ++i) p = std::max(p, std::max(fabsf(L[i]), fabsf(R[i])));
+    return p;
+}
+
+static constexpr float SILENCE = 1.0f / 32768.0f;    // one 16-bit LSB
+static constexpr double MAX_TAIL_S = 10.0;
+
+static double median(std::vector<uint32_t>& v) {
+    if (v.empty()) return 0.0;
+    std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+    return v[v.size() / 2];
+}
+
+// holds notes for holdBlocks, releases them and runs until silent; adds to the profile
+static void play(OfflineEngine& eng, const uint8_t* notes, int count, uint32_t holdBlocks, Profile& p,
+                 std::vector<uint32_t>& synthCycles, std::vector<uint32_t>& fxCycles) {
+    float L[MAX_BLOCK_LEN], R[MAX_BLOCK_LEN];
+    const uint32_t len = eng.blockLen();
+    for (int i = 0; i < count; ++i) eng.synth.noteOn(notes[i], 100);
+    for (uint32_t b = 0; b < holdBlocks; ++b) {
+        eng.render(L, R);
+        p.peak = std::max(p.peak, blockPeak(L, R, len));
+        synthCycles.push_back(eng.synthCycles());
+        fxCycles.push_back(eng.fxCycles());
+    }
+    for (int i = 0; i < count; ++i) eng.synth.noteOff(notes[i]);
+
+    const uint32_t maxBlocks = (uint32_t)(MAX_TAIL_S * eng.sampleRate() / len);
+    const double msPerBlock = 1000.0 * len / eng.sampleRate();
+    uint32_t lastLoud = 0, b = 0;
+    int voiceTail = -1;
+    for (; b < maxBlocks; ++b) {
+        eng.render(L, R);
+        const float pk = blockPeak(L, R, len);
+        p.peak = std::max(p.peak, pk);
+        if (voiceTail < 0 && !eng.synth.activeVoices()) voiceTail = (int)(b * msPerBlock);
+        if (pk >= SILENCE) lastLoud = b + 1;
+        else if (voiceTail >= 0 && b - lastLoud > eng.sampleRate() / len) break;  // 1 s of silence, voices done
+    }
+    p.voiceTailMs = voiceTail;
+    p.tailMs = b < maxBlocks ? (int)(lastLoud * msPerBlock) : -1;
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> paths;
+    const char* outPath = nullptr;
+    uint32_t rate = SAMPLE_RATE, block = DMA_BUFFER_LEN;
+    double hold = 1.0;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool more = i + 1 < argc;
+        if (!strcmp(a, "-o") && more)              outPath = argv[++i];
+        else if (!strcmp(a, "--rate") && more)     rate = atoi(argv[++i]);
+        else if (!strcmp(a, "--block") && more)    block = atoi(argv[++i]);
+        else if (!strcmp(a, "--hold") && more)     hold = atof(argv[++i]);
+        else if (a[0] == '-')                      return usage();
+        else                                       paths.push_back(a);
+    }
+    if (paths.empty() || rate < 8000 || rate > 192000 || hold <= 0.0) return usage();
+
+    std::vector<NamedPatch> patches;
+    for (const char* path : paths) {
+        std::string err;
+        if (!loadPatches(path, patches, err)) {
+            fprintf(stderr, "%s\n", err.c_str());
+            return 1;
+        }
+    }
+
+    static OfflineEngine eng;
+    eng.init(rate, block, MAX_VOICES);
+    const uint32_t holdBlocks = std::max<uint32_t>(1, (uint32_t)(hold * rate / eng.blockLen()));
+    static const uint8_t NOTE[]  = {60};
+    static const uint8_t CHORD[] = {48, 60, 64, 67};
+
+    std::vector<Profile> profiles;
+    for (const auto& np : patches) {
+        Profile p;
+        p.source = np.source;
+        p.name = patchName(np.patch);
+        std::replace(p.name.begin(), p.name.end(), ',', ' ');  // keeps the CSV simple
+        const RDX_Patch& patch = np.patch;
+        p.algorithm = patch.common.algorithm % 12;
+        for (int op = 0; op < 4; ++op) {
+            const RDX_OpParams& o = patch.ops[op];
+            p.carriers += CARRIERS[p.algorithm][op] && o.enable && o.outLevel;
+            p.fbOps += o.enable && o.feedback;
+        }
+
+        eng.setPatch(patch);
+        std::vector<uint32_t> synthCycles, fxCycles;
+        Profile chord;
+        play(eng, NOTE, 1, holdBlocks, p, synthCycles, fxCycles);
+        play(eng, CHORD, 4, holdBlocks, chord, synthCycles, fxCycles);
+        p.peak = std::max(p.peak, chord.peak);
+        p.voiceTailMs = chord.voiceTailMs;
+        p.tailMs = chord.tailMs;
+        p.voiceCycles = median(synthCycles) / VOICES;
+        p.fxCycles = median(fxCycles);
+        profiles.push_back(p);
+    }
+
+    std::vector<uint32_t> costs;
+    for (const auto& p : profiles) costs.push_back((uint32_t)p.voiceCycles);
+    const double typical = std::max(median(costs), 1.0);
+    for (auto& p : profiles) p.rel = p.voiceCycles / typical;
+
+    printf("%u Hz, %u-sample blocks, %d voices stepped, %zu patches\n", rate, eng.blockLen(), VOICES, profiles.size());
+    printf("%-34s %-10s %4s %3s %3s %9s %5s %8s %7s %8s %8s\n",
+           "source", "name", "algo", "car", "fb", "voice_cyc", "rel", "fx_cyc", "peak_db", "vtail_ms", "tail_ms");
+    for (const auto& p : profiles) {
+        std::string src = p.source.size() > 34 ? "..." + p.source.substr(p.source.size() - 31) : p.source;
+        printf("%-34s %-10s %4d %3d %3d %9.0f %5.2f %8.0f %7.1f %8d %8d\n", src.c_str(), p.name.c_str(), p.algorithm,
+               p.carriers, p.fbOps, p.voiceCycles, p.rel, p.fxCycles, 20.f * log10f(std::max(p.peak, 1e-9f)),
+               p.voiceTailMs, p.tailMs);
+    }
+
+    if (outPath) {
+        FILE* f = fopen(outPath, "w");
+        if (!f) {
+            fprintf(stderr, "can't write %s\n", outPath);
+            return 1;
+        }
+        fprintf(f, "# rdx_patchprof, %u Hz, %u-sample blocks, %d voices, cycles = host ns\n", rate, eng.blockLen(), VOICES);
+        fprintf(f, "source,name,algo,carriers,fb_ops,voice_cyc,rel,fx_cyc,peak_db,vtail_ms,tail_ms\n");
+        for (const auto& p : profiles) {
+            fprintf(f, "%s,%s,%d,%d,%d,%.0f,%.2f,%.0f,%.1f,%d,%d\n", p.source.c_str(), p.name.c_str(), p.algorithm,
+                    p.carriers, p.fbOps, p.voiceCycles, p.rel, p.fxCycles, 20.f * log10f(std::max(p.peak, 1e-9f)),
+                    p.voiceTailMs, p.tailMs);
+        }
+        fclose(f);
+    }
+    return 0;
+}
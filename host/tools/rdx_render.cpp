@@ -0,0 +1,202 @@
+// rdx_render.cpp
+
+// =========================================================
+// Offline renderer: a Standard MIDI File played on a reface
+// DX patch, written to a WAV as fast as the CPU goes. With
+// --input, a WAV runs through the patch's FX chain the way
+// the device's AUDIO_INPUT does (the MIDI file is optional).
+//
+//   rdx_render song.mid patch.syx[:N] [-o out.wav] [options]
+//   rdx_render --input in.wav [--mix] [song.mid] patch.syx[:N]
+//
+//   -o FILE       output (default: the MIDI file name, .wav)
+//   --rate HZ     sample rate (SAMPLE_RATE)
+//   --block N     block length, MIN_BLOCK_LEN..MAX_BLOCK_LEN (DMA_BUFFER_LEN)
+//   --voices N    poly voices, 1..MAX_VOICES (MAX_VOICES); 0: as the
+//                 device would estimate them from the FX CPU time
+//   --tail S      longest release/FX tail after the last event (10 s);
+//                 the render stops earlier after 1 s of silence
+//   --float       32-bit float WAV, taken before the 16-bit conversion
+//   --program     follow program/bank changes (patches from data/patches)
+//   --input FILE  PCM16 .wav (mono/stereo) or stereo int16 .raw, played
+//                 once into the FX chain instead of the synth
+//   --mix         with --input: the input is added to the synth
+//   -n            render, but write no file (throughput only)
+//   --trace FILE  write the RDX_Trace ring at the end, for rdx_replay
+//                 (built with -DRDX_TRACE=ON; the ring keeps the
+//                 last RDX_Trace::RECORDS records)
+//
+// Throughput is reported as voice-seconds (voices sounding x
+// audio time) per CPU-second of this process, with the plain
+// realtime factor beside it. Built with -DRDX_PROFILE=ON, the
+// per-stage profile of the whole render follows (stderr).
+// =========================================================
+
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rdx_offline.h"
+
+using namespace rdx_offline;
+
+static double cpuSeconds() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int usage() {
+    fprintf(stderr,
+        "usage: rdx_render song.mid patch.syx[:N] [-o out.wav] [--rate HZ] [--block N]\n"
+        "                  [--voices N] [--tail S] [--float] [--program] [-n] [--trace FILE]\n"
+        "       rdx_render --input in.wav [--mix] [song.mid] patch.syx[:N] [options]\n"
+        "  patch: a voice .syx, voice N of a bulk dump (dump.syx:N) or the Nth .syx of a folder (dir:N)\n");
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    const char* midiPath = nullptr;
+    const char* patchSpec = nullptr;
+    std::string outPath;
+    uint32_t rate = SAMPLE_RATE, block = DMA_BUFFER_LEN;
+    int voices = MAX_VOICES;
+    double tail = 10.0;
+    bool asFloat = false, programs = false, noFile = false;
+    const char* tracePath = nullptr;
+    const char* inputPath = nullptr;
+    bool mix = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool more = i + 1 < argc;
+        if (!strcmp(a, "-o") && more)              outPath = argv[++i];
+        else if (!strcmp(a, "--rate") && more)     rate = atoi(argv[++i]);
+        else if (!strcmp(a, "--block") && more)    block = atoi(argv[++i]);
+        else if (!strcmp(a, "--voices") && more)   voices = atoi(argv[++i]);
+        else if (!strcmp(a, "--tail") && more)     tail = atof(argv[++i]);
+        else if (!strcmp(a, "--float"))            asFloat = true;
+        else if (!strcmp(a, "--program"))          programs = true;
+        else if (!strcmp(a, "-n"))                 noFile = true;
+        else if (!strcmp(a, "--trace") && more)    tracePath = argv[++i];
+        else if (!strcmp(a, "--input") && more)    inputPath = argv[++i];
+        else if (!strcmp(a, "--mix"))              mix = true;
+        else if (a[0] == '-')                      return usage();
+        else if (!midiPath)                        midiPath = a;
+        else if (!patchSpec)                       patchSpec = a;
+        else                                       return usage();
+    }
+    if (inputPath && midiPath && !patchSpec) {     // input and patch only
+        patchSpec = midiPath;
+        midiPath = nullptr;
+    }
+    if (!patchSpec || (!midiPath && !inputPath) || (mix && !inputPath) || rate < 8000 || rate > 192000 || voices < 0 || voices > MAX_VOICES) return usage();
+#ifndef RDX_TRACE
+    if (tracePath) {
+        fprintf(stderr, "--trace: built without RDX_TRACE (cmake -DRDX_TRACE=ON)\n");
+        return 2;
+    }
+#endif
+    if (outPath.empty()) {
+        outPath = midiPath ? midiPath : inputPath;
+        const size_t dot = outPath.rfind('.');
+        if (dot != std::string::npos && outPath.find('/', dot) == std::string::npos) outPath.resize(dot);
+        outPath += midiPath ? ".wav" : ".rdx.wav";     // not over the input
+    }
+
+    std::string err;
+    std::vector<MidiEvent> events;
+    if (midiPath && !loadSmf(midiPath, events, err)) {
+        fprintf(stderr, "%s: %s\n", midiPath, err.c_str());
+        return 1;
+    }
+    RDX_Patch patch;
+    if (!loadPatch(patchSpec, patch, err)) {
+        fprintf(stderr, "%s\n", err.c_str());
+        return 1;
+    }
+
+    static OfflineEngine eng;   // the synth is large, keep it off the stack
+    eng.init(rate, block, voices);
+    eng.followProgramChanges(programs);
+    eng.setPatch(patch);
+    block = eng.blockLen();
+
+    static FileAudioIn input;
+    fs::FS hostFs(nullptr, inputPath && inputPath[0] == '/' ? "" : ".");
+    if (inputPath) {
+        if (!input.open(hostFs, inputPath, rate, false)) {
+            fprintf(stderr, "%s: can't read (PCM16 .wav or stereo int16 .raw)\n", inputPath);
+            return 1;
+        }
+        eng.setInput(&input, mix);
+        RDX_Log::get().drain();
+    }
+
+    WavWriter wav;
+    if (!noFile && !wav.open(outPath.c_str(), rate, asFloat)) {
+        fprintf(stderr, "can't write %s\n", outPath.c_str());
+        return 1;
+    }
+
+    const double blockSec = (double)block / rate;
+    const double inEnd = inputPath ? (double)input.frames() / rate : 0.0;
+    const double end = std::max(inEnd, events.empty() ? 0.0 : events.back().time);
+    const uint64_t silentStop = (uint64_t)rate / block;     // 1 s of silence ends the tail
+    float L[MAX_BLOCK_LEN], R[MAX_BLOCK_LEN];
+    int16_t pcm[MAX_BLOCK_LEN * 2];
+    size_t next = 0;
+    uint64_t blocks = 0, silent = 0;
+
+    const double cpu0 = cpuSeconds();
+    for (;;) {
+        const double t = blocks * blockSec;
+        while (next < events.size() && events[next].time < t + blockSec) eng.dispatch(events[next++]);
+        eng.render(L, R, asFloat ? nullptr : pcm);
+        if (!noFile) {
+            if (asFloat) wav.writeFloat(L, R, block);
+            else wav.writePcm16(pcm, block);
+        }
+        ++blocks;
+        if (next < events.size() || t + blockSec < inEnd) continue;
+
+        float peak = 0.f;
+        for (uint32_t i = 0; i < block; ++i) peak = std::max(peak, std::max(fabsf(L[i]), fabsf(R[i])));
+        silent = (peak < 1.0f / 32768.0f && !eng.synth.activeVoices()) ? silent + 1 : 0;
+        if (silent >= silentStop || t + blockSec >= end + tail) break;
+    }
+    const double cpu = cpuSeconds() - cpu0;
+    wav.close();
+
+    const double audio = blocks * blockSec;
+    const double cpuSafe = std::max(cpu, 1e-9);
+    printf("%s%s%s + %s (%s) @ %u Hz, %u-sample blocks, %d voices%s\n", midiPath ? midiPath : "",
+           midiPath && inputPath ? " + " : "", inputPath ? inputPath : "", patchSpec, patchName(patch).c_str(),
+           rate, block, voices, voices ? "" : " (estimated)");
+    printf("events      %zu\n", events.size());
+    if (inputPath) printf("input       %.3f s, %s\n", inEnd, mix ? "mixed with the synth" : "FX chain only");
+    printf("audio       %.3f s\n", audio);
+    printf("cpu         %.3f s\n", cpu);
+    printf("realtime    %.1fx\n", audio / cpuSafe);
+    printf("throughput  %.1f voice-s/cpu-s sounding (%.3f voice-s), %.1f voice-s/cpu-s stepped\n",
+           eng.voiceSeconds() / cpuSafe, eng.voiceSeconds(), eng.steppedVoiceSeconds() / cpuSafe);
+    if (!noFile) printf("wrote       %s\n", outPath.c_str());
+#ifdef RDX_TRACE
+    if (tracePath) {
+        fs::File f = fs::File::open(tracePath, "w");
+        if (!f) {
+            fprintf(stderr, "can't write %s\n", tracePath);
+            return 1;
+        }
+        printf("trace       %s, %u records\n", tracePath, RDX_Trace::get().write(f, FLUSH_USER));
+    }
+#endif
+#ifdef RDX_PROFILE
+    fflush(stdout);
+    RDX_Profiler::get().log(false);
+#endif
+    return 0;
+}
@@ -0,0 +1,352 @@
+// rdx_replay.cpp
+
+// =========================================================
+// Trace replay: a trace written by the device (RDX_Trace.h,
+// /trace.rdt on LittleFS) or by rdx_render --trace, played
+// back through the engine block by block.
+//
+//   rdx_replay trace.rdt [-o out.wav] [--csv blocks.csv]
+//              [--from quiet|first|SECONDS] [--top N] [--seed N]
+//
+// Replay starts from a patch snapshot: by default the first
+// patch load or quiet keyframe (the voices were reset or
+// silent there, as they are in a fresh engine), --from first
+// takes the first snapshot of any kind, --from SECONDS the
+// first one at or after that device time. From there every
+// MIDI message, SysEx, patch load and FX change is applied
+// before the block it was stamped with, and every block the
+// device rendered is rendered with the VOICES it ran with;
+// blocks the device spent idle are skipped, as it skipped
+// them. The same trace renders the same samples every time.
+//
+// Reported:
+//   device    load (synth + FX cycles over the block's budget)
+//             per block, the xruns among them
+//   host      the same blocks' cost here, as a share of the
+//             block's audio time
+//   match     blocks whose sounding voices differ from the
+//             device's, and later keyframes whose patch or
+//             controls differ from the replayed state (edits
+//             the trace doesn't hold, e.g. from the GUI); the
+//             replay adopts the keyframe and goes on
+//   top N     the device's heaviest blocks (10)
+//
+// --csv writes one line per replayed block, -o the audio.
+// Built with -DRDX_PROFILE=ON, the per-stage profile of the
+// replay follows (stderr).
+// =========================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "rdx_offline.h"
+
+using namespace rdx_offline;
+
+struct TraceEvent {
+    uint32_t sample = 0;
+    uint8_t  type = TRACE_NONE;
+    uint8_t  kind = 0;              // blobs: RDX_TraceBlob
+    uint8_t  reason = 0;            // blobs: RDX_TraceReason
+    std::vector<uint8_t> data;      // payload, blobs reassembled
+};
+
+struct BlockCost {
+    uint32_t sample;
+    uint32_t devSynth, devFx;
+    uint8_t  voices, devActive, hostActive;
+    uint32_t hostSynth, hostFx;
+};
+
+static int usage() {
+    fprintf(stderr, "usage: rdx_replay trace.rdt [-o out.wav] [--csv blocks.csv] [--from quiet|first|SECONDS]\n"
+                    "                  [--top N] [--seed N]\n");
+    return 2;
+}
+
+static uint32_t le32(const uint8_t* p) { return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24; }
+
+// records -> events: blobs joined, a blob cut by the ring's start or a lost record left out
+static void parse(const std::vector<RDX_TraceRecord>& records, std::vector<TraceEvent>& events, uint32_t& partial) {
+    TraceEvent blob;
+    uint32_t want = 0;
+    bool open = false;
+    partial = 0;
+    for (const auto& r : records) {
+        const uint8_t len = std::min<uint8_t>(r.len, sizeof(r.data));
+        if (r.type == TRACE_BLOB) {
+            if (open) ++partial;
+            blob = TraceEvent();
+            blob.sample = r.sample;
+            blob.type = TRACE_BLOB;
+            blob.kind = r.data[0];
+            blob.reason = r.data[1];
+            want = r.data[2] | r.data[3] << 8;
+            open = true;
+        } else if (r.type == TRACE_BLOB_DATA) {
+            if (!open) continue;
+            blob.data.insert(blob.data.end(), r.data, r.data + len);
+        } else {
+            TraceEvent e;
+            e.sample = r.sample;
+            e.type = r.type;
+            e.data.assign(r.data, r.data + len);
+            events.push_back(std::move(e));
+            continue;
+        }
+        if (open && blob.data.size() >= want) {
+            if (blob.data.size() == want) events.push_back(blob);
+            else ++partial;
+            open = false;
+        }
+    }
+    if (open) ++partial;
+
+    // an event stamped with a block's start reached the device before or during that block
+    std::stable_sort(events.begin(), events.end(), [](const TraceEvent& a, const TraceEvent& b) {
+        if (a.sample != b.sample) return a.sample < b.sample;
+        return (a.type == TRACE_BLOCK) < (b.type == TRACE_BLOCK);
+    });
+}
+
+// a blob of that kind; patches and controls of this build's size only
+static bool isBlob(const TraceEvent& e, uint8_t kind) {
+    if (e.type != TRACE_BLOB || e.kind != kind) return false;
+    if (kind == BLOB_PATCH) return e.data.size() == sizeof(RDX_Patch);
+    if (kind == BLOB_CONTROLS) return e.data.size() == sizeof(RDX_Controls);
+    return true;
+}
+
+static void applyControls(OfflineEngine& eng, const TraceEvent& e) {
+    memcpy(&RDX_State::getState().controls, e.data.data(), sizeof(RDX_Controls));
+    eng.synth.calcOutputGain();
+}
+
+static bool sameControls(const RDX_Controls& a, const RDX_Controls& b) {
+    return a.pitchbend == b.pitchbend && a.mainVolume == b.mainVolume && a.modWheel == b.modWheel &&
+           a.sustain == b.sustain && a.portamento == b.portamento && a.portaTimeS == b.portaTimeS;
+}
+
+int main(int argc, char** argv) {
+    const char* tracePath = nullptr;
+    const char* outPath = nullptr;
+    const char* csvPath = nullptr;
+    const char* from = "quiet";
+    int top = 10;
+    long seed = -1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool more = i + 1 < argc;
+        if (!strcmp(a, "-o") && more)              outPath = argv[++i];
+        else if (!strcmp(a, "--csv") && more)      csvPath = argv[++i];
+        else if (!strcmp(a, "--from") && more)     from = argv[++i];
+        else if (!strcmp(a, "--top") && more)      top = atoi(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)     seed = atol(argv[++i]);
+        else if (a[0] == '-')                      return usage();
+        else if (!tracePath)                       tracePath = a;
+        else                                       return usage();
+    }
+    if (!tracePath || top < 0) return usage();
+
+    // ---- file ----
+    std::vector<uint8_t> file;
+    if (!readFile(tracePath, file)) {
+        fprintf(stderr, "can't read %s\n", tracePath);
+        return 1;
+    }
+    RDX_TraceHeader h;
+    if (file.size() < sizeof(h) || memcmp(file.data(), "RDXT", 4)) {
+        fprintf(stderr, "%s: not an RDX trace\n", tracePath);
+        return 1;
+    }
+    memcpy(&h, file.data(), sizeof(h));
+    if (h.version != RDX_TRACE_VERSION || h.recordSize != sizeof(RDX_TraceRecord)) {
+        fprintf(stderr, "%s: trace version %u, this build reads %u\n", tracePath, h.version, RDX_TRACE_VERSION);
+        return 1;
+    }
+    if (h.patchSize != sizeof(RDX_Patch)) {
+        fprintf(stderr, "%s: written by a build with %u-byte patches, this one has %zu\n", tracePath, h.patchSize, sizeof(RDX_Patch));
+        return 1;
+    }
+    if (h.sampleRate < 8000 || h.sampleRate > 192000 || h.blockLen < MIN_BLOCK_LEN || h.blockLen > MAX_BLOCK_LEN) {
+        fprintf(stderr, "%s: %u Hz, %u-sample blocks: not replayable here\n", tracePath, h.sampleRate, h.blockLen);
+        return 1;
+    }
+    const uint32_t count = std::min<uint32_t>(h.records, (file.size() - sizeof(h)) / sizeof(RDX_TraceRecord));
+    std::vector<RDX_TraceRecord> records(count);
+    if (count) memcpy(records.data(), file.data() + sizeof(h), count * sizeof(RDX_TraceRecord));
+
+    std::vector<TraceEvent> events;
+    uint32_t partial = 0;
+    parse(records, events, partial);
+
+    uint32_t nBlocks = 0, nMidi = 0, nSysex = 0, nLoads = 0, nKeys = 0, nFx = 0;
+    for (const auto& e : events) {
+        nBlocks += e.type == TRACE_BLOCK;
+        nMidi += e.type == TRACE_MIDI;
+        nFx += e.type == TRACE_FX;
+        nSysex += isBlob(e, BLOB_SYSEX);
+        nLoads += isBlob(e, BLOB_PATCH) && e.reason == TRACE_LOAD;
+        nKeys += isBlob(e, BLOB_PATCH) && e.reason != TRACE_LOAD;
+    }
+    const double rate = h.sampleRate;
+    printf("%s: %s flush, %u Hz, %u-sample blocks, %u MHz (%u cycles per block)\n", tracePath,
+           h.reason == FLUSH_XRUN ? "xrun" : "user", h.sampleRate, h.blockLen, h.cpuMHz, h.budgetCycles);
+    printf("records     %u: %u blocks, %u MIDI, %u SysEx, %u patch loads, %u keyframes, %u FX", count, nBlocks, nMidi,
+           nSysex, nLoads, nKeys, nFx);
+    if (partial) printf(" (%u partial left out)", partial);
+    printf("\n");
+    if (!events.empty()) printf("span        %.3f - %.3f s\n", events.front().sample / rate, events.back().sample / rate);
+
+    // ---- start ----
+    const bool anySnapshot = !strcmp(from, "first");
+    const bool quietOnly = !strcmp(from, "quiet");
+    const double fromSec = (anySnapshot || quietOnly) ? 0.0 : atof(from);
+    size_t start = events.size();
+    for (size_t i = 0; i + 1 < events.size(); ++i) {
+        const TraceEvent& e = events[i];
+        if (!isBlob(e, BLOB_PATCH) || !isBlob(events[i + 1], BLOB_CONTROLS)) continue;
+        if (quietOnly && e.reason == TRACE_KEYFRAME) continue;
+        if (e.sample / rate < fromSec) continue;
+        start = i;
+        break;
+    }
+    if (start == events.size() && quietOnly) {     // none quiet: the first snapshot will do
+        for (size_t i = 0; i + 1 < events.size(); ++i) {
+            if (isBlob(events[i], BLOB_PATCH) && isBlob(events[i + 1], BLOB_CONTROLS)) { start = i; break; }
+        }
+    }
+    if (start == events.size()) {
+        fprintf(stderr, "%s: no complete patch snapshot to start from\n", tracePath);
+        return 1;
+    }
+
+    // ---- replay ----
+    static OfflineEngine eng;   // the synth is large, keep it off the stack
+    eng.init(h.sampleRate, h.blockLen, MAX_VOICES);
+    if (seed >= 0) resetEngineState((uint32_t)seed);
+    RDX_Patch patch;
+    memcpy(&patch, events[start].data.data(), sizeof(patch));
+    eng.setPatch(patch);
+    applyControls(eng, events[start + 1]);
+    static const char* const REASONS[] = { "patch load", "keyframe", "quiet keyframe" };
+    printf("replay      from %.3f s (%s, %s)\n", events[start].sample / rate,
+           REASONS[std::min<uint8_t>(events[start].reason, 2)], patchName(patch).c_str());
+
+    WavWriter wav;
+    if (outPath && !wav.open(outPath, h.sampleRate, false)) {
+        fprintf(stderr, "can't write %s\n", outPath);
+        return 1;
+    }
+    float L[MAX_BLOCK_LEN], R[MAX_BLOCK_LEN];
+    int16_t pcm[MAX_BLOCK_LEN * 2];
+    std::vector<BlockCost> costs;
+    uint32_t patchResyncs = 0, controlResyncs = 0, activeDiffs = 0;
+
+    for (size_t i = start + 2; i < events.size(); ++i) {
+        const TraceEvent& e = events[i];
+        if (e.type == TRACE_BLOCK) {
+            const uint8_t voices = std::max<uint8_t>(1, std::min<uint8_t>(e.data[8], MAX_VOICES));
+            VOICES = voices;
+            eng.fx.setFixedVoices(voices);
+            eng.render(L, R, pcm);
+            if (outPath) wav.writePcm16(pcm, eng.blockLen());
+            BlockCost c { e.sample, le32(&e.data[0]), le32(&e.data[4]), voices, e.data[9],
+                          (uint8_t)eng.synth.activeVoices(), eng.synthCycles(), eng.fxCycles() };
+            activeDiffs += c.devActive != c.hostActive;
+            costs.push_back(c);
+        } else if (e.type == TRACE_MIDI) {
+            MidiEvent m;
+            m.status = e.data[0];
+            m.d1 = e.data[1];
+            m.d2 = e.data[2];
+            eng.dispatch(m);
+        } else if (e.type == TRACE_FX) {
+            if (e.data[0] == FX_OP_SLOT) eng.fx.configureSlot(e.data[1], (FX_ID)e.data[2], (FxRoute)e.data[3], e.data[4] / 255.f);
+            else eng.fx.setSlotParams(e.data[1], e.data[2], e.data[3]);
+        } else if (isBlob(e, BLOB_SYSEX)) {
+            MidiEvent m;
+            m.status = 0xF0;
+            m.sysex = e.data;
+            eng.dispatch(m);
+        } else if (isBlob(e, BLOB_PATCH)) {
+            memcpy(&patch, e.data.data(), sizeof(patch));
+            if (e.reason == TRACE_LOAD) {
+                eng.setPatch(patch);
+            } else if (memcmp(&patch, &eng.synth.currentPatch(), sizeof(patch))) {
+                ++patchResyncs;
+                eng.synth.currentPatch() = patch;
+                eng.fx.service();
+            }
+        } else if (isBlob(e, BLOB_CONTROLS)) {
+            RDX_Controls ctl;
+            memcpy(&ctl, e.data.data(), sizeof(ctl));
+            if (e.reason == TRACE_LOAD || !sameControls(ctl, RDX_State::getState().controls)) {
+                controlResyncs += e.reason != TRACE_LOAD;
+                applyControls(eng, e);
+            }
+        }
+    }
+    wav.close();
+
+    // ---- report ----
+    const double hostBudget = 1e9 * h.blockLen / rate;     // host cycles are ns
+    const double devBudget = std::max<uint32_t>(h.budgetCycles, 1);
+    auto devLoad = [&](const BlockCost& c) { return ((double)c.devSynth + c.devFx) / devBudget; };
+    auto hostLoad = [&](const BlockCost& c) { return ((double)c.hostSynth + c.hostFx) / hostBudget; };
+    double devSum = 0, devMax = 0, hostSum = 0, hostMax = 0;
+    uint32_t xruns = 0;
+    for (const auto& c : costs) {
+        devSum += devLoad(c);
+        devMax = std::max(devMax, devLoad(c));
+        hostSum += hostLoad(c);
+        hostMax = std::max(hostMax, hostLoad(c));
+        xruns += devLoad(c) > 1.0;
+    }
+    const double n = std::max<size_t>(costs.size(), 1);
+    printf("blocks      %zu replayed, %.3f s of audio\n", costs.size(), costs.size() * h.blockLen / rate);
+    printf("device      load avg %.0f%% max %.0f%%, %u xruns\n", 100 * devSum / n, 100 * devMax, xruns);
+    printf("host        load avg %.1f%% max %.1f%% of %.0f us per block\n", 100 * hostSum / n, 100 * hostMax, hostBudget / 1000);
+    printf("match       sounding voices differ in %u of %zu blocks; keyframes adopted: %u patch, %u controls\n",
+           activeDiffs, costs.size(), patchResyncs, controlResyncs);
+
+    std::vector<const BlockCost*> heavy;
+    for (const auto& c : costs) heavy.push_back(&c);
+    const size_t shown = std::min<size_t>(top, heavy.size());
+    std::partial_sort(heavy.begin(), heavy.begin() + shown, heavy.end(),
+                      [&](const BlockCost* a, const BlockCost* b) { return devLoad(*a) > devLoad(*b); });
+    if (shown) printf("heaviest device blocks:\n%10s %7s %8s %10s %10s %6s %10s %10s %6s\n", "time_s", "voices",
+                      "sounding", "dev_synth", "dev_fx", "dev%", "host_synth", "host_fx", "host%");
+    for (size_t i = 0; i < shown; ++i) {
+        const BlockCost& c = *heavy[i];
+        printf("%10.3f %7u %4u/%-3u %10u %10u %6.0f %10u %10u %6.1f\n", c.sample / rate, c.voices, c.devActive,
+               c.hostActive, c.devSynth, c.devFx, 100 * devLoad(c), c.hostSynth, c.hostFx, 100 * hostLoad(c));
+    }
+
+    if (csvPath) {
+        FILE* f = fopen(csvPath, "w");
+        if (!f) {
+            fprintf(stderr, "can't write %s\n", csvPath);
+            return 1;
+        }
+        fprintf(f, "# rdx_replay %s, %u Hz, %u-sample blocks, device cycles at %u MHz, host cycles = ns\n", tracePath,
+                h.sampleRate, h.blockLen, h.cpuMHz);
+        fprintf(f, "time_s,voices,dev_active,dev_synth,dev_fx,dev_load,host_active,host_synth,host_fx,host_load\n");
+        for (const auto& c : costs) {
+            fprintf(f, "%.6f,%u,%u,%u,%u,%.3f,%u,%u,%u,%.4f\n", c.sample / rate, c.voices, c.devActive, c.devSynth,
+                    c.devFx, devLoad(c), c.hostActive, c.hostSynth, c.hostFx, hostLoad(c));
+        }
+        fclose(f);
+    }
+    if (outPath) printf("wrote       %s\n", outPath);
+#ifdef RDX_PROFILE
+    fflush(stdout);
+    RDX_Profiler::get().log(false);
+#endif
+    return 0;
+}
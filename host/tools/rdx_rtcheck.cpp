@@ -0,0 +1,403 @@
+// rdx_rtcheck.cpp
+
+// =========================================================
+// Real-time safety check of the audio path.
+//
+//   rdx_rtcheck [--scenario NAME] [--blocks N] [--seed N]
+//               [--abort] [--max-reports N]
+//
+// Renders as the audio task does, RDX_Synth::renderAudioBlock
+// then FXHost::process, while the MIDI task's work runs in
+// between blocks (updateCache, FXHost::service, log drain) and
+// a scenario keeps changing things:
+//
+//   notes   note-on/off storm, mod wheel, pitch bend
+//   cc      notes + every controller, 16 per block
+//   patch   notes + a new voice (data/patches, factory dump)
+//           every 8 blocks
+//   fx      notes + patch slot types and parameters through
+//           SysEx parameter changes, extra insert/send slots
+//           through configureSlot, every 4 blocks
+//   all     everything at once (default: each in turn)
+//
+// Inside the two render calls, any of these is a violation:
+//   malloc, calloc, realloc, free, aligned allocations
+//   (new/delete, String and vector growth end up there)
+//   pthread mutex/rwlock/condition waits, sem_wait
+//   open, fopen, read, write, sleeps, sched_yield
+//   ESP_LOGx (the host platform reports its log calls)
+//
+// Each distinct call stack is printed once, with a backtrace,
+// the scenario, stage and block. Named frames need -rdynamic
+// (the target links with it; pipe through c++filt); inlined
+// engine code shows as rdx_rtcheck(+0xOFFSET), which
+// `addr2line -Cfipe rdx_rtcheck 0xOFFSET` resolves. Exit
+// status 1 if anything was found. Glibc only: allocations go
+// to the __libc_* entry points, the rest to the next
+// definition (dlsym RTLD_NEXT).
+// =========================================================
+
+#undef _FORTIFY_SOURCE      // the checked libc calls must be plain functions here
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rdx_offline.h"
+
+using namespace rdx_offline;
+
+// =========================================================
+// Checker
+// =========================================================
+namespace rtcheck {
+
+struct Count {
+    const char* call;
+    uint64_t    n;
+};
+
+static thread_local bool armed = false;
+static thread_local bool busy  = false;     // inside the checker (reporting may allocate)
+static const char* scenario = "";
+static const char* stage    = "";
+static uint32_t    block    = 0;
+static bool        abortOnFirst = false;
+static int         maxReports = 10;
+static int         reports = 0;
+static uint64_t    seen[512];               // stack hashes already printed
+static int         seenCount = 0;
+static Count       counts[32];
+static int         countCount = 0;
+
+static void tally(const char* call) {
+    for (int i = 0; i < countCount; ++i) {
+        if (!strcmp(counts[i].call, call)) { ++counts[i].n; return; }
+    }
+    if (countCount < 32) counts[countCount++] = { call, 1 };
+}
+
+static void hit(const char* call) {
+    if (!armed || busy) return;
+    busy = true;
+    tally(call);
+    void* bt[48];
+    const int n = backtrace(bt, 48);
+    uint64_t h = 1469598103934665603ull;
+    for (int i = 1; i < n; ++i) h = (h ^ (uint64_t)(uintptr_t)bt[i]) * 1099511628211ull;
+    bool known = false;
+    for (int i = 0; i < seenCount && !known; ++i) known = seen[i] == h;
+    if (!known && seenCount < 512) seen[seenCount++] = h;
+    if (!known && reports < maxReports) {
+        ++reports;
+        fprintf(stderr, "\nRT VIOLATION: %s in %s, scenario %s, block %u\n", call, stage, scenario, block);
+        backtrace_symbols_fd(bt + 1, n - 1, STDERR_FILENO);
+    }
+    if (abortOnFirst) abort();
+    busy = false;
+}
+
+static uint64_t total() {
+    uint64_t t = 0;
+    for (int i = 0; i < countCount; ++i) t += counts[i].n;
+    return t;
+}
+
+// the audio task's side of a block: checked
+struct Armed {
+    explicit Armed(const char* s) { stage = s; armed = true; }
+    ~Armed() { armed = false; }
+};
+
+template <class F>
+static inline F next(F& fn, const char* name) {
+    if (!fn) fn = (F)dlsym(RTLD_NEXT, name);    // resolved unarmed: the first call comes from start-up
+    return fn;
+}
+
+} // namespace rtcheck
+
+// =========================================================
+// Interposed calls
+// =========================================================
+extern "C" {
+
+void* __libc_malloc(size_t);
+void* __libc_calloc(size_t, size_t);
+void* __libc_realloc(void*, size_t);
+void* __libc_memalign(size_t, size_t);
+void  __libc_free(void*);
+
+void* malloc(size_t n) noexcept                       { rtcheck::hit("malloc"); return __libc_malloc(n); }
+void* calloc(size_t n, size_t size) noexcept          { rtcheck::hit("calloc"); return __libc_calloc(n, size); }
+void* realloc(void* p, size_t n) noexcept             { rtcheck::hit("realloc"); return __libc_realloc(p, n); }
+void* memalign(size_t a, size_t n) noexcept           { rtcheck::hit("memalign"); return __libc_memalign(a, n); }
+void* aligned_alloc(size_t a, size_t n) noexcept      { rtcheck::hit("aligned_alloc"); return __libc_memalign(a, n); }
+void  free(void* p) noexcept {
+    if (p) rtcheck::hit("free");
+    __libc_free(p);
+}
+int posix_memalign(void** out, size_t a, size_t n) noexcept {
+    rtcheck::hit("posix_memalign");
+    *out = __libc_memalign(a, n);
+    return *out ? 0 : ENOMEM;
+}
+
+int pthread_mutex_lock(pthread_mutex_t* m) noexcept {
+    static int (*fn)(pthread_mutex_t*) = nullptr;
+    rtcheck::hit("pthread_mutex_lock");
+    return rtcheck::next(fn, "pthread_mutex_lock")(m);
+}
+int pthread_rwlock_rdlock(pthread_rwlock_t* l) noexcept {
+    static int (*fn)(pthread_rwlock_t*) = nullptr;
+    rtcheck::hit("pthread_rwlock_rdlock");
+    return rtcheck::next(fn, "pthread_rwlock_rdlock")(l);
+}
+int pthread_rwlock_wrlock(pthread_rwlock_t* l) noexcept {
+    static int (*fn)(pthread_rwlock_t*) = nullptr;
+    rtcheck::hit("pthread_rwlock_wrlock");
+    return rtcheck::next(fn, "pthread_rwlock_wrlock")(l);
+}
+int pthread_cond_wait(pthread_cond_t* c, pthread_mutex_t* m) {
+    static int (*fn)(pthread_cond_t*, pthread_mutex_t*) = nullptr;
+    rtcheck::hit("pthread_cond_wait");
+    return rtcheck::next(fn, "pthread_cond_wait")(c, m);
+}
+int sem_wait(sem_t* s) {
+    static int (*fn)(sem_t*) = nullptr;
+    rtcheck::hit("sem_wait");
+    return rtcheck::next(fn, "sem_wait")(s);
+}
+
+int open(const char* path, int flags, ...) {
+    static int (*fn)(const char*, int, ...) = nullptr;
+    va_list ap;
+    va_start(ap, flags);
+    const mode_t mode = (flags & (O_CREAT | O_TMPFILE)) ? va_arg(ap, mode_t) : 0;
+    va_end(ap);
+    rtcheck::hit("open");
+    return rtcheck::next(fn, "open")(path, flags, mode);
+}
+FILE* fopen(const char* path, const char* mode) {
+    static FILE* (*fn)(const char*, const char*) = nullptr;
+    rtcheck::hit("fopen");
+    return rtcheck::next(fn, "fopen")(path, mode);
+}
+ssize_t read(int fd, void* buf, size_t n) {
+    static ssize_t (*fn)(int, void*, size_t) = nullptr;
+    rtcheck::hit("read");
+    return rtcheck::next(fn, "read")(fd, buf, n);
+}
+ssize_t write(int fd, const void* buf, size_t n) {
+    static ssize_t (*fn)(int, const void*, size_t) = nullptr;
+    rtcheck::hit("write");
+    return rtcheck::next(fn, "write")(fd, buf, n);
+}
+int nanosleep(const struct timespec* t, struct timespec* rem) {
+    static int (*fn)(const struct timespec*, struct timespec*) = nullptr;
+    rtcheck::hit("nanosleep");
+    return rtcheck::next(fn, "nanosleep")(t, rem);
+}
+int clock_nanosleep(clockid_t c, int flags, const struct timespec* t, struct timespec* rem) {
+    static int (*fn)(clockid_t, int, const struct timespec*, struct timespec*) = nullptr;
+    rtcheck::hit("clock_nanosleep");
+    return rtcheck::next(fn, "clock_nanosleep")(c, flags, t, rem);
+}
+int usleep(useconds_t us) {
+    static int (*fn)(useconds_t) = nullptr;
+    rtcheck::hit("usleep");
+    return rtcheck::next(fn, "usleep")(us);
+}
+int sched_yield() noexcept {
+    static int (*fn)() = nullptr;
+    rtcheck::hit("sched_yield");
+    return rtcheck::next(fn, "sched_yield")();
+}
+
+} // extern "C"
+
+// =========================================================
+// Scenarios
+// =========================================================
+enum Scenario : uint8_t { NOTES, CC, PATCH, FX, ALL, SCENARIOS };
+static const char* const SCENARIO_NAMES[SCENARIOS] = { "notes", "cc", "patch", "fx", "all" };
+
+static int usage() {
+    fprintf(stderr, "usage: rdx_rtcheck [--scenario notes|cc|patch|fx|all] [--blocks N] [--seed N]\n"
+                    "                   [--abort] [--max-reports N]\n");
+    return 2;
+}
+
+class Storm {
+public:
+    Storm(OfflineEngine& eng, const std::vector<NamedPatch>& patches, Scenario sc, uint32_t seed)
+        : eng_(eng), patches_(patches), sc_(sc), rng_(seed) {}
+
+    // the MIDI task's side of block b
+    inline void control(uint32_t b) {
+        notes();
+        if (sc_ == CC || sc_ == ALL) controllers();
+        if ((sc_ == PATCH || sc_ == ALL) && b % 8 == 0 && !patches_.empty()) {
+            eng_.setPatch(patches_[patch_++ % patches_.size()].patch);
+        }
+        if ((sc_ == FX || sc_ == ALL) && b % 4 == 0) effects(b);
+    }
+
+private:
+    OfflineEngine& eng_;
+    const std::vector<NamedPatch>& patches_;
+    Scenario sc_;
+    std::mt19937 rng_;
+    size_t patch_ = 0;
+    uint8_t held_[16] = {};
+    int heldCount_ = 0;
+
+    inline uint32_t rnd(uint32_t n) { return rng_() % n; }
+
+    inline void send(uint8_t status, uint8_t d1, uint8_t d2) {
+        MidiEvent e;
+        e.status = status;
+        e.d1 = d1;
+        e.d2 = d2;
+        eng_.dispatch(e);
+    }
+
+    inline void notes() {
+        for (int k = rnd(4); k > 0; --k) {
+            if (heldCount_ < 16 && (rnd(2) || !heldCount_)) {
+                const uint8_t note = 36 + rnd(60);
+                send(0x90, note, 1 + rnd(127));
+                held_[heldCount_++] = note;
+            } else {
+                const int i = rnd(heldCount_);
+                send(0x80, held_[i], 64);
+                held_[i] = held_[--heldCount_];
+            }
+        }
+        if (rnd(4) == 0) send(0xB0, 1, rnd(128));                   // mod wheel
+        if (rnd(2) == 0) {
+            const uint32_t pb = rnd(16384);
+            send(0xE0, pb & 0x7F, pb >> 7);
+        }
+    }
+
+    inline void controllers() {
+        for (int k = 0; k < 16; ++k) {
+            uint8_t cc = rnd(128);
+            if (cc == 7 || cc == 123) cc = 1 + rnd(6);              // an all-notes-off every block only stops the storm
+            send(0xB0, cc, rnd(128));
+        }
+    }
+
+    // patch slots as the editor changes them, extra slots as a host application would
+    inline void effects(uint32_t b) {
+        const uint8_t fx0 = offsetof(RDX_Common, effects);
+        for (int s = 0; s < FX_SLOTS; ++s) {
+            if (rnd(2)) sysexParam(fx0 + s * 3, rnd(FX_CONVOLUTION));   // the Reface's types
+            sysexParam(fx0 + s * 3 + 1, rnd(128));
+            sysexParam(fx0 + s * 3 + 2, rnd(128));
+        }
+        if (b % 16 == 0) {
+            const uint8_t slot = FX_SLOTS + rnd(FX_MAX_SLOTS - FX_SLOTS);
+            eng_.fx.configureSlot(slot, (FX_ID)rnd(FX_COUNT), rnd(2) ? FxRoute::SEND : FxRoute::INSERT, rnd(100) / 100.f);
+            eng_.fx.setSlotParams(slot, rnd(128), rnd(128));
+        }
+        eng_.fx.service();
+    }
+
+    // F0 43 1n 7F 1C 05 30 00 addr value F7: common parameter change
+    inline void sysexParam(uint8_t addr, uint8_t value) {
+        MidiEvent e;
+        e.status = 0xF0;
+        e.sysex = { 0xF0, 0x43, 0x10, 0x7F, 0x1C, 0x05, 0x30, 0x00, addr, value, 0xF7 };
+        eng_.dispatch(e);
+    }
+};
+
+static void run(Scenario sc, const std::vector<NamedPatch>& patches, uint32_t blocks, uint32_t seed) {
+    rtcheck::scenario = SCENARIO_NAMES[sc];
+    resetEngineState(seed);
+    OfflineEngine* eng = new OfflineEngine();
+    eng->init(SAMPLE_RATE, DMA_BUFFER_LEN, MAX_VOICES);
+    eng->setPatch(patches.empty() ? eng->synth.DigiChordPatch() : patches[0].patch);
+    Storm storm(*eng, patches, sc, seed);
+
+    float L[MAX_BLOCK_LEN], R[MAX_BLOCK_LEN];
+    int16_t pcm[MAX_BLOCK_LEN * 2];
+    const uint64_t before = rtcheck::total();
+    for (uint32_t b = 0; b < blocks; ++b) {
+        rtcheck::block = b;
+        storm.control(b);
+        {
+            rtcheck::Armed a("RDX_Synth::renderAudioBlock");
+            eng->synth.renderAudioBlock(L, R, eng->blockLen());
+        }
+        {
+            rtcheck::Armed a("FXHost::process");
+            eng->fx.process(L, R, pcm);
+        }
+        eng->synth.updateCache();
+        eng->fx.service();
+        RDX_Log::get().drain();
+    }
+    delete eng;
+    printf("%-6s %6u blocks  %llu violations\n", SCENARIO_NAMES[sc], blocks, (unsigned long long)(rtcheck::total() - before));
+}
+
+int main(int argc, char** argv) {
+    int only = -1;
+    uint32_t blocks = 3000, seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const bool more = i + 1 < argc;
+        if (!strcmp(a, "--scenario") && more) {
+            const char* name = argv[++i];
+            for (int s = 0; s < SCENARIOS; ++s) if (!strcmp(name, SCENARIO_NAMES[s])) only = s;
+            if (only < 0) return usage();
+        }
+        else if (!strcmp(a, "--blocks") && more)       blocks = atoi(argv[++i]);
+        else if (!strcmp(a, "--seed") && more)         seed = strtoul(argv[++i], nullptr, 0);
+        else if (!strcmp(a, "--abort"))                rtcheck::abortOnFirst = true;
+        else if (!strcmp(a, "--max-reports") && more)  rtcheck::maxReports = atoi(argv[++i]);
+        else                                           return usage();
+    }
+
+    void* warm[4];
+    backtrace(warm, 4);             // loads the unwinder now, not inside the first report
+    rdx_host::rtHook = rtcheck::hit;
+
+    std::vector<NamedPatch> patches;
+    std::string err;
+    if (!loadPatches(RDX_HOST_DATA_DIR "/patches", patches, err) ||
+        !loadPatches(RDX_HOST_DATA_DIR "/dumps/RefaceDX.syx", patches, err)) {
+        fprintf(stderr, "%s\n", err.c_str());
+    }
+
+    for (int s = 0; s < SCENARIOS; ++s) {
+        if (only < 0 || only == s) run((Scenario)s, patches, blocks, seed + s);
+    }
+
+    const uint64_t n = rtcheck::total();
+    if (n) {
+        printf("\n%llu non-real-time calls inside the render, %d distinct stacks:\n", (unsigned long long)n, rtcheck::seenCount);
+        for (int i = 0; i < rtcheck::countCount; ++i) {
+            printf("  %-22s %llu\n", rtcheck::counts[i].call, (unsigned long long)rtcheck::counts[i].n);
+        }
+        return 1;
+    }
+    printf("clean: no allocation, lock, file, sleep or log call inside the render\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+# rdx_telemetry.py
+#
+# =========================================================
+# Polls the synth's SysEx telemetry over USB MIDI (or any
+# MIDI port): a parameter request to 7E 00 00 answers with
+# a block of 32-bit fields, five 7-bit bytes each
+# (RDX_SysEx.h, RDX_TelemetryField).
+#
+#   rdx_telemetry.py                   first port named "reface"
+#   rdx_telemetry.py -p "RDX" -i 0.5   port, poll interval (s)
+#   rdx_telemetry.py --csv > log.csv   one row per reply
+#   rdx_telemetry.py --list            MIDI ports
+#
+# Needs mido with a backend (pip install mido python-rtmidi).
+# =========================================================
+
+import argparse
+import sys
+import time
+
+FIELDS = [
+    "version", "uptime_ms", "budget_us", "block_min_us", "block_avg_us", "block_max_us",
+    "blocks", "xruns", "underruns", "voice_cap", "voices_active", "idle", "cpu_mhz",
+    "fx0_us", "fx1_us", "fx2_us", "fx3_us",
+    "dram_free", "dram_largest", "psram_free", "psram_largest",
+    "midi_avg_us", "midi_max_us",
+]
+
+TELEMETRY = 0x7E
+REQUEST = [0x43, 0x30, 0x7F, 0x1C, 0x05, TELEMETRY, 0x00, 0x00]   # mido: without F0/F7
+
+
+def decode(data):
+    """SysEx data (without F0/F7) -> dict, None if it isn't a telemetry reply"""
+    # 43 0n 7F 1C <count MSB> <count LSB> 05 7E 00 00 <fields> <checksum>
+    if len(data) < 11 or data[0] != 0x43 or data[2:4] != (0x7F, 0x1C) or data[6:8] != (0x05, TELEMETRY):
+        return None
+    body = data[6:-1]
+    if (sum(body) + data[-1]) & 0x7F:
+        print("telemetry: checksum mismatch", file=sys.stderr)
+        return None
+    raw = data[10:-1]
+    values = [sum(raw[f * 5 + b] << (7 * b) for b in range(5)) & 0xFFFFFFFF for f in range(len(raw) // 5)]
+    names = FIELDS + ["field%d" % f for f in range(len(FIELDS), len(values))]
+    return dict(zip(names, values))
+
+
+def line(t):
+    budget = t["budget_us"] or 1
+    fx = " ".join("%d" % t["fx%d_us" % s] for s in range(4))
+    return ("up %6.0f s  block %4d/%4d/%4d us (%3d%% max of %d)  xruns %d  underruns %d  "
+            "voices %d/%d%s  fx us %s  dram %d (%d)  psram %d (%d)%s") % (
+        t["uptime_ms"] / 1000, t["block_min_us"], t["block_avg_us"], t["block_max_us"],
+        100 * t["block_max_us"] // budget, t["budget_us"], t["xruns"], t["underruns"],
+        t["voices_active"], t["voice_cap"], " idle" if t["idle"] else "", fx,
+        t["dram_free"], t["dram_largest"], t["psram_free"], t["psram_largest"],
+        "  midi %d/%d us" % (t["midi_avg_us"], t["midi_max_us"]) if "midi_max_us" in t else "")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Poll RDX performance telemetry over MIDI SysEx")
+    ap.add_argument("-p", "--port", default="reface", help="part of the MIDI port name (default: reface)")
+    ap.add_argument("-i", "--interval", type=float, default=1.0, help="seconds between polls")
+    ap.add_argument("-n", "--count", type=int, default=0, help="stop after N replies (0: never)")
+    ap.add_argument("--csv", action="store_true", help="CSV rows instead of text lines")
+    ap.add_argument("--list", action="store_true", help="list MIDI ports and exit")
+    args = ap.parse_args()
+
+    import mido
+    if args.list:
+        print("in: ", mido.get_input_names())
+        print("out:", mido.get_output_names())
+        return 0
+
+    def find(names):
+        match = [n for n in names if args.port.lower() in n.lower()]
+        if not match:
+            sys.exit("no MIDI port matching '%s' (--list)" % args.port)
+        return match[0]
+
+    with mido.open_input(find(mido.get_input_names())) as inp, mido.open_output(find(mido.get_output_names())) as out:
+        request = mido.Message("sysex", data=REQUEST)
+        header = False
+        got = 0
+        while not args.count or got < args.count:
+            out.send(request)
+            deadline = time.time() + max(args.interval, 0.2)
+            t = None
+            while time.time() < deadline:
+                msg = inp.poll()
+                if msg is None:
+                    time.sleep(0.005)
+                    continue
+                if msg.type == "sysex" and t is None:
+                    t = decode(tuple(msg.data))
+            if t is None:
+                print("telemetry: no reply", file=sys.stderr)
+                continue
+            got += 1
+            if args.csv:
+                if not header:
+                    print(",".join(t.keys()))
+                    header = True
+                print(",".join(str(v) for v in t.values()), flush=True)
+            else:
+                print(line(t), flush=True)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())